@@ -16,7 +16,10 @@
 
 #include "core/menumanager.hpp"
 #include "core/applicationactions.hpp"
+#include "core/knownhoststorage.hpp"
 #include "application.hpp"
+#include "dedicatedserver.hpp"
+#include "importer.hpp"
 #include "features.hpp"
 
 // Needed to register Gobby resource explicitly:
@@ -29,10 +32,15 @@ extern "C" {
 
 #include "util/i18n.hpp"
 #include "util/file.hpp"
+#include "util/recordwriter.hpp"
+#include "util/startupprofile.hpp"
 
 #include <gtkmm/icontheme.h>
 #include <gtkmm/builder.h>
 
+#include <glibmm/main.h>
+#include <glibmm/miscutils.h>
+
 #include <iostream>
 
 #include <libinfinity/common/inf-init.h>
@@ -64,6 +72,16 @@ namespace
 		return GOBBY_LOCALEDIR;
 #endif
 	}
+
+	// Placed between the members of Application::Data to record how
+	// long the construction of each of them takes.
+	struct StartupMark
+	{
+		StartupMark(const char* phase)
+		{
+			Gobby::startup_profile_mark(phase);
+		}
+	};
 }
 
 class Gobby::Application::Data
@@ -74,13 +92,30 @@ public:
 	// TODO: Does the config object really need to stay around, or can
 	// it be thrown away after we have loaded the preferences?
 	Config config;
+	StartupMark config_mark;
+	StateStore state_store;
+	StartupMark state_store_mark;
 	FileChooser file_chooser;
 	Preferences preferences;
+	StartupMark preferences_mark;
 	CertificateManager certificate_manager;
+	StartupMark certificate_manager_mark;
+
+	// Shared by all windows
+	ConnectionManager connection_manager;
+	BrowserStore browser_store;
+	DocumentInfoStorage info_storage;
+	KnownHostStorage host_storage;
+	SessionUsers session_users;
+	SessionCache session_cache;
+	RecordWriter record_writer;
+	StartupMark connections_mark;
+
 	GtkSourceLanguageManager* language_manager;
 
 	ApplicationActions application_actions;
 	MenuManager menu_manager;
+	StartupMark menu_manager_mark;
 
 	ApplicationCommands m_application_commands;
 	HelpCommands m_help_commands;
@@ -88,11 +123,26 @@ public:
 
 Gobby::Application::Data::Data(Gobby::Application& application):
 	config(config_filename("config.xml")),
+	config_mark("config"),
+	state_store(config_filename("state")),
+	state_store_mark("state store"),
 	preferences(config),
+	preferences_mark("preferences"),
 	certificate_manager(preferences),
+	certificate_manager_mark("certificate manager"),
+	connection_manager(certificate_manager, preferences),
+	browser_store(connection_manager, state_store),
+	info_storage(INF_GTK_BROWSER_MODEL(browser_store.get_store()),
+	             state_store),
+	host_storage(browser_store, state_store),
+	session_cache(preferences),
+	record_writer(Glib::build_filename(Glib::get_home_dir(),
+	                                   ".infinote-records")),
+	connections_mark("connections"),
 	language_manager(gtk_source_language_manager_get_default()),
 	application_actions(application),
 	menu_manager(language_manager),
+	menu_manager_mark("menus"),
 	m_application_commands(application, application_actions,
 	                       file_chooser, preferences,
 	                       certificate_manager),
@@ -105,7 +155,8 @@ Gobby::Application::Data::Data(Gobby::Application& application):
 
 Gobby::Application::Application():
 	Gtk::Application("de._0x539.gobby",
-	                 Gio::APPLICATION_HANDLES_OPEN)
+	                 Gio::APPLICATION_HANDLES_OPEN),
+	m_gobby_window(NULL)
 {
 	setlocale(LC_ALL, "");
 	bindtextdomain(GETTEXT_PACKAGE, gobby_localedir().c_str());
@@ -133,6 +184,21 @@ Gobby::Application::Application():
 		}, { "new-instance", 'n', 0, G_OPTION_ARG_NONE, NULL,
 		  _("Start a new gobby instance also if there is one "
 		     "already running"), NULL
+		}, { "new-window", 'w', 0, G_OPTION_ARG_NONE, NULL,
+		  _("Open a new window in the running gobby instance"),
+		  NULL
+		}, { "serve", 0, 0, G_OPTION_ARG_NONE, NULL,
+		  _("Host the local documents without opening a window"),
+		  NULL
+		}, { "import", 0, 0, G_OPTION_ARG_FILENAME, NULL,
+		  _("Copy the files in DIRECTORY to the server directory "
+		    "given with --import-to, and exit"),
+		  _("DIRECTORY")
+		}, { "import-to", 0, 0, G_OPTION_ARG_STRING, NULL,
+		  _("Server directory to import files into"),
+		  _("URI")
+		}, { "profile-startup", 0, 0, G_OPTION_ARG_NONE, NULL,
+		  _("Print how long the phases of the startup take"), NULL
 		/*}, { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY,
 		     NULL, NULL, N_("[FILE1 or URI1] [FILE2 or URI2] [...]")
 		*/}, { NULL }
@@ -141,6 +207,16 @@ Gobby::Application::Application():
 	g_application_add_main_option_entries(G_APPLICATION(gobj()), entries);
 }
 
+Gobby::Application::~Application()
+{
+	// The windows need to go before the shared data they refer to
+	for(WindowList::iterator iter = m_secondary_windows.begin();
+	    iter != m_secondary_windows.end(); ++iter)
+	{
+		delete *iter;
+	}
+}
+
 Glib::RefPtr<Gobby::Application> Gobby::Application::create()
 {
 	return Glib::RefPtr<Gobby::Application>(
@@ -157,6 +233,24 @@ int Gobby::Application::on_handle_local_options(
 		return 0;
 	}
 
+	bool serve;
+	if(options_dict->lookup_value("serve", serve))
+		return run_dedicated_server();
+
+	std::string import_directory;
+	if(options_dict->lookup_value("import", import_directory))
+	{
+		Glib::ustring import_target;
+		if(!options_dict->lookup_value("import-to", import_target))
+		{
+			std::cerr << _("--import requires --import-to")
+			          << std::endl;
+			return 1;
+		}
+
+		return run_import(import_directory, import_target);
+	}
+
 	bool new_instance;
 	if(options_dict->lookup_value("new-instance", new_instance))
 	{
@@ -164,10 +258,91 @@ int Gobby::Application::on_handle_local_options(
 		options_dict->remove("new-instance");
 	}
 
+	bool new_window;
+	if(options_dict->lookup_value("new-window", new_window))
+	{
+		// If there is an instance running already, then let it
+		// open the window. Otherwise we are the first instance, and
+		// open a window anyway.
+		register_application();
+		if(is_remote())
+		{
+			activate_action("new-window");
+			return 0;
+		}
+
+		options_dict->remove("new-window");
+	}
+
+	bool profile_startup;
+	if(options_dict->lookup_value("profile-startup", profile_startup))
+	{
+		startup_profile_enable();
+		options_dict->remove("profile-startup");
+	}
+
 	// Continue normal processing
 	return -1;
 }
 
+int Gobby::Application::run_dedicated_server()
+{
+	// This runs instead of the regular startup, so GTK+ is never
+	// initialized and the application is not registered. That also
+	// means that any number of servers can run side by side with
+	// a regular instance, as long as they use different ports.
+	try
+	{
+		GError* error = NULL;
+		if(inf_init(&error) != TRUE)
+			throw Glib::Error(error);
+
+		DedicatedServer server;
+		server.run();
+	}
+	catch(const Glib::Exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+int Gobby::Application::run_import(const std::string& directory,
+                                   const std::string& target)
+{
+	// Like the dedicated server, this runs instead of the regular
+	// startup.
+	try
+	{
+		GError* error = NULL;
+		if(inf_init(&error) != TRUE)
+			throw Glib::Error(error);
+
+		Importer importer(directory, target);
+		if(!importer.run())
+			return 1;
+	}
+	catch(const Glib::Exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
 void Gobby::Application::on_startup()
 {
 	Gtk::Application::on_startup();
@@ -183,6 +358,7 @@ void Gobby::Application::on_startup()
 		GError* error = NULL;
 		if(inf_init(&error) != TRUE)
 			throw Glib::Error(error);
+		startup_profile_mark("libinfinity");
 
 		Gtk::IconTheme::get_default()->append_search_path(
 			PUBLIC_ICONS_DIR);
@@ -197,14 +373,21 @@ void Gobby::Application::on_startup()
 		set_app_menu(m_data->menu_manager.get_app_menu());
 		set_menubar(m_data->menu_manager.get_menu());
 
-		m_gobby_window = new Gobby::Window(
-			m_data->config, m_data->language_manager,
-			m_data->file_chooser, m_data->preferences,
-			m_data->certificate_manager);
+		m_gobby_window = create_window(true);
+		startup_profile_mark("window");
 
 		m_window.reset(m_gobby_window);
 		add_window(*m_gobby_window);
 
+		m_first_draw_connection = m_gobby_window->signal_draw().connect(
+			sigc::mem_fun(*this, &Application::on_first_draw));
+		m_gobby_window->signal_hide().connect(sigc::mem_fun(
+			*this, &Application::on_primary_window_hide));
+
+		m_data->application_actions.new_window->signal_activate().
+			connect(sigc::hide(sigc::mem_fun(
+				*this, &Application::on_new_window)));
+
 		m_window->show();
 	}
 	catch(const Glib::Exception& ex)
@@ -217,6 +400,110 @@ void Gobby::Application::on_startup()
 	}
 }
 
+bool Gobby::Application::on_first_draw(
+	const Cairo::RefPtr<Cairo::Context>& cr)
+{
+	startup_profile_mark("first frame");
+	m_first_draw_connection.disconnect();
+
+	// Now that the window is on screen, do the initialization that is
+	// not required to show it.
+	Glib::signal_idle().connect(
+		sigc::mem_fun(*this, &Application::on_startup_idle));
+
+	return false;
+}
+
+bool Gobby::Application::on_startup_idle()
+{
+	m_data->menu_manager.load_languages();
+	startup_profile_mark("language menu");
+
+	m_data->host_storage.load();
+	startup_profile_mark("known hosts");
+
+	m_gobby_window->restore_session();
+	startup_profile_mark("session restore");
+
+	// The certificates are loaded in the background, and might not be
+	// available yet. Wait for them, so that the report includes them.
+	if(m_data->certificate_manager.is_loaded())
+	{
+		startup_profile_report();
+	}
+	else
+	{
+		m_certificates_loaded_connection = m_data->
+			certificate_manager.signal_credentials_changed().
+			connect(sigc::mem_fun(
+				*this, &Application::on_certificates_loaded));
+	}
+
+	return false;
+}
+
+void Gobby::Application::on_certificates_loaded()
+{
+	m_certificates_loaded_connection.disconnect();
+	startup_profile_report();
+}
+
+Gobby::Window* Gobby::Application::create_window(bool primary)
+{
+	return new Gobby::Window(
+		m_data->config, m_data->state_store,
+		m_data->language_manager,
+		m_data->file_chooser, m_data->preferences,
+		m_data->certificate_manager,
+		m_data->connection_manager, m_data->browser_store,
+		m_data->info_storage, m_data->session_users,
+		m_data->session_cache, m_data->record_writer, primary);
+}
+
+void Gobby::Application::on_new_window()
+{
+	if(!m_gobby_window) return;
+
+	Window* window = create_window(false);
+	m_secondary_windows.push_back(window);
+
+	window->signal_hide().connect(sigc::bind(
+		sigc::mem_fun(*this, &Application::on_secondary_window_hide),
+		window));
+
+	add_window(*window);
+	window->show();
+}
+
+void Gobby::Application::on_primary_window_hide()
+{
+	// The primary window hosts the local documents, and shows the
+	// dialogs for all windows, such as the ones asking for passwords
+	// or certificates. So closing it closes all other windows as well,
+	// which quits the application.
+	WindowList windows = m_secondary_windows;
+	for(WindowList::iterator iter = windows.begin();
+	    iter != windows.end(); ++iter)
+	{
+		(*iter)->hide();
+	}
+}
+
+void Gobby::Application::on_secondary_window_hide(Window* window)
+{
+	// Don't delete the window from within its own signal handler
+	Glib::signal_idle().connect(sigc::bind_return(sigc::bind(
+		sigc::mem_fun(
+			*this, &Application::delete_secondary_window),
+		window), false));
+}
+
+void Gobby::Application::delete_secondary_window(Window* window)
+{
+	m_secondary_windows.remove(window);
+	delete window;
+}
+
 void Gobby::Application::on_activate()
 {
 	Gtk::Application::on_activate();
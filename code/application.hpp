@@ -21,6 +21,8 @@
 
 #include <gtkmm/application.h>
 
+#include <list>
+
 namespace Gobby
 {
 
@@ -28,16 +30,30 @@ class Application: public Gtk::Application
 {
 public:
 	static Glib::RefPtr<Application> create();
+	~Application();
 
 protected:
 	int on_handle_local_options(
 		const Glib::RefPtr<Glib::VariantDict>& options_dict);
+	int run_dedicated_server();
+	int run_import(const std::string& directory,
+	               const std::string& target);
 	virtual void on_startup();
 
 	virtual void on_activate();
 	virtual void on_open(const type_vec_files& files,
 	                     const Glib::ustring& hint);
 
+	bool on_first_draw(const Cairo::RefPtr<Cairo::Context>& cr);
+	bool on_startup_idle();
+	void on_certificates_loaded();
+
+	Window* create_window(bool primary);
+	void on_new_window();
+	void on_primary_window_hide();
+	void on_secondary_window_hide(Window* window);
+	void delete_secondary_window(Window* window);
+
 	void handle_error(const std::string& message);
 
 	class Data;
@@ -46,6 +62,16 @@ protected:
 	Application();
 	std::unique_ptr<Gtk::Window> m_window;
 	Gobby::Window* m_gobby_window;
+
+	// Additional windows opened with app.new-window. They are deleted
+	// when closed. The primary window stays around as long as the
+	// application runs, since it hosts the local documents, and closing
+	// it closes the secondary windows as well.
+	typedef std::list<Window*> WindowList;
+	WindowList m_secondary_windows;
+
+	sigc::connection m_first_draw_connection;
+	sigc::connection m_certificates_loaded_connection;
 };
 
 }
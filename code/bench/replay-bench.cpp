@@ -0,0 +1,418 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Replays session records, as written with the record-session option, and
+// measures how fast the operations in them are applied to the local buffer.
+// This exercises the same code path as remote edits arriving over the
+// network: transformation in InfAdoptedAlgorithm, followed by the buffer
+// modification through InfTextGtkBuffer, optionally with a GtkSourceBuffer
+// and syntax highlighting on top, or through GobbyTextBuffer, which Gobby
+// uses for all text documents. Records that end early, such as the ones
+// cut off at the size limit by older versions of Gobby, are replayed up to
+// where they end.
+//
+// Usage: gobby-replay-bench [--mode=MODE] [--language=ID]
+//                           [--iterations=N] RECORD...
+
+#include "core/gobject/gobby-text-buffer.h"
+
+#include <libinftextgtk/inf-text-gtk-buffer.h>
+#include <libinftext/inf-text-session.h>
+#include <libinftext/inf-text-default-buffer.h>
+#include <libinfinity/adopted/inf-adopted-session-replay.h>
+#include <libinfinity/client/infc-note-plugin.h>
+#include <libinfinity/common/inf-init.h>
+
+#include <gtksourceview/gtksource.h>
+
+#ifndef G_OS_WIN32
+# include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	enum BufferMode
+	{
+		// InfTextDefaultBuffer; no GTK+ involved at all
+		MODE_DEFAULT,
+		// InfTextGtkBuffer on top of a plain GtkTextBuffer
+		MODE_TEXT,
+		// InfTextGtkBuffer on top of a GtkSourceBuffer
+		MODE_SOURCE,
+		// GobbyTextBuffer that is not shown, as for documents that
+		// are only hosted or kept subscribed in the background
+		MODE_HIDDEN,
+		// GobbyTextBuffer that is shown, as for open documents
+		MODE_SHOWN
+	};
+
+	BufferMode buffer_mode = MODE_SOURCE;
+	GtkSourceLanguage* source_language = NULL;
+
+	InfTextBuffer*
+	make_buffer(InfUserTable* user_table)
+	{
+		if(buffer_mode == MODE_DEFAULT)
+			return INF_TEXT_BUFFER(
+				inf_text_default_buffer_new("UTF-8"));
+
+		if(buffer_mode == MODE_HIDDEN || buffer_mode == MODE_SHOWN)
+		{
+			GobbyTextBuffer* buffer =
+				gobby_text_buffer_new(user_table);
+
+			// The GTK+ buffer stays around until the buffer
+			// is disposed.
+			if(buffer_mode == MODE_SHOWN)
+			{
+				InfTextGtkBuffer* gtk_buffer =
+					gobby_text_buffer_acquire_gtk_buffer(
+						buffer);
+				GtkTextBuffer* textbuffer =
+					inf_text_gtk_buffer_get_text_buffer(
+						gtk_buffer);
+				gtk_source_buffer_set_language(
+					GTK_SOURCE_BUFFER(textbuffer),
+					source_language);
+			}
+
+			return INF_TEXT_BUFFER(buffer);
+		}
+
+		GtkTextBuffer* textbuffer;
+		if(buffer_mode == MODE_SOURCE)
+		{
+			GtkSourceBuffer* source_buffer =
+				gtk_source_buffer_new(NULL);
+			gtk_source_buffer_set_language(
+				source_buffer, source_language);
+			textbuffer = GTK_TEXT_BUFFER(source_buffer);
+		}
+		else
+		{
+			textbuffer = gtk_text_buffer_new(NULL);
+		}
+
+		InfTextGtkBuffer* buffer =
+			inf_text_gtk_buffer_new(textbuffer, user_table);
+
+		g_object_unref(textbuffer);
+		return INF_TEXT_BUFFER(buffer);
+	}
+
+	InfSession*
+	text_session_new(InfIo* io, InfCommunicationManager* manager,
+	                 InfSessionStatus status,
+	                 InfCommunicationGroup* sync_group,
+	                 InfXmlConnection* sync_connection,
+	                 const gchar* path,
+	                 gpointer user_data)
+	{
+		InfUserTable* user_table = inf_user_table_new();
+		InfTextBuffer* buffer = make_buffer(user_table);
+
+		InfTextSession* session =
+			inf_text_session_new_with_user_table(
+				manager, buffer, io, user_table, status,
+				sync_group, sync_connection);
+
+		g_object_unref(buffer);
+		g_object_unref(user_table);
+
+		return INF_SESSION(session);
+	}
+
+	const InfcNotePlugin REPLAY_PLUGIN =
+	{
+		NULL,
+		"InfText",
+		text_session_new
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct Result
+	{
+		Result(): n_steps(0), total(0.0) {}
+
+		unsigned long n_steps;
+		// Total time spent applying steps, in seconds
+		double total;
+		// Time for every single step, in microseconds
+		std::vector<double> latencies;
+	};
+
+	enum ReplayStatus
+	{
+		// All steps of the record have been played
+		REPLAY_COMPLETE,
+		// The record ends early; the steps up to there have been
+		// played, and error says where it ends.
+		REPLAY_INCOMPLETE,
+		// The record could not be loaded at all
+		REPLAY_FAILED
+	};
+
+	// Plays all steps of the given record, one by one. Work that the
+	// buffer defers to the main loop, such as syntax highlighting, is
+	// accounted to the step that caused it.
+	ReplayStatus replay_record(const char* filename, Result& result,
+	                           GError** error)
+	{
+		InfAdoptedSessionReplay* replay =
+			inf_adopted_session_replay_new();
+
+		// This performs the initial synchronization, which is not
+		// measured.
+		if(!inf_adopted_session_replay_set_record(
+			replay, filename, &REPLAY_PLUGIN, error))
+		{
+			g_object_unref(replay);
+			return REPLAY_FAILED;
+		}
+
+		while(g_main_context_iteration(NULL, FALSE)) {}
+
+		for(;;)
+		{
+			const Clock::time_point begin = Clock::now();
+
+			if(!inf_adopted_session_replay_play_next(replay, error))
+				break;
+			while(g_main_context_iteration(NULL, FALSE)) {}
+
+			const std::chrono::duration<double, std::micro>
+				duration = Clock::now() - begin;
+
+			++result.n_steps;
+			result.total += duration.count() / 1e6;
+			result.latencies.push_back(duration.count());
+		}
+
+		g_object_unref(replay);
+		return *error == NULL ? REPLAY_COMPLETE : REPLAY_INCOMPLETE;
+	}
+
+	// Expects latencies to be sorted
+	double percentile(const std::vector<double>& latencies, double p)
+	{
+		if(latencies.empty()) return 0.0;
+
+		std::vector<double>::size_type index =
+			static_cast<std::vector<double>::size_type>(
+				p / 100.0 * latencies.size());
+		if(index >= latencies.size()) index = latencies.size() - 1;
+		return latencies[index];
+	}
+
+	// Peak resident set size of the process in KiB, or 0 if unknown
+	long peak_memory()
+	{
+#ifdef G_OS_WIN32
+		return 0;
+#else
+		struct rusage usage;
+		if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+		// Reported in bytes on OS X, and in KiB elsewhere
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+#endif
+	}
+
+	void print_result(const std::string& name, Result& result)
+	{
+		std::sort(result.latencies.begin(), result.latencies.end());
+
+		const double ops_per_sec = result.total > 0.0 ?
+			result.n_steps / result.total : 0.0;
+
+		std::cout << std::fixed << std::setprecision(1)
+		          << name << ": " << result.n_steps << " steps in "
+		          << std::setprecision(3) << result.total << " s, "
+		          << std::setprecision(0) << ops_per_sec << " ops/s"
+		          << std::endl
+		          << std::setprecision(1)
+		          << "  latency (us): p50 "
+		          << percentile(result.latencies, 50.0)
+		          << ", p90 " << percentile(result.latencies, 90.0)
+		          << ", p99 " << percentile(result.latencies, 99.0)
+		          << ", p99.9 " << percentile(result.latencies, 99.9)
+		          << ", max "
+		          << (result.latencies.empty() ?
+		              0.0 : result.latencies.back())
+		          << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	gchar* mode = NULL;
+	gchar* language = NULL;
+	gint iterations = 1;
+	gchar** records = NULL;
+
+	const GOptionEntry entries[] = {
+		{ "mode", 'm', 0, G_OPTION_ARG_STRING, &mode,
+		  "Buffer to replay into: \"default\", \"text\", "
+		  "\"source\" (default), \"hidden\" or \"shown\"",
+		  "MODE"
+		}, { "language", 'l', 0, G_OPTION_ARG_STRING, &language,
+		  "GtkSourceView language to highlight with in source "
+		  "and shown mode", "ID"
+		}, { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+		  "Number of times to replay each record", "N"
+		}, { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY,
+		  &records, NULL, "RECORD..."
+		}, { NULL }
+	};
+
+	GOptionContext* context = g_option_context_new(
+		"- replay session records and measure throughput");
+	g_option_context_add_main_entries(context, entries, NULL);
+
+	GError* error = NULL;
+	if(!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		std::cerr << error->message << std::endl;
+		g_error_free(error);
+		g_option_context_free(context);
+		return 1;
+	}
+
+	g_option_context_free(context);
+
+	if(records == NULL || iterations < 1)
+	{
+		std::cerr << "Usage: " << argv[0] << " [--mode=MODE] "
+		          << "[--language=ID] [--iterations=N] RECORD..."
+		          << std::endl;
+		return 1;
+	}
+
+	if(mode == NULL || std::strcmp(mode, "source") == 0)
+		buffer_mode = MODE_SOURCE;
+	else if(std::strcmp(mode, "text") == 0)
+		buffer_mode = MODE_TEXT;
+	else if(std::strcmp(mode, "default") == 0)
+		buffer_mode = MODE_DEFAULT;
+	else if(std::strcmp(mode, "hidden") == 0)
+		buffer_mode = MODE_HIDDEN;
+	else if(std::strcmp(mode, "shown") == 0)
+		buffer_mode = MODE_SHOWN;
+	else
+	{
+		std::cerr << "Unknown mode \"" << mode << "\"" << std::endl;
+		return 1;
+	}
+
+	if(language != NULL)
+	{
+		source_language = gtk_source_language_manager_get_language(
+			gtk_source_language_manager_get_default(), language);
+		if(source_language == NULL)
+		{
+			std::cerr << "Unknown language \"" << language << "\""
+			          << std::endl;
+			return 1;
+		}
+	}
+
+	if(!inf_init(&error))
+	{
+		std::cerr << error->message << std::endl;
+		g_error_free(error);
+		return 1;
+	}
+
+	int exit_code = 0;
+	Result total;
+
+	for(gchar** record = records; *record != NULL; ++record)
+	{
+		Result result;
+		bool failed = false;
+
+		for(gint i = 0; i < iterations && !failed; ++i)
+		{
+			const unsigned long n_steps = result.n_steps;
+
+			switch(replay_record(*record, result, &error))
+			{
+			case REPLAY_COMPLETE:
+				break;
+			case REPLAY_INCOMPLETE:
+				// Every iteration ends at the same place
+				if(i == 0)
+				{
+					std::cerr << *record << ": record is "
+					          << "incomplete, replaying "
+					          << "the first "
+					          << result.n_steps - n_steps
+					          << " steps only: "
+					          << error->message
+					          << std::endl;
+				}
+
+				g_error_free(error);
+				error = NULL;
+				break;
+			case REPLAY_FAILED:
+				std::cerr << *record << ": " << error->message
+				          << "; skipping" << std::endl;
+				g_error_free(error);
+				error = NULL;
+				exit_code = 1;
+				failed = true;
+				break;
+			}
+		}
+
+		if(failed) continue;
+
+		total.n_steps += result.n_steps;
+		total.total += result.total;
+		total.latencies.insert(total.latencies.end(),
+		                       result.latencies.begin(),
+		                       result.latencies.end());
+
+		print_result(*record, result);
+	}
+
+	if(records[0] != NULL && records[1] != NULL)
+		print_result("total", total);
+
+	// Only meaningful when comparing runs with the same records, since
+	// it includes the memory needed to parse them.
+	std::cout << "peak memory: " << peak_memory() << " KiB" << std::endl;
+
+	inf_deinit();
+
+	g_strfreev(records);
+	g_free(language);
+	g_free(mode);
+	return exit_code;
+}
@@ -16,6 +16,7 @@
 
 #include "commands/auth-commands.hpp"
 #include "util/i18n.hpp"
+#include "util/password.hpp"
 
 #include <libinfinity/common/inf-xmpp-connection.h>
 #include <libinfinity/common/inf-error.h>
@@ -141,8 +142,6 @@ void Gobby::AuthCommands::sasl_callback(InfSaslContextSession* session,
 	const Glib::ustring username = m_preferences.user.name;
 	const std::string correct_password = m_preferences.user.password;
 	const char* password;
-	gsize password_len;
-	gchar cmp;
 
 	switch(prop)
 	{
@@ -226,21 +225,7 @@ void Gobby::AuthCommands::sasl_callback(InfSaslContextSession* session,
 		password = inf_sasl_context_session_get_property(
 			session, GSASL_PASSWORD);
 
-		/* length-independent string compare */
-		cmp = 0;
-		password_len = strlen(password);
-		for(unsigned i = 0; i < correct_password.size(); ++i)
-		{
-			if(i < password_len)
-				cmp |= (password[i] ^ correct_password[i]);
-			else
-				cmp |= (0x00 ^ correct_password[i]);
-		}
-
-		if(password_len != correct_password.size())
-			cmp = 0xFF;
-
-		if(cmp != 0)
+		if(!check_password(correct_password, password))
 		{
 			inf_sasl_context_session_continue(
 				session,
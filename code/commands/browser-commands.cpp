@@ -329,10 +329,11 @@ Gobby::BrowserCommands::BrowserCommands(Browser& browser,
                                         FolderManager& folder_manager,
                                         StatusBar& status_bar,
                                         Operations& operations,
-                                        const Preferences& preferences):
+                                        const Preferences& preferences,
+                                        bool subscribe_chats):
 	m_browser(browser), m_folder_manager(folder_manager),
 	m_operations(operations), m_status_bar(status_bar),
-	m_preferences(preferences)
+	m_preferences(preferences), m_subscribe_chats(subscribe_chats)
 {
 	m_browser.signal_connect().connect(
 		sigc::mem_fun(*this, &BrowserCommands::on_connect));
@@ -358,6 +359,9 @@ Gobby::BrowserCommands::BrowserCommands(Browser& browser,
 			INF_GTK_BROWSER_MODEL_COL_BROWSER, &browser,
 			-1);
 
+		// Discovered hosts have no browser until connected to
+		if(browser == NULL) continue;
+
 		InfBrowserStatus browser_status;
 		g_object_get(
 			G_OBJECT(browser), "status",
@@ -470,6 +474,8 @@ void Gobby::BrowserCommands::on_notify_status(InfBrowser* browser)
 
 void Gobby::BrowserCommands::subscribe_chat(InfBrowser* browser)
 {
+	if(!m_subscribe_chats) return;
+
 	if(INFC_IS_BROWSER(browser))
 	{
 		std::unique_ptr<RequestInfo> info(new RequestInfo(
@@ -29,9 +29,12 @@ namespace Gobby
 class BrowserCommands: public sigc::trackable
 {
 public:
+	// If subscribe_chats is false, then the chat of a server is only
+	// shown if another window has subscribed to it already.
 	BrowserCommands(Browser& browser, FolderManager& folder_manager,
 	                StatusBar& status_bar, Operations& operations,
-	                const Preferences& preferences);
+	                const Preferences& preferences,
+	                bool subscribe_chats);
 	~BrowserCommands();
 
 protected:
@@ -67,6 +70,7 @@ protected:
 	StatusBar& m_status_bar;
 	Operations& m_operations;
 	const Preferences& m_preferences;
+	const bool m_subscribe_chats;
 	gulong m_set_browser_handler;
 
 	class BrowserInfo;
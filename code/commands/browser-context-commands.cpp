@@ -88,11 +88,12 @@ namespace
 }
 
 Gobby::BrowserContextCommands::BrowserContextCommands(
-	Gtk::Window& parent, InfIo* io, Browser& browser, FileChooser& chooser,
-	Operations& operations, const CertificateManager& cert_manager,
-	Preferences& prefs)
+	Gtk::Window& parent, ConnectionManager& connection_manager,
+	Browser& browser, FileChooser& chooser, Operations& operations,
+	CertificateManager& cert_manager, Preferences& prefs)
 :
-	m_parent(parent), m_io(io), m_browser(browser),
+	m_parent(parent), m_connection_manager(connection_manager),
+	m_io(connection_manager.get_io()), m_browser(browser),
 	m_file_chooser(chooser), m_operations(operations),
 	m_cert_manager(cert_manager), m_preferences(prefs),
 	m_popup_menu(NULL),
@@ -107,10 +108,11 @@ Gobby::BrowserContextCommands::BrowserContextCommands(
 	m_action_create_directory(
 		m_action_group->add_action("create-directory")),
 	m_action_open_document(m_action_group->add_action("open-document")),
+	m_action_subscribe_all(m_action_group->add_action("subscribe-all")),
 	m_action_permissions(m_action_group->add_action("permissions")),
 	m_action_delete(m_action_group->add_action("delete"))
 {
-	g_object_ref(io);
+	g_object_ref(m_io);
 
 	m_populate_popup_handler = g_signal_connect(
 		m_browser.get_view(), "populate-popup",
@@ -138,6 +140,9 @@ Gobby::BrowserContextCommands::BrowserContextCommands(
 			&BrowserContextCommands::on_new), true));
 	m_action_open_document->signal_activate().connect(
 		sigc::mem_fun(*this, &BrowserContextCommands::on_open));
+	m_action_subscribe_all->signal_activate().connect(
+		sigc::mem_fun(*this,
+			&BrowserContextCommands::on_subscribe_all));
 	m_action_permissions->signal_activate().connect(
 		sigc::mem_fun(*this,
 			&BrowserContextCommands::on_permissions));
@@ -223,6 +228,7 @@ void Gobby::BrowserContextCommands::on_populate_popup(Gtk::Menu* menu)
 		m_action_create_document->set_enabled(is_subdirectory);
 		m_action_create_directory->set_enabled(is_subdirectory);
 		m_action_open_document->set_enabled(is_subdirectory);
+		m_action_subscribe_all->set_enabled(is_subdirectory);
 		m_action_delete->set_enabled(!is_toplevel);
 
 		Glib::RefPtr<Gio::Menu> menu_model =
@@ -283,7 +289,8 @@ void Gobby::BrowserContextCommands::on_connection_info(
 {
 	InfBrowser* browser = m_popup_watch->get_browser();
 
-	m_dialog = ConnectionInfoDialog::create(m_parent, browser);
+	m_dialog = ConnectionInfoDialog::create(
+		m_parent, browser, m_connection_manager);
 	m_dialog->add_button(_("_Close"), Gtk::RESPONSE_CLOSE);
 	m_dialog->signal_response().connect(
 		sigc::mem_fun(*this,
@@ -390,6 +397,15 @@ void Gobby::BrowserContextCommands::on_open(const Glib::VariantBase& param)
 	m_dialog->present();
 }
 
+void Gobby::BrowserContextCommands::on_subscribe_all(
+	const Glib::VariantBase& param)
+{
+	InfBrowser* browser = m_popup_watch->get_browser();
+	const InfBrowserIter* iter = m_popup_watch->get_browser_iter();
+
+	m_operations.subscribe_directory(browser, iter);
+}
+
 void Gobby::BrowserContextCommands::on_permissions(
 	const Glib::VariantBase& param)
 {
@@ -508,6 +524,7 @@ void Gobby::BrowserContextCommands::on_account_created(
 			throw std::runtime_error(message);
 		}
 
+		m_cert_manager.wait();
 		if(is_default_account &&
 		   (m_cert_manager.get_private_key() == NULL ||
 		    m_cert_manager.get_certificates() == NULL))
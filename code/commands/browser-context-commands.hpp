@@ -22,6 +22,7 @@
 #include "dialogs/entry-dialog.hpp"
 
 #include "core/nodewatch.hpp"
+#include "core/connectionmanager.hpp"
 #include "core/browser.hpp"
 #include "core/filechooser.hpp"
 
@@ -39,10 +40,10 @@ class BrowserContextCommands: public sigc::trackable
 {
 public:
 	BrowserContextCommands(Gtk::Window& parent,
-	                       InfIo* io,
+	                       ConnectionManager& connection_manager,
 	                       Browser& browser, FileChooser& chooser,
 	                       Operations& operations,
-	                       const CertificateManager& cert_manager,
+	                       CertificateManager& cert_manager,
 	                       Preferences& prf);
 	~BrowserContextCommands();
 
@@ -80,6 +81,7 @@ protected:
 
 	void on_new(const Glib::VariantBase& param, bool directory);
 	void on_open(const Glib::VariantBase& param);
+	void on_subscribe_all(const Glib::VariantBase& param);
 	void on_permissions(const Glib::VariantBase& param);
 	void on_delete(const Glib::VariantBase& param);
 
@@ -97,11 +99,12 @@ protected:
 	void on_permissions_response(int response_id);
 
 	Gtk::Window& m_parent;
+	ConnectionManager& m_connection_manager;
 	InfIo* m_io;
 	Browser& m_browser;
 	FileChooser& m_file_chooser;
 	Operations& m_operations;
-	const CertificateManager& m_cert_manager;
+	CertificateManager& m_cert_manager;
 	Preferences& m_preferences;
 
 	// Popup menu
@@ -122,6 +125,7 @@ protected:
 	const Glib::RefPtr<Gio::SimpleAction> m_action_create_document;
 	const Glib::RefPtr<Gio::SimpleAction> m_action_create_directory;
 	const Glib::RefPtr<Gio::SimpleAction> m_action_open_document;
+	const Glib::RefPtr<Gio::SimpleAction> m_action_subscribe_all;
 	const Glib::RefPtr<Gio::SimpleAction> m_action_permissions;
 	const Glib::RefPtr<Gio::SimpleAction> m_action_delete;
 };
@@ -80,8 +80,6 @@ void Gobby::EditCommands::on_document_changed(SessionView* view)
 		InfAdoptedAlgorithm* algorithm =
 			inf_adopted_session_get_algorithm(
 				INF_ADOPTED_SESSION(session));
-		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
-			m_current_view->get_text_buffer());
 
 		if(m_synchronization_complete_handler != 0)
 		{
@@ -99,12 +97,8 @@ void Gobby::EditCommands::on_document_changed(SessionView* view)
 				m_can_redo_changed_handler);
 		}
 
-		g_signal_handler_disconnect(G_OBJECT(buffer),
-		                            m_mark_set_handler);
-		g_signal_handler_disconnect(G_OBJECT(buffer),
-		                            m_changed_handler);
-
 		m_active_user_changed_connection.disconnect();
+		m_changes_connection.disconnect();
 	}
 
 	m_current_view = dynamic_cast<TextSessionView*>(view);
@@ -113,8 +107,6 @@ void Gobby::EditCommands::on_document_changed(SessionView* view)
 	{
 		InfTextSession* session = m_current_view->get_session();
 		InfUser* active_user = m_current_view->get_active_user();
-		GtkTextBuffer* buffer =
-			GTK_TEXT_BUFFER(m_current_view->get_text_buffer());
 
 		m_active_user_changed_connection =
 			m_current_view->signal_active_user_changed().connect(
@@ -123,15 +115,10 @@ void Gobby::EditCommands::on_document_changed(SessionView* view)
 					&EditCommands::
 						on_active_user_changed));
 
-		m_mark_set_handler = g_signal_connect_after(
-			G_OBJECT(buffer), "mark-set",
-			G_CALLBACK(&on_mark_set_static), this);
-		// The selection might change without mark-set being emitted
-		// when the document changes, for example when all
-		// currently selected text is deleted.
-		m_changed_handler = g_signal_connect_after(
-			G_OBJECT(buffer), "changed",
-			G_CALLBACK(&on_changed_static), this);
+		m_changes_connection = m_current_view->
+			get_change_dispatcher().signal_changed().connect(
+				sigc::mem_fun(
+					*this, &EditCommands::on_changes));
 
 		if(inf_session_get_status(INF_SESSION(session)) ==
 		   INF_SESSION_RUNNING)
@@ -161,7 +148,7 @@ void Gobby::EditCommands::on_document_changed(SessionView* view)
 		// Set initial sensitivity for active user:
 		on_active_user_changed(active_user);
 		// Set initial sensitivity for cut/copy/paste:
-		on_mark_set();
+		update_selection_sensitivity();
 
 		// Set initial sensitivity for find/replace/goto:
 		m_actions.find->set_enabled(true);
@@ -252,7 +239,7 @@ void Gobby::EditCommands::on_active_user_changed(InfUser* active_user)
 	}
 }
 
-void Gobby::EditCommands::on_mark_set()
+void Gobby::EditCommands::update_selection_sensitivity()
 {
 	g_assert(m_current_view != NULL);
 	GtkTextBuffer* buffer =
@@ -268,9 +255,18 @@ void Gobby::EditCommands::on_mark_set()
 	}
 }
 
-void Gobby::EditCommands::on_changed()
+void Gobby::EditCommands::on_changes(unsigned int changes,
+                                     const TextChangeDispatcher::AuthorList&)
 {
-	on_mark_set();
+	// The selection might change without either of its marks being set
+	// when the document changes, for example when all currently
+	// selected text is deleted.
+	if(changes & (TextChangeDispatcher::CHANGE_TEXT |
+	              TextChangeDispatcher::CHANGE_CURSOR |
+	              TextChangeDispatcher::CHANGE_SELECTION))
+	{
+		update_selection_sensitivity();
+	}
 }
 
 void Gobby::EditCommands::on_can_undo_changed(InfAdoptedUser* user,
@@ -68,24 +68,11 @@ protected:
 		static_cast<EditCommands*>(user_data)->on_sync_complete();
 	}
 
-	static void on_mark_set_static(GtkTextBuffer* buffer,
-	                               GtkTextIter* iter,
-	                               GtkTextMark* mark,
-	                               gpointer user_data)
-	{
-		static_cast<EditCommands*>(user_data)->on_mark_set();
-	}
-
-	static void on_changed_static(GtkTextBuffer* buffer,
-	                              gpointer user_data)
-	{
-		static_cast<EditCommands*>(user_data)->on_changed();
-	}
-
 	void on_sync_complete();
 	void on_active_user_changed(InfUser* active_user);
-	void on_mark_set();
-	void on_changed();
+	void on_changes(unsigned int changes,
+	                const TextChangeDispatcher::AuthorList& authors);
+	void update_selection_sensitivity();
 
 	void on_can_undo_changed(InfAdoptedUser* user, bool can_undo);
 	void on_can_redo_changed(InfAdoptedUser* user, bool can_redo);
@@ -117,8 +104,7 @@ protected:
 	gulong m_can_undo_changed_handler;
 	gulong m_can_redo_changed_handler;
 	gulong m_synchronization_complete_handler;
-	gulong m_mark_set_handler;
-	gulong m_changed_handler;
+	sigc::connection m_changes_connection;
 
 private:
 	void ensure_find_dialog();
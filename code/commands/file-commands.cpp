@@ -19,6 +19,7 @@
 #include "commands/file-tasks/task-new.hpp"
 #include "commands/file-tasks/task-open-file.hpp"
 #include "commands/file-tasks/task-open-location.hpp"
+#include "commands/file-tasks/task-quick-open.hpp"
 #include "commands/file-tasks/task-save.hpp"
 #include "commands/file-tasks/task-save-all.hpp"
 #include "commands/file-tasks/task-export-html.hpp"
@@ -65,6 +66,11 @@ Gobby::Operations& Gobby::FileCommands::Task::get_operations()
 	return m_file_commands.m_operations;
 }
 
+const Gobby::NodeIndex& Gobby::FileCommands::Task::get_node_index()
+{
+	return m_file_commands.m_browser.get_node_index();
+}
+
 const Gobby::DocumentInfoStorage&
 Gobby::FileCommands::Task::get_document_info_storage()
 {
@@ -112,6 +118,8 @@ Gobby::FileCommands::FileCommands(Gtk::Window& parent,
 		sigc::mem_fun(*this, &FileCommands::on_open)));
 	actions.open_location->signal_activate().connect(sigc::hide(
 		sigc::mem_fun(*this, &FileCommands::on_open_location)));
+	actions.quick_open->signal_activate().connect(sigc::hide(
+		sigc::mem_fun(*this, &FileCommands::on_quick_open)));
 	actions.save->signal_activate().connect(sigc::hide(
 		sigc::mem_fun(*this, &FileCommands::on_save)));
 	actions.save_as->signal_activate().connect(sigc::hide(
@@ -189,6 +197,11 @@ void Gobby::FileCommands::on_open_location()
 	set_task(new TaskOpenLocation(*this));
 }
 
+void Gobby::FileCommands::on_quick_open()
+{
+	set_task(new TaskQuickOpen(*this));
+}
+
 void Gobby::FileCommands::on_save()
 {
 	SessionView* view =
@@ -299,6 +312,7 @@ void Gobby::FileCommands::update_sensitivity()
 	m_actions.new_document->set_enabled(create_sensitivity);
 	m_actions.open->set_enabled(create_sensitivity);
 	m_actions.open_location->set_enabled(create_sensitivity);
+	m_actions.quick_open->set_enabled(create_sensitivity);
 
 	m_actions.save->set_enabled(text_sensitivity);
 	m_actions.save_as->set_enabled(text_sensitivity);
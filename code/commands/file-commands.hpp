@@ -60,6 +60,7 @@ public:
 		StatusBar& get_status_bar();
 		FileChooser& get_file_chooser();
 		Operations& get_operations();
+		const NodeIndex& get_node_index();
 		const DocumentInfoStorage& get_document_info_storage();
 		Preferences& get_preferences();
 		DocumentLocationDialog& get_document_location_dialog();
@@ -99,6 +100,7 @@ protected:
 	void on_new();
 	void on_open();
 	void on_open_location();
+	void on_quick_open();
 	void on_save();
 	void on_save_as();
 	void on_save_all();
@@ -0,0 +1,53 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "commands/file-tasks/task-quick-open.hpp"
+
+Gobby::TaskQuickOpen::TaskQuickOpen(FileCommands& file_commands):
+	Task(file_commands)
+{
+}
+
+void Gobby::TaskQuickOpen::run()
+{
+	m_dialog = QuickOpenDialog::create(get_parent(), get_node_index());
+	m_dialog->signal_response().connect(
+		sigc::mem_fun(*this, &TaskQuickOpen::on_response));
+
+	m_dialog->present();
+}
+
+void Gobby::TaskQuickOpen::on_response(int response_id)
+{
+	const NodeIndex::Match* match = NULL;
+	if(response_id == Gtk::RESPONSE_ACCEPT)
+		match = m_dialog->get_selected();
+
+	// The browser might have gone away while the dialog was open
+	if(match != NULL && get_node_index().has_browser(match->browser))
+	{
+		InfBrowser* browser = match->browser;
+		const std::string path = match->path;
+
+		m_dialog.reset(NULL);
+
+		// This takes care of documents that are subscribed already,
+		// and of the document having been removed in the meanwhile.
+		get_operations().subscribe_path(browser, path);
+	}
+
+	finish(); // deletes this
+}
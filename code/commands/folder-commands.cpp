@@ -15,6 +15,7 @@
  */
 
 #include "commands/folder-commands.hpp"
+#include "operations/operation-save.hpp"
 #include "core/sessionuserview.hpp"
 
 #include <glibmm/main.h>
@@ -64,6 +65,16 @@ public:
 
 	virtual void flush() {}
 
+	// Sends requests that are held back right away, if there are any
+	void flush_pending()
+	{
+		if(m_active_user != NULL &&
+		   inf_user_get_status(m_active_user) == INF_USER_ACTIVE)
+		{
+			flush();
+		}
+	}
+
 protected:
 	void activate_user()
 	{
@@ -201,44 +212,116 @@ class Gobby::FolderCommands::TextDocInfo:
 	public Gobby::FolderCommands::DocInfo
 {
 public:
-	TextDocInfo(TextSessionView& view): DocInfo(view) {}
+	TextDocInfo(TextSessionView& view, const Preferences& preferences):
+		DocInfo(view), m_text_view(view), m_preferences(preferences)
+	{
+		view.get_change_dispatcher().signal_changed().connect(
+			sigc::mem_fun(*this, &TextDocInfo::on_changes));
+
+		m_focus_out_handle = g_signal_connect(
+			G_OBJECT(view.get_text_view()), "focus-out-event",
+			G_CALLBACK(on_focus_out_event_static), this);
+	}
+
+	virtual ~TextDocInfo()
+	{
+		g_signal_handler_disconnect(
+			G_OBJECT(m_text_view.get_text_view()),
+			m_focus_out_handle);
+		m_flush_connection.disconnect();
+	}
 
 	virtual void activate()
 	{
 		DocInfo::activate();
 
-		InfTextGtkBuffer* buffer = INF_TEXT_GTK_BUFFER(
-			inf_session_get_buffer(m_view.get_session()));
-
 		inf_text_gtk_buffer_set_wake_on_cursor_movement(
-			buffer, TRUE);
+			m_view.get_inf_buffer(), TRUE);
 	}
 
 	virtual void deactivate()
 	{
 		DocInfo::deactivate();
 
-		InfTextGtkBuffer* buffer = INF_TEXT_GTK_BUFFER(
-			inf_session_get_buffer(m_view.get_session()));
-
 		inf_text_gtk_buffer_set_wake_on_cursor_movement(
-			buffer, FALSE);
+			m_view.get_inf_buffer(), FALSE);
 	}
 
 	virtual void flush()
 	{
 		DocInfo::flush();
 
+		m_flush_connection.disconnect();
 		g_assert(m_active_user != NULL);
 
 		inf_text_session_flush_requests_for_user(
 			INF_TEXT_SESSION(m_view.get_session()),
 			INF_TEXT_USER(m_active_user));
 	}
+
+protected:
+	static gboolean on_focus_out_event_static(GtkWidget* widget,
+	                                          GdkEventFocus* event,
+	                                          gpointer user_data)
+	{
+		// Don't keep others waiting while we are away
+		static_cast<TextDocInfo*>(user_data)->flush_pending();
+		return FALSE;
+	}
+
+	// libinfinity holds back caret and selection changes of the local
+	// user for a while, so that they can be merged with the following
+	// ones. Make sure they go out within the configured window.
+	void on_changes(unsigned int changes,
+	                const TextChangeDispatcher::AuthorList& authors)
+	{
+		if(m_active_user == NULL ||
+		   inf_user_get_status(m_active_user) != INF_USER_ACTIVE)
+		{
+			return;
+		}
+
+		const unsigned int caret_changes =
+			TextChangeDispatcher::CHANGE_CURSOR |
+			TextChangeDispatcher::CHANGE_SELECTION;
+
+		bool local = (changes & caret_changes) != 0;
+		for(TextChangeDispatcher::AuthorList::const_iterator iter =
+			authors.begin();
+		    iter != authors.end() && !local; ++iter)
+		{
+			if(INF_USER(*iter) == m_active_user)
+				local = true;
+		}
+
+		if(!local) return;
+
+		const unsigned int window = m_preferences.network.batch_window;
+		if(window == 0)
+		{
+			flush();
+		}
+		else if(!m_flush_connection.connected())
+		{
+			m_flush_connection = Glib::signal_timeout().connect(
+				sigc::bind_return(sigc::mem_fun(
+					*this, &DocInfo::flush_pending),
+					false),
+				window);
+		}
+	}
+
+	TextSessionView& m_text_view;
+	const Preferences& m_preferences;
+
+	sigc::connection m_flush_connection;
+	gulong m_focus_out_handle;
 };
 
-Gobby::FolderCommands::FolderCommands(const Folder& folder):
-	m_folder(folder), m_current_view(NULL)
+Gobby::FolderCommands::FolderCommands(const Folder& folder,
+                                      Operations& operations,
+                                      const Preferences& preferences):
+	m_folder(folder), m_preferences(preferences), m_current_view(NULL)
 {
 	m_folder.signal_document_added().connect(
 		sigc::mem_fun(*this, &FolderCommands::on_document_added));
@@ -246,6 +329,8 @@ Gobby::FolderCommands::FolderCommands(const Folder& folder):
 		sigc::mem_fun(*this, &FolderCommands::on_document_removed));
 	m_folder.signal_document_changed().connect(
 		sigc::mem_fun(*this, &FolderCommands::on_document_changed));
+	operations.signal_begin_save_operation().connect(
+		sigc::mem_fun(*this, &FolderCommands::on_begin_save_operation));
 
 	const unsigned int n_pages =
 		static_cast<unsigned int>(m_folder.get_n_pages());
@@ -282,7 +367,7 @@ void Gobby::FolderCommands::on_document_added(SessionView& view)
 			dynamic_cast<TextSessionView*>(&view);
 
 		if(text_view)
-			info = new TextDocInfo(*text_view);
+			info = new TextDocInfo(*text_view, m_preferences);
 		else
 			info = new DocInfo(view);
 	}
@@ -326,3 +411,11 @@ void Gobby::FolderCommands::on_document_changed(SessionView* view)
 		iter->second->activate();
 	}
 }
+
+void Gobby::FolderCommands::on_begin_save_operation(OperationSave* operation)
+{
+	// Others should see the document in the state in which it is saved
+	DocumentMap::iterator iter = m_doc_map.find(operation->get_view());
+	if(iter != m_doc_map.end())
+		iter->second->flush_pending();
+}
@@ -17,7 +17,10 @@
 #ifndef _GOBBY_FOLDER_COMMANDS_HPP_
 #define _GOBBY_FOLDER_COMMANDS_HPP_
 
+#include "operations/operations.hpp"
+
 #include "core/folder.hpp"
+#include "core/preferences.hpp"
 
 #include <sigc++/trackable.h>
 
@@ -27,7 +30,8 @@ namespace Gobby
 class FolderCommands: public sigc::trackable
 {
 public:
-	FolderCommands(const Folder& folder);
+	FolderCommands(const Folder& folder, Operations& operations,
+	               const Preferences& preferences);
 	~FolderCommands();
 
 protected:
@@ -35,8 +39,10 @@ protected:
 	void on_document_added(SessionView& view);
 	void on_document_removed(SessionView& view);
 	void on_document_changed(SessionView* view);
+	void on_begin_save_operation(OperationSave* operation);
 
 	const Folder& m_folder;
+	const Preferences& m_preferences;
 	SessionView* m_current_view;
 
 	class DocInfo;
@@ -0,0 +1,203 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "commands/record-commands.hpp"
+
+#include <iostream> // For std::cerr
+
+Gobby::RecordCommands::RecordCommands(WindowActions& actions,
+                                      const Folder& folder,
+                                      RecordWriter& writer,
+                                      const Preferences& preferences):
+	m_actions(actions), m_folder(folder), m_writer(writer),
+	m_preferences(preferences), m_current_view(NULL)
+{
+	m_folder.signal_document_added().connect(
+		sigc::mem_fun(*this, &RecordCommands::on_document_added));
+	m_folder.signal_document_removed().connect(
+		sigc::mem_fun(*this, &RecordCommands::on_document_removed));
+	m_folder.signal_document_changed().connect(
+		sigc::mem_fun(*this, &RecordCommands::on_document_changed));
+
+	m_menu_record_connection = m_actions.record_session->
+		property_state().signal_changed().connect(
+			sigc::mem_fun(
+				*this,
+				&RecordCommands::on_menu_record_toggled));
+
+	m_preferences.editor.record_max_size.signal_changed().connect(
+		sigc::mem_fun(
+			*this, &RecordCommands::on_record_max_size_changed));
+	m_preferences.editor.record_max_files.signal_changed().connect(
+		sigc::mem_fun(
+			*this, &RecordCommands::on_record_max_files_changed));
+
+	m_writer.signal_record_full().connect(
+		sigc::mem_fun(*this, &RecordCommands::on_record_full));
+
+	on_record_max_size_changed();
+	on_record_max_files_changed();
+
+	// Setup initial state
+	on_document_changed(m_folder.get_current_document());
+}
+
+Gobby::RecordCommands::~RecordCommands()
+{
+	// Finish all records of this window
+	for(RecordMap::iterator iter = m_records.begin();
+	    iter != m_records.end(); ++iter)
+	{
+		g_object_unref(iter->second.record);
+	}
+}
+
+bool Gobby::RecordCommands::is_recording(TextSessionView& view) const
+{
+	return m_records.find(&view) != m_records.end();
+}
+
+void Gobby::RecordCommands::start_recording(TextSessionView& view)
+{
+	if(is_recording(view)) return;
+
+	const std::string uri = m_writer.open(view.get_title());
+
+	InfAdoptedSessionRecord* record = inf_adopted_session_record_new(
+		INF_ADOPTED_SESSION(view.get_session()));
+
+	GError* error = NULL;
+	inf_adopted_session_record_start_recording(
+		record, uri.c_str(), &error);
+	if(error != NULL)
+	{
+		std::cerr << "Failed to create record for '"
+		          << view.get_title() << "': " << error->message
+		          << std::endl;
+
+		g_error_free(error);
+		g_object_unref(record);
+
+		// In case libxml2 did not get to open the URI
+		m_writer.forget(uri);
+	}
+	else
+	{
+		Record& entry = m_records[&view];
+		entry.record = record;
+		entry.uri = uri;
+	}
+
+	if(&view == m_current_view)
+		update_action();
+}
+
+void Gobby::RecordCommands::stop_recording(TextSessionView& view)
+{
+	RecordMap::iterator iter = m_records.find(&view);
+	if(iter == m_records.end()) return;
+
+	// This finishes the record
+	g_object_unref(iter->second.record);
+	m_records.erase(iter);
+
+	if(&view == m_current_view)
+		update_action();
+}
+
+void Gobby::RecordCommands::on_document_added(SessionView& view)
+{
+	TextSessionView* text_view = dynamic_cast<TextSessionView*>(&view);
+	if(text_view != NULL && m_preferences.editor.record_sessions)
+		start_recording(*text_view);
+}
+
+void Gobby::RecordCommands::on_document_removed(SessionView& view)
+{
+	TextSessionView* text_view = dynamic_cast<TextSessionView*>(&view);
+	if(text_view != NULL)
+		stop_recording(*text_view);
+
+	if(text_view == m_current_view)
+		on_document_changed(NULL);
+}
+
+void Gobby::RecordCommands::on_document_changed(SessionView* view)
+{
+	m_current_view = dynamic_cast<TextSessionView*>(view);
+	update_action();
+}
+
+void Gobby::RecordCommands::on_menu_record_toggled()
+{
+	if(m_current_view == NULL) return;
+
+	bool value;
+	m_actions.record_session->get_state(value);
+
+	if(value)
+		start_recording(*m_current_view);
+	else
+		stop_recording(*m_current_view);
+}
+
+void Gobby::RecordCommands::on_record_max_size_changed()
+{
+	const unsigned int megabytes = m_preferences.editor.record_max_size;
+	m_writer.set_max_size(megabytes * 1024 * 1024);
+}
+
+void Gobby::RecordCommands::on_record_max_files_changed()
+{
+	m_writer.set_max_files(m_preferences.editor.record_max_files);
+}
+
+void Gobby::RecordCommands::on_record_full(const std::string& uri)
+{
+	for(RecordMap::iterator iter = m_records.begin();
+	    iter != m_records.end(); ++iter)
+	{
+		if(iter->second.uri == uri)
+		{
+			// Finish the record, so that its file stays complete,
+			// and continue in a new file that starts with the
+			// current state of the document.
+			TextSessionView& view = *iter->first;
+			stop_recording(view);
+			start_recording(view);
+			return;
+		}
+	}
+}
+
+void Gobby::RecordCommands::update_action()
+{
+	m_menu_record_connection.block();
+
+	if(m_current_view != NULL)
+	{
+		m_actions.record_session->set_enabled(true);
+		m_actions.record_session->change_state(
+			is_recording(*m_current_view));
+	}
+	else
+	{
+		m_actions.record_session->set_enabled(false);
+		m_actions.record_session->change_state(false);
+	}
+
+	m_menu_record_connection.unblock();
+}
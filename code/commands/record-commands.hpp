@@ -0,0 +1,81 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_RECORD_COMMANDS_HPP_
+#define _GOBBY_RECORD_COMMANDS_HPP_
+
+#include "core/folder.hpp"
+#include "core/preferences.hpp"
+#include "core/windowactions.hpp"
+#include "util/recordwriter.hpp"
+
+#include <libinfinity/adopted/inf-adopted-session-record.h>
+
+#include <sigc++/trackable.h>
+
+#include <map>
+#include <string>
+
+namespace Gobby
+{
+
+// Records text sessions into ~/.infinote-records, either for all documents
+// if the record-sessions preference is set, or for individual documents
+// via the record-session action.
+class RecordCommands: public sigc::trackable
+{
+public:
+	RecordCommands(WindowActions& actions, const Folder& folder,
+	               RecordWriter& writer, const Preferences& preferences);
+	~RecordCommands();
+
+	bool is_recording(TextSessionView& view) const;
+	void start_recording(TextSessionView& view);
+	void stop_recording(TextSessionView& view);
+
+protected:
+	void on_document_added(SessionView& view);
+	void on_document_removed(SessionView& view);
+	void on_document_changed(SessionView* view);
+
+	void on_menu_record_toggled();
+	void on_record_max_size_changed();
+	void on_record_max_files_changed();
+	void on_record_full(const std::string& uri);
+
+	void update_action();
+
+	WindowActions& m_actions;
+	const Folder& m_folder;
+	RecordWriter& m_writer;
+	const Preferences& m_preferences;
+
+	struct Record
+	{
+		InfAdoptedSessionRecord* record;
+		std::string uri;
+	};
+
+	typedef std::map<TextSessionView*, Record> RecordMap;
+	RecordMap m_records;
+
+	TextSessionView* m_current_view;
+	sigc::connection m_menu_record_connection;
+};
+
+}
+
+#endif // _GOBBY_RECORD_COMMANDS_HPP_
@@ -0,0 +1,528 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "commands/session-restore-commands.hpp"
+#include "operations/operation-subscribe-path.hpp"
+
+#include <libinfinity/client/infc-browser.h>
+#include <libinfinity/common/inf-xmpp-connection.h>
+
+#include <glibmm/main.h>
+#include <glibmm/uriutils.h>
+
+#include <vector>
+
+namespace
+{
+	const char SECTION[] = "open-documents";
+	const char CURRENT_KEY[] = "current";
+
+	// Builds an infinote:// URI for the node, so that it can be
+	// subscribed to again with OperationSubscribePath. Returns an
+	// empty string for documents that are not on a remote server.
+	std::string make_uri(InfBrowser* browser, const InfBrowserIter* iter)
+	{
+		if(!INFC_IS_BROWSER(browser) || iter == NULL)
+			return std::string();
+
+		InfXmlConnection* connection =
+			infc_browser_get_connection(INFC_BROWSER(browser));
+		if(!INF_IS_XMPP_CONNECTION(connection))
+			return std::string();
+
+		gchar* hostname;
+		InfTcpConnection* tcp;
+		g_object_get(G_OBJECT(connection),
+		             "remote-hostname", &hostname,
+		             "tcp-connection", &tcp,
+		             NULL);
+
+		guint port;
+		g_object_get(G_OBJECT(tcp), "remote-port", &port, NULL);
+		g_object_unref(tcp);
+
+		// IPv6 addresses need to be put into brackets, see
+		// parse_netloc().
+		std::string netloc = hostname;
+		g_free(hostname);
+		if(netloc.find(':') != std::string::npos)
+			netloc = "[" + netloc + "]";
+
+		gchar* path = inf_browser_get_path(browser, iter);
+		const std::string result = "infinote://" + netloc + ":" +
+			std::to_string(port) +
+			Glib::uri_escape_string(path, "/", true);
+		g_free(path);
+
+		return result;
+	}
+
+	std::string make_key(unsigned int position)
+	{
+		gchar key[16];
+		g_snprintf(key, sizeof(key), "%04u", position);
+		return key;
+	}
+
+	// Entries are stored as tab-separated fields in the state store
+	std::string encode_entry(const std::string& uri,
+	                         unsigned int line, unsigned int offset)
+	{
+		return uri + "\t" + std::to_string(line) + "\t" +
+			std::to_string(offset);
+	}
+
+	bool decode_entry(const std::string& value, std::string& uri,
+	                  unsigned int& line, unsigned int& offset)
+	{
+		gchar** fields = g_strsplit(value.c_str(), "\t", 3);
+		const bool valid = g_strv_length(fields) == 3;
+
+		if(valid)
+		{
+			uri = fields[0];
+			line = g_ascii_strtoull(fields[1], NULL, 10);
+			offset = g_ascii_strtoull(fields[2], NULL, 10);
+		}
+
+		g_strfreev(fields);
+		return valid;
+	}
+
+	void set_cursor(Gobby::TextSessionView& view,
+	                unsigned int line, unsigned int offset)
+	{
+		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
+			view.get_text_buffer());
+
+		// The document might have been changed in the meanwhile,
+		// so stay within the text that is there.
+		GtkTextIter iter;
+		gtk_text_buffer_get_iter_at_line(buffer, &iter, line);
+		if(static_cast<int>(offset) <
+		   gtk_text_iter_get_chars_in_line(&iter))
+		{
+			gtk_text_iter_set_line_offset(&iter, offset);
+		}
+		else if(!gtk_text_iter_ends_line(&iter))
+		{
+			gtk_text_iter_forward_to_line_end(&iter);
+		}
+
+		view.set_selection(&iter, &iter);
+	}
+}
+
+// Moves the cursor to its previous position once the document has been
+// synchronized.
+class Gobby::SessionRestoreCommands::CursorInfo
+{
+public:
+	CursorInfo(SessionRestoreCommands& commands, TextSessionView& view,
+	           unsigned int line, unsigned int offset);
+	~CursorInfo();
+
+	unsigned int get_line() const { return m_line; }
+	unsigned int get_offset() const { return m_offset; }
+
+protected:
+	static void on_notify_status_static(GObject* object,
+	                                    GParamSpec* pspec,
+	                                    gpointer user_data)
+	{
+		static_cast<CursorInfo*>(user_data)->on_notify_status();
+	}
+
+	void on_notify_status();
+
+	SessionRestoreCommands& m_commands;
+	TextSessionView& m_view;
+	const unsigned int m_line;
+	const unsigned int m_offset;
+	gulong m_notify_status_handle;
+};
+
+Gobby::SessionRestoreCommands::CursorInfo::CursorInfo(
+	SessionRestoreCommands& commands, TextSessionView& view,
+	unsigned int line, unsigned int offset):
+	m_commands(commands), m_view(view), m_line(line), m_offset(offset)
+{
+	m_notify_status_handle = g_signal_connect(
+		G_OBJECT(m_view.get_session()), "notify::status",
+		G_CALLBACK(on_notify_status_static), this);
+}
+
+Gobby::SessionRestoreCommands::CursorInfo::~CursorInfo()
+{
+	g_signal_handler_disconnect(m_view.get_session(),
+	                            m_notify_status_handle);
+}
+
+void Gobby::SessionRestoreCommands::CursorInfo::on_notify_status()
+{
+	InfSession* session = INF_SESSION(m_view.get_session());
+	if(inf_session_get_status(session) == INF_SESSION_RUNNING)
+	{
+		set_cursor(m_view, m_line, m_offset);
+		m_commands.on_cursor_restored(m_view);
+		// Note that the above call deletes this object!
+	}
+}
+
+Gobby::SessionRestoreCommands::SessionRestoreCommands(
+	StateStore& state_store, FolderManager& folder_manager,
+	Folder& text_folder, Operations& operations):
+	m_state_store(state_store), m_folder_manager(folder_manager),
+	m_text_folder(text_folder), m_operations(operations),
+	m_current_view(NULL), m_previous_view(NULL)
+{
+	m_folder_manager.signal_document_added().connect(
+		sigc::mem_fun(
+			*this, &SessionRestoreCommands::on_document_added));
+	m_folder_manager.signal_document_removed().connect(
+		sigc::mem_fun(
+			*this, &SessionRestoreCommands::on_document_removed));
+	m_text_folder.signal_page_reordered().connect(
+		sigc::mem_fun(
+			*this, &SessionRestoreCommands::on_page_reordered));
+	m_text_folder.signal_document_changed().connect(
+		sigc::mem_fun(
+			*this, &SessionRestoreCommands::on_document_changed));
+}
+
+Gobby::SessionRestoreCommands::~SessionRestoreCommands()
+{
+	// Record the final cursor positions. The documents are still there
+	// at this point, since the folder outlives us.
+	m_save_connection.disconnect();
+	save();
+
+	for(CursorMap::iterator iter = m_cursors.begin();
+	    iter != m_cursors.end(); ++iter)
+	{
+		delete iter->second;
+	}
+}
+
+void Gobby::SessionRestoreCommands::restore()
+{
+	// Copy the entries first, since every document that comes back
+	// rewrites the section.
+	const StateStore::Section& section =
+		m_state_store.get_section(SECTION);
+
+	unsigned int current = 0;
+	bool has_current = false;
+	std::map<unsigned int, Entry> entries;
+
+	for(StateStore::Section::const_iterator iter = section.begin();
+	    iter != section.end(); ++iter)
+	{
+		if(iter->first == CURRENT_KEY)
+		{
+			current = g_ascii_strtoull(
+				iter->second.c_str(), NULL, 10);
+			has_current = true;
+			continue;
+		}
+
+		Entry entry;
+		if(decode_entry(iter->second, entry.uri,
+		                entry.line, entry.offset))
+		{
+			entries[g_ascii_strtoull(
+				iter->first.c_str(), NULL, 10)] = entry;
+		}
+	}
+
+	std::vector<std::string> uris;
+	unsigned int position = 0;
+	for(std::map<unsigned int, Entry>::const_iterator iter =
+		entries.begin();
+	    iter != entries.end(); ++iter, ++position)
+	{
+		m_pending.push_back(std::make_pair(position, iter->second));
+
+		// The document that was shown last goes first, so that
+		// it is there as early as possible.
+		if(has_current && iter->first == current)
+		{
+			m_current_uri = iter->second.uri;
+			uris.insert(uris.begin(), iter->second.uri);
+		}
+		else
+		{
+			uris.push_back(iter->second.uri);
+		}
+	}
+
+	// All subscriptions run concurrently. Subscriptions to the same
+	// server share a single connection, and directories on the way are
+	// explored only once.
+	for(std::vector<std::string>::const_iterator iter = uris.begin();
+	    iter != uris.end(); ++iter)
+	{
+		OperationSubscribePath* op =
+			m_operations.subscribe_path(*iter);
+
+		if(op != NULL)
+		{
+			op->signal_finished().connect(sigc::bind(
+				sigc::mem_fun(
+					*this,
+					&SessionRestoreCommands::
+						on_subscribe_finished),
+				*iter));
+		}
+		else
+		{
+			// The operation has finished already. If it was
+			// successful the document is no longer pending.
+			on_subscribe_finished(false, *iter);
+		}
+	}
+}
+
+void Gobby::SessionRestoreCommands::on_document_added(
+	InfBrowser* browser, const InfBrowserIter* iter,
+	InfSessionProxy* proxy, Folder& folder, SessionView& view,
+	FolderManager::UserJoinRef userjoin)
+{
+	TextSessionView* text_view = dynamic_cast<TextSessionView*>(&view);
+	if(text_view == NULL) return;
+
+	const std::string uri = make_uri(browser, iter);
+	if(uri.empty()) return;
+
+	m_uris[text_view] = uri;
+
+	for(PendingList::iterator pending_iter = m_pending.begin();
+	    pending_iter != m_pending.end(); ++pending_iter)
+	{
+		if(pending_iter->second.uri == uri)
+		{
+			const unsigned int position = pending_iter->first;
+			const Entry entry = pending_iter->second;
+			m_pending.erase(pending_iter);
+
+			m_positions[text_view] = position;
+			place_restored_document(*text_view, position);
+
+			InfSession* session = view.get_session();
+			if(inf_session_get_status(session) ==
+			   INF_SESSION_RUNNING)
+			{
+				set_cursor(*text_view, entry.line,
+				           entry.offset);
+			}
+			else
+			{
+				m_cursors[text_view] = new CursorInfo(
+					*this, *text_view,
+					entry.line, entry.offset);
+			}
+
+			// Only the document that was shown last should
+			// take the focus. Others arrive in the background.
+			if(uri != m_current_uri && m_previous_view != NULL)
+			{
+				m_text_folder.switch_to_document(
+					*m_previous_view);
+				gtk_widget_grab_focus(GTK_WIDGET(
+					m_previous_view->get_text_view()));
+			}
+
+			break;
+		}
+	}
+
+	schedule_save();
+}
+
+void Gobby::SessionRestoreCommands::on_document_removed(
+	InfBrowser* browser, const InfBrowserIter* iter,
+	InfSessionProxy* proxy, Folder& folder, SessionView& view)
+{
+	TextSessionView* text_view = dynamic_cast<TextSessionView*>(&view);
+	if(text_view == NULL) return;
+
+	if(m_current_view == text_view) m_current_view = NULL;
+	if(m_previous_view == text_view) m_previous_view = NULL;
+
+	CursorMap::iterator cursor_iter = m_cursors.find(text_view);
+	if(cursor_iter != m_cursors.end())
+	{
+		delete cursor_iter->second;
+		m_cursors.erase(cursor_iter);
+	}
+
+	m_positions.erase(text_view);
+	if(m_uris.erase(text_view) > 0)
+		schedule_save();
+}
+
+void Gobby::SessionRestoreCommands::on_page_reordered(Gtk::Widget* page,
+                                                      guint page_num)
+{
+	schedule_save();
+}
+
+void Gobby::SessionRestoreCommands::on_document_changed(SessionView* view)
+{
+	TextSessionView* text_view = dynamic_cast<TextSessionView*>(view);
+	if(text_view == m_current_view) return;
+
+	m_previous_view = m_current_view;
+	m_current_view = text_view;
+
+	schedule_save();
+}
+
+void Gobby::SessionRestoreCommands::on_subscribe_finished(bool success,
+                                                          std::string uri)
+{
+	if(success) return;
+
+	// The document does not exist anymore, or the server could not
+	// be reached. Forget about it, so that it is not tried again on
+	// every start.
+	for(PendingList::iterator iter = m_pending.begin();
+	    iter != m_pending.end(); ++iter)
+	{
+		if(iter->second.uri == uri)
+		{
+			m_pending.erase(iter);
+			schedule_save();
+			break;
+		}
+	}
+}
+
+void Gobby::SessionRestoreCommands::on_cursor_restored(TextSessionView& view)
+{
+	CursorMap::iterator iter = m_cursors.find(&view);
+	g_assert(iter != m_cursors.end());
+
+	delete iter->second;
+	m_cursors.erase(iter);
+}
+
+// Moves the tab of a restored document behind the restored documents that
+// came before it the last time.
+void Gobby::SessionRestoreCommands::place_restored_document(
+	TextSessionView& view, unsigned int position)
+{
+	Gtk::Widget* page = view.get_parent();
+
+	int target = 0;
+	int index = 0;
+	for(int i = 0; i < m_text_folder.get_n_pages(); ++i)
+	{
+		if(m_text_folder.get_nth_page(i) == page) continue;
+		++index;
+
+		TextSessionView* other = dynamic_cast<TextSessionView*>(
+			&m_text_folder.get_document(i));
+		PositionMap::const_iterator iter = m_positions.find(other);
+		if(iter != m_positions.end() && iter->second < position)
+			target = index;
+	}
+
+	m_text_folder.reorder_child(*page, target);
+}
+
+void Gobby::SessionRestoreCommands::schedule_save()
+{
+	// Documents often come and go in bulk, so only save once they are
+	// done.
+	if(!m_save_connection.connected())
+	{
+		m_save_connection = Glib::signal_idle().connect(
+			sigc::bind_return(sigc::mem_fun(
+				*this, &SessionRestoreCommands::save), false));
+	}
+}
+
+void Gobby::SessionRestoreCommands::save()
+{
+	m_save_connection.disconnect();
+
+	std::vector<Entry> entries;
+	std::string current_uri;
+
+	for(int i = 0; i < m_text_folder.get_n_pages(); ++i)
+	{
+		TextSessionView* view = dynamic_cast<TextSessionView*>(
+			&m_text_folder.get_document(i));
+		UriMap::const_iterator uri_iter = m_uris.find(view);
+		if(uri_iter == m_uris.end()) continue;
+
+		Entry entry;
+		entry.uri = uri_iter->second;
+
+		// Keep the previous position until the document has
+		// finished synchronizing.
+		CursorMap::const_iterator cursor_iter = m_cursors.find(view);
+		if(cursor_iter != m_cursors.end())
+		{
+			entry.line = cursor_iter->second->get_line();
+			entry.offset = cursor_iter->second->get_offset();
+		}
+		else
+		{
+			GtkTextBuffer* buffer =
+				GTK_TEXT_BUFFER(view->get_text_buffer());
+			GtkTextIter cursor;
+			gtk_text_buffer_get_iter_at_mark(
+				buffer, &cursor,
+				gtk_text_buffer_get_insert(buffer));
+			entry.line = gtk_text_iter_get_line(&cursor);
+			entry.offset = gtk_text_iter_get_line_offset(&cursor);
+		}
+
+		if(view == m_text_folder.get_current_document())
+			current_uri = entry.uri;
+
+		entries.push_back(entry);
+	}
+
+	// Documents that are still being restored keep their place
+	for(PendingList::const_iterator iter = m_pending.begin();
+	    iter != m_pending.end(); ++iter)
+	{
+		std::vector<Entry>::size_type position = iter->first;
+		if(position > entries.size()) position = entries.size();
+		entries.insert(entries.begin() + position, iter->second);
+
+		if(current_uri.empty() && iter->second.uri == m_current_uri)
+			current_uri = m_current_uri;
+	}
+
+	m_state_store.clear(SECTION);
+	for(std::vector<Entry>::size_type i = 0; i < entries.size(); ++i)
+	{
+		m_state_store.set(
+			SECTION, make_key(i),
+			encode_entry(entries[i].uri, entries[i].line,
+			             entries[i].offset));
+
+		if(entries[i].uri == current_uri)
+		{
+			m_state_store.set(SECTION, CURRENT_KEY,
+			                  std::to_string(i));
+		}
+	}
+}
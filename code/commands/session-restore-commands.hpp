@@ -0,0 +1,116 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_SESSION_RESTORE_COMMANDS_HPP_
+#define _GOBBY_SESSION_RESTORE_COMMANDS_HPP_
+
+#include "operations/operations.hpp"
+
+#include "core/foldermanager.hpp"
+#include "core/folder.hpp"
+#include "util/statestore.hpp"
+
+#include <sigc++/trackable.h>
+#include <sigc++/connection.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace Gobby
+{
+
+// Remembers the documents that are open in the primary window, with their
+// tab order and cursor position, and opens them again on the next start.
+// All subscriptions are issued at once, with the document that was shown
+// last going first. Tabs appear as the subscriptions come back, and are
+// moved into their previous order.
+class SessionRestoreCommands: public sigc::trackable
+{
+public:
+	SessionRestoreCommands(StateStore& state_store,
+	                       FolderManager& folder_manager,
+	                       Folder& text_folder,
+	                       Operations& operations);
+	~SessionRestoreCommands();
+
+	// Subscribes to the documents that were open when Gobby was
+	// closed the last time.
+	void restore();
+
+protected:
+	struct Entry
+	{
+		std::string uri;
+		unsigned int line;
+		unsigned int offset;
+	};
+
+	class CursorInfo;
+
+	void on_document_added(InfBrowser* browser,
+	                       const InfBrowserIter* iter,
+	                       InfSessionProxy* proxy,
+	                       Folder& folder,
+	                       SessionView& view,
+	                       FolderManager::UserJoinRef userjoin);
+	void on_document_removed(InfBrowser* browser,
+	                         const InfBrowserIter* iter,
+	                         InfSessionProxy* proxy,
+	                         Folder& folder,
+	                         SessionView& view);
+	void on_page_reordered(Gtk::Widget* page, guint page_num);
+	void on_document_changed(SessionView* view);
+	void on_subscribe_finished(bool success, std::string uri);
+	void on_cursor_restored(TextSessionView& view);
+
+	void place_restored_document(TextSessionView& view,
+	                             unsigned int position);
+	void schedule_save();
+	void save();
+
+	StateStore& m_state_store;
+	FolderManager& m_folder_manager;
+	Folder& m_text_folder;
+	Operations& m_operations;
+
+	// URIs of the open documents that can be restored
+	typedef std::map<TextSessionView*, std::string> UriMap;
+	UriMap m_uris;
+
+	// Documents that are being restored, in their previous tab order.
+	// The saved position of documents that are open already is
+	// remembered so that late arrivals can be sorted in between them.
+	typedef std::list<std::pair<unsigned int, Entry> > PendingList;
+	PendingList m_pending;
+	typedef std::map<TextSessionView*, unsigned int> PositionMap;
+	PositionMap m_positions;
+	std::string m_current_uri;
+
+	// The document shown before the current one, to go back to when a
+	// restored document takes the focus.
+	TextSessionView* m_current_view;
+	TextSessionView* m_previous_view;
+
+	typedef std::map<TextSessionView*, CursorInfo*> CursorMap;
+	CursorMap m_cursors;
+
+	sigc::connection m_save_connection;
+};
+
+}
+
+#endif // _GOBBY_SESSION_RESTORE_COMMANDS_HPP_
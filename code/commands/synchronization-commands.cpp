@@ -15,6 +15,7 @@
  */
 
 #include "commands/synchronization-commands.hpp"
+#include "core/textsessionview.hpp"
 
 #include "util/i18n.hpp"
 
@@ -22,6 +23,10 @@ namespace
 {
 	inline const gchar* _(const gchar* msgid) { return Gobby::_(msgid); }
 
+	// Minimum time between two updates of the progress text, in
+	// microseconds. Progress is reported for every chunk of text.
+	const gint64 PROGRESS_INTERVAL = G_USEC_PER_SEC / 4;
+
 	void set_progress_text(Gobby::SessionView& view,
 	                       gdouble percentage)
 	{
@@ -105,6 +110,7 @@ private:
 	                                 gdouble percentage);
 
 	SessionView& m_view;
+	gint64 m_last_progress_update;
 
 	gulong m_synchronization_complete_handler;
 	gulong m_synchronization_failed_handler;
@@ -113,10 +119,16 @@ private:
 
 Gobby::SynchronizationCommands::SyncInfo::
 	SyncInfo(SynchronizationCommands& commands, SessionView& view):
-	m_view(view)
+	m_view(view), m_last_progress_update(g_get_monotonic_time())
 {
 	InfSession* session = m_view.get_session();
 
+	// Keep the text view out of the way while the text comes in, so
+	// that it does not lay out and highlight the text chunk by chunk.
+	TextSessionView* text_view = dynamic_cast<TextSessionView*>(&view);
+	if(text_view != NULL)
+		text_view->set_buffer_attached(false);
+
 	m_synchronization_complete_handler = g_signal_connect(
 		G_OBJECT(session), "synchronization-complete",
 		G_CALLBACK(on_synchronization_complete_static), &commands);
@@ -138,12 +150,20 @@ Gobby::SynchronizationCommands::SyncInfo::~SyncInfo()
 	                            m_synchronization_failed_handler);
 	g_signal_handler_disconnect(G_OBJECT(session),
 	                            m_synchronization_progress_handler);
+
+	TextSessionView* text_view = dynamic_cast<TextSessionView*>(&m_view);
+	if(text_view != NULL)
+		text_view->set_buffer_attached(true);
 }
 
 void Gobby::SynchronizationCommands::SyncInfo::
 	on_synchronization_progress(InfXmlConnection* conn,
 	                            gdouble percentage)
 {
+	const gint64 now = g_get_monotonic_time();
+	if(now - m_last_progress_update < PROGRESS_INTERVAL) return;
+
+	m_last_progress_update = now;
 	set_progress_text(m_view, percentage);
 }
 
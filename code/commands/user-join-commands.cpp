@@ -194,7 +194,10 @@ void Gobby::UserJoinCommands::UserJoinInfo::
 }
 
 Gobby::UserJoinCommands::UserJoinCommands(FolderManager& folder_manager,
+                                          SessionUsers& session_users,
+                                          SessionCache& session_cache,
 	                                  const Preferences& preferences):
+	m_session_users(session_users), m_session_cache(session_cache),
 	m_preferences(preferences)
 {
 	folder_manager.signal_document_added().connect(
@@ -203,14 +206,32 @@ Gobby::UserJoinCommands::UserJoinCommands(FolderManager& folder_manager,
 	folder_manager.signal_document_removed().connect(
 		sigc::mem_fun(
 			*this, &UserJoinCommands::on_document_removed));
+	folder_manager.get_text_folder().signal_document_changed().connect(
+		sigc::mem_fun(
+			*this, &UserJoinCommands::on_document_changed));
+	folder_manager.get_chat_folder().signal_document_changed().connect(
+		sigc::mem_fun(
+			*this, &UserJoinCommands::on_document_changed));
+	session_users.signal_join_finished().connect(
+		sigc::mem_fun(
+			*this, &UserJoinCommands::on_join_finished));
 }
 
 Gobby::UserJoinCommands::~UserJoinCommands()
 {
+	m_deferred_joins.clear();
+	m_waiting_joins.clear();
+
 	for(UserJoinMap::iterator iter = m_user_join_map.begin();
 	    iter != m_user_join_map.end(); ++iter)
 	{
 		delete iter->second;
+
+		// Let another window showing the document join instead
+		InfSession* session;
+		g_object_get(G_OBJECT(iter->first), "session", &session, NULL);
+		m_session_users.end_join(session, NULL, NULL);
+		g_object_unref(session);
 	}
 }
 
@@ -225,27 +246,192 @@ void Gobby::UserJoinCommands::on_document_added(InfBrowser* browser,
 
 	g_assert(m_user_join_map.find(proxy) == m_user_join_map.end());
 
+	// If the document was kept subscribed in the background after it
+	// has been closed, then continue with the user that was joined
+	// before.
+	InfUser* cached_user = m_session_cache.take(proxy);
+
+	InfSession* session;
+	g_object_get(G_OBJECT(proxy), "session", &session, NULL);
+	m_session_users.add_view(session);
+	InfUser* user = m_session_users.get_user(session);
+	if(user == NULL && cached_user != NULL)
+	{
+		m_session_users.set_user(session, cached_user);
+		user = cached_user;
+	}
+	const bool joining = m_session_users.is_joining(session);
+	g_object_unref(session);
+
 	std::unique_ptr<UserJoin> userjoin;
-	if(j && j->get())
+	if(user != NULL && !(j && j->get()))
+	{
+		// The document is shown in another window already, so
+		// share the user that has joined there.
+		on_user_join_finished(proxy, folder, view, user, NULL);
+		return;
+	}
+	else if(j && j->get())
 	{
 		// If there is a user already joined for this session,
 		// then simply use that user instead of joining another one.
 		userjoin = std::move(*j);
 	}
+	else if(iter != NULL && folder.get_current_document() != &view)
+	{
+		// The document has been opened in the background. Only join
+		// once it is shown, so that opening many documents at once
+		// does not make us show up in all of them.
+		DeferredJoin& deferred = m_deferred_joins[&view];
+		deferred.browser = browser;
+		deferred.iter = *iter;
+		deferred.has_iter = true;
+		deferred.proxy = proxy;
+		deferred.folder = &folder;
+		return;
+	}
+	else if(joining)
+	{
+		// Another window is joining the session right now. Wait for
+		// it instead of joining a second user.
+		DeferredJoin& waiting = m_waiting_joins[&view];
+		waiting.browser = browser;
+		waiting.has_iter = (iter != NULL);
+		if(iter != NULL) waiting.iter = *iter;
+		waiting.proxy = proxy;
+		waiting.folder = &folder;
+		return;
+	}
 	else
 	{
 		// Otherwise join a new user.
-		std::unique_ptr<UserJoin::ParameterProvider> provider(
-			new ParameterProvider(view, folder, m_preferences));
-		userjoin.reset(new UserJoin(browser, iter, proxy,
-		                            std::move(provider)));
+		join_user(browser, iter, proxy, folder, view);
+		return;
 	}
 
+	start_user_join(proxy, folder, view, std::move(userjoin));
+}
+
+void Gobby::UserJoinCommands::on_document_changed(SessionView* view)
+{
+	DeferredJoinMap::iterator iter = m_deferred_joins.find(view);
+	if(iter == m_deferred_joins.end()) return;
+
+	const DeferredJoin deferred = iter->second;
+	m_deferred_joins.erase(iter);
+
+	// Another window might have joined the session in the meanwhile,
+	// or might be joining it right now.
+	InfSession* session;
+	g_object_get(G_OBJECT(deferred.proxy), "session", &session, NULL);
+	InfUser* user = m_session_users.get_user(session);
+	const bool joining = m_session_users.is_joining(session);
+	g_object_unref(session);
+
+	if(user != NULL)
+	{
+		on_user_join_finished(deferred.proxy, *deferred.folder, *view,
+		                      user, NULL);
+	}
+	else if(joining)
+	{
+		m_waiting_joins[view] = deferred;
+	}
+	else
+	{
+		join_user(deferred.browser, &deferred.iter, deferred.proxy,
+		          *deferred.folder, *view);
+	}
+}
+
+void Gobby::UserJoinCommands::on_join_finished(InfSession* session,
+                                               InfUser* user,
+                                               const GError* error)
+{
+	// Take the documents waiting for this session out of the map
+	// first, since handling them can change it.
+	typedef std::vector<std::pair<SessionView*, DeferredJoin> > JoinList;
+	JoinList waiting;
+	for(DeferredJoinMap::iterator iter = m_waiting_joins.begin();
+	    iter != m_waiting_joins.end(); )
+	{
+		InfSession* waiting_session;
+		g_object_get(G_OBJECT(iter->second.proxy),
+		             "session", &waiting_session, NULL);
+		g_object_unref(waiting_session);
+
+		if(waiting_session == session)
+		{
+			waiting.push_back(*iter);
+			m_waiting_joins.erase(iter++);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+
+	for(JoinList::iterator iter = waiting.begin();
+	    iter != waiting.end(); ++iter)
+	{
+		SessionView& view = *iter->first;
+		const DeferredJoin& join = iter->second;
+
+		// If the join was cancelled, then the first waiting window
+		// joins by itself, and the others wait for that one.
+		InfUser* shared_user = m_session_users.get_user(session);
+		if(error != NULL)
+		{
+			on_user_join_finished(join.proxy, *join.folder, view,
+			                      NULL, error);
+		}
+		else if(shared_user != NULL)
+		{
+			on_user_join_finished(join.proxy, *join.folder, view,
+			                      shared_user, NULL);
+		}
+		else if(m_session_users.is_joining(session))
+		{
+			m_waiting_joins[&view] = join;
+		}
+		else
+		{
+			join_user(join.browser,
+			          join.has_iter ? &join.iter : NULL,
+			          join.proxy, *join.folder, view);
+		}
+	}
+}
+
+void Gobby::UserJoinCommands::join_user(InfBrowser* browser,
+                                        const InfBrowserIter* iter,
+                                        InfSessionProxy* proxy,
+                                        Folder& folder,
+                                        SessionView& view)
+{
+	std::unique_ptr<UserJoin::ParameterProvider> provider(
+		new ParameterProvider(view, folder, m_preferences));
+	std::unique_ptr<UserJoin> userjoin(
+		new UserJoin(browser, iter, proxy, std::move(provider)));
+
+	start_user_join(proxy, folder, view, std::move(userjoin));
+}
+
+void Gobby::UserJoinCommands::start_user_join(
+	InfSessionProxy* proxy, Folder& folder, SessionView& view,
+	std::unique_ptr<UserJoin> userjoin)
+{
 	if(userjoin->get_user() == NULL && userjoin->get_error() == NULL)
 	{
 		m_user_join_map[proxy] =
 			new UserJoinInfo(*this, std::move(userjoin),
 			                 folder, view);
+
+		// Other windows showing the document wait for this join
+		InfSession* session;
+		g_object_get(G_OBJECT(proxy), "session", &session, NULL);
+		m_session_users.begin_join(session);
+		g_object_unref(session);
 	}
 	else
 	{
@@ -263,6 +449,13 @@ void Gobby::UserJoinCommands::on_document_removed(InfBrowser* browser,
 {
 	g_assert(proxy != NULL);
 
+	InfSession* session;
+	g_object_get(G_OBJECT(proxy), "session", &session, NULL);
+	const unsigned int n_views = m_session_users.remove_view(session);
+
+	m_deferred_joins.erase(&view);
+	m_waiting_joins.erase(&view);
+
 	UserJoinMap::iterator user_iter = m_user_join_map.find(proxy);
 
 	// If the user join was successful the session is no longer in the map
@@ -270,6 +463,15 @@ void Gobby::UserJoinCommands::on_document_removed(InfBrowser* browser,
 	{
 		delete user_iter->second;
 		m_user_join_map.erase(user_iter);
+
+		// If the document is shown in another window, then that
+		// one joins instead.
+		m_session_users.end_join(session, NULL, NULL);
+	}
+	else if(n_views > 0)
+	{
+		// The document is still shown in another window, so keep
+		// the session and the user as they are.
 	}
 	else
 	{
@@ -312,10 +514,20 @@ void Gobby::UserJoinCommands::on_document_removed(InfBrowser* browser,
 		}
 		else if(INFC_IS_SESSION_PROXY(proxy))
 		{
-			infc_session_proxy_set_connection(
-				INFC_SESSION_PROXY(proxy), NULL, NULL, 0);
+			// Keep the session subscribed for a while if it
+			// was joined, so that it opens instantly when it
+			// is shown again.
+			InfUser* user = view.get_active_user();
+			if(user == NULL || !m_session_cache.add(proxy, user))
+			{
+				infc_session_proxy_set_connection(
+					INFC_SESSION_PROXY(proxy),
+					NULL, NULL, 0);
+			}
 		}
 	}
+
+	g_object_unref(session);
 }
 
 void Gobby::UserJoinCommands::on_user_join_finished(InfSessionProxy* proxy,
@@ -329,12 +541,24 @@ void Gobby::UserJoinCommands::on_user_join_finished(InfSessionProxy* proxy,
 	// Remove userjoin object. It might not exist if
 	// on_document_added() was passed a user immediately.
 	UserJoinMap::iterator user_iter = m_user_join_map.find(proxy);
-	if(user_iter != m_user_join_map.end())
+	const bool joined_here = (user_iter != m_user_join_map.end());
+	if(joined_here)
 	{
 		delete user_iter->second;
 		m_user_join_map.erase(user_iter);
 	}
 
+	InfSession* session;
+	g_object_get(G_OBJECT(proxy), "session", &session, NULL);
+
+	// Let other windows that wait for this join go on with its result
+	if(joined_here)
+		m_session_users.end_join(session, user, error);
+	else if(user != NULL)
+		m_session_users.set_user(session, user);
+
+	g_object_unref(session);
+
 	if(error == NULL)
 	{
 		// TODO: Notify the user about alternative user name if s/he uses any
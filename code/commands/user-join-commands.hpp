@@ -19,6 +19,8 @@
 
 #include "core/foldermanager.hpp"
 #include "core/preferences.hpp"
+#include "core/sessioncache.hpp"
+#include "core/sessionusers.hpp"
 #include "core/userjoin.hpp"
 
 #include <sigc++/trackable.h>
@@ -30,6 +32,8 @@ class UserJoinCommands: public sigc::trackable
 {
 public:
 	UserJoinCommands(FolderManager& folder_manager,
+	                 SessionUsers& session_users,
+	                 SessionCache& session_cache,
 	                 const Preferences& preferences);
 	~UserJoinCommands();
 
@@ -45,17 +49,49 @@ protected:
 	                         InfSessionProxy* proxy,
 	                         Folder& folder,
 	                         SessionView& view);
+	void on_document_changed(SessionView* view);
+	void on_join_finished(InfSession* session, InfUser* user,
+	                      const GError* error);
+	void join_user(InfBrowser* browser,
+	               const InfBrowserIter* iter,
+	               InfSessionProxy* proxy,
+	               Folder& folder,
+	               SessionView& view);
+	void start_user_join(InfSessionProxy* proxy,
+	                     Folder& folder,
+	                     SessionView& view,
+	                     std::unique_ptr<UserJoin> userjoin);
 	void on_user_join_finished(InfSessionProxy* proxy,
 	                           Folder& folder,
 	                           SessionView& view,
 	                           InfUser* user,
 	                           const GError* error);
 
+	SessionUsers& m_session_users;
+	SessionCache& m_session_cache;
 	const Preferences& m_preferences;
 
 	class UserJoinInfo;
 	typedef std::map<InfSessionProxy*, UserJoinInfo*> UserJoinMap;
 	UserJoinMap m_user_join_map;
+
+	struct DeferredJoin
+	{
+		InfBrowser* browser;
+		InfBrowserIter iter;
+		bool has_iter;
+		InfSessionProxy* proxy;
+		Folder* folder;
+	};
+
+	typedef std::map<SessionView*, DeferredJoin> DeferredJoinMap;
+
+	// Documents opened in the background, which are joined as soon as
+	// they are shown.
+	DeferredJoinMap m_deferred_joins;
+	// Documents whose session another window is joining at the moment.
+	// They use the user of that window once it has joined.
+	DeferredJoinMap m_waiting_joins;
 };
 
 }
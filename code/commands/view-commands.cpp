@@ -351,11 +351,9 @@ void Gobby::ViewCommands::on_hide_user_colors()
 	TextSessionView* text_view = dynamic_cast<TextSessionView*>(view);
 	g_assert(text_view != NULL);
 
-	InfSession* session = INF_SESSION(text_view->get_session());
 	GtkTextBuffer* textbuffer =
 		GTK_TEXT_BUFFER(text_view->get_text_buffer());
-	InfBuffer* buffer = inf_session_get_buffer(session);
-	InfTextGtkBuffer* infbuffer = INF_TEXT_GTK_BUFFER(buffer);
+	InfTextGtkBuffer* infbuffer = text_view->get_inf_buffer();
 
 	GtkTextIter start, end;
 	gtk_text_buffer_get_start_iter(textbuffer, &start);
@@ -17,6 +17,7 @@
 #include "applicationactions.hpp"
 
 Gobby::ApplicationActions::ApplicationActions(Gio::ActionMap& map):
+	new_window(map.add_action("new-window")),
 	quit(map.add_action("quit")),
 	preferences(map.add_action("preferences")),
 	help(map.add_action("help")),
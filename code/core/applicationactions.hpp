@@ -27,6 +27,7 @@ class ApplicationActions
 public:
 	ApplicationActions(Gio::ActionMap& map);
 
+	const Glib::RefPtr<Gio::SimpleAction> new_window;
 	const Glib::RefPtr<Gio::SimpleAction> quit;
 	const Glib::RefPtr<Gio::SimpleAction> preferences;
 	const Glib::RefPtr<Gio::SimpleAction> help;
@@ -0,0 +1,348 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/authorshipindex.hpp"
+
+#include <algorithm>
+
+Gobby::AuthorshipIndex::Node::Node(unsigned int author,
+                                   unsigned int length,
+                                   guint32 priority):
+	author(author), length(length), subtree_length(length),
+	priority(priority), left(NULL), right(NULL)
+{
+}
+
+Gobby::AuthorshipIndex::AuthorshipIndex(InfTextBuffer* buffer):
+	m_buffer(buffer), m_root(NULL), m_n_runs(0)
+{
+	g_object_ref(m_buffer);
+
+	// Seed the index with the text that is already in the buffer
+	const guint length = inf_text_buffer_get_length(m_buffer);
+	if(length > 0)
+	{
+		InfTextChunk* chunk =
+			inf_text_buffer_get_slice(m_buffer, 0, length);
+		on_text_inserted(0, chunk);
+		inf_text_chunk_free(chunk);
+	}
+
+	m_text_inserted_handle = g_signal_connect_after(
+		G_OBJECT(m_buffer), "text-inserted",
+		G_CALLBACK(on_text_inserted_static), this);
+	m_text_erased_handle = g_signal_connect_after(
+		G_OBJECT(m_buffer), "text-erased",
+		G_CALLBACK(on_text_erased_static), this);
+}
+
+Gobby::AuthorshipIndex::~AuthorshipIndex()
+{
+	g_signal_handler_disconnect(m_buffer, m_text_inserted_handle);
+	g_signal_handler_disconnect(m_buffer, m_text_erased_handle);
+
+	free_tree(m_root);
+	g_object_unref(m_buffer);
+}
+
+unsigned int Gobby::AuthorshipIndex::get_author_at(unsigned int pos) const
+{
+	const Node* node = m_root;
+	while(node != NULL)
+	{
+		const unsigned int left_length = subtree_length(node->left);
+		if(pos < left_length)
+		{
+			node = node->left;
+		}
+		else if(pos < left_length + node->length)
+		{
+			return node->author;
+		}
+		else
+		{
+			pos -= left_length + node->length;
+			node = node->right;
+		}
+	}
+
+	return 0;
+}
+
+unsigned int
+Gobby::AuthorshipIndex::get_char_count(unsigned int author) const
+{
+	CountMap::const_iterator iter = m_counts.find(author);
+	if(iter == m_counts.end()) return 0;
+	return iter->second;
+}
+
+unsigned int Gobby::AuthorshipIndex::get_length() const
+{
+	return subtree_length(m_root);
+}
+
+void Gobby::AuthorshipIndex::foreach_run(unsigned int begin,
+                                         unsigned int end,
+                                         const SlotRun& slot) const
+{
+	if(begin < end)
+		foreach_run_impl(m_root, 0, begin, end, slot);
+}
+
+void Gobby::AuthorshipIndex::on_text_inserted(unsigned int pos,
+                                              InfTextChunk* chunk)
+{
+	InfTextChunkIter iter;
+	if(inf_text_chunk_iter_init_begin(chunk, &iter))
+	{
+		do
+		{
+			const unsigned int length =
+				inf_text_chunk_iter_get_length(&iter);
+			const unsigned int author =
+				inf_text_chunk_iter_get_author(&iter);
+
+			insert_run(pos, length, author);
+			m_counts[author] += length;
+			pos += length;
+		} while(inf_text_chunk_iter_next(&iter));
+	}
+}
+
+void Gobby::AuthorshipIndex::on_text_erased(unsigned int pos,
+                                            InfTextChunk* chunk)
+{
+	erase_range(pos, inf_text_chunk_get_length(chunk));
+
+	InfTextChunkIter iter;
+	if(inf_text_chunk_iter_init_begin(chunk, &iter))
+	{
+		do
+		{
+			const unsigned int length =
+				inf_text_chunk_iter_get_length(&iter);
+			const unsigned int author =
+				inf_text_chunk_iter_get_author(&iter);
+
+			CountMap::iterator count_iter = m_counts.find(author);
+			g_assert(count_iter != m_counts.end());
+			g_assert(count_iter->second >= length);
+
+			count_iter->second -= length;
+			if(count_iter->second == 0)
+				m_counts.erase(count_iter);
+		} while(inf_text_chunk_iter_next(&iter));
+	}
+}
+
+void Gobby::AuthorshipIndex::update(Node* node)
+{
+	node->subtree_length = subtree_length(node->left) + node->length +
+		subtree_length(node->right);
+}
+
+Gobby::AuthorshipIndex::Node*
+Gobby::AuthorshipIndex::merge(Node* left, Node* right)
+{
+	if(left == NULL) return right;
+	if(right == NULL) return left;
+
+	if(left->priority >= right->priority)
+	{
+		left->right = merge(left->right, right);
+		update(left);
+		return left;
+	}
+	else
+	{
+		right->left = merge(left, right->left);
+		update(right);
+		return right;
+	}
+}
+
+void Gobby::AuthorshipIndex::split(Node* node, unsigned int pos,
+                                   Node*& left, Node*& right)
+{
+	if(node == NULL)
+	{
+		left = right = NULL;
+		return;
+	}
+
+	const unsigned int left_length = subtree_length(node->left);
+	if(pos <= left_length)
+	{
+		split(node->left, pos, left, node->left);
+		update(node);
+		right = node;
+	}
+	else if(pos >= left_length + node->length)
+	{
+		split(node->right, pos - left_length - node->length,
+		      node->right, right);
+		update(node);
+		left = node;
+	}
+	else
+	{
+		// The split position is inside this run, so cut it in two.
+		// The second half takes over the right subtree and the
+		// priority of the original node, which keeps the heap
+		// property intact.
+		const unsigned int offset = pos - left_length;
+		Node* rest = new Node(node->author, node->length - offset,
+		                      node->priority);
+		++m_n_runs;
+
+		rest->right = node->right;
+		node->right = NULL;
+		node->length = offset;
+
+		update(node);
+		update(rest);
+
+		left = node;
+		right = rest;
+	}
+}
+
+// Concatenates left and right into left, merging the two adjacent runs at
+// the seam if they have the same author, so that the number of runs stays
+// minimal.
+void Gobby::AuthorshipIndex::join(Node*& left, Node* right)
+{
+	if(left == NULL) { left = right; return; }
+	if(right == NULL) return;
+
+	const Node* last = left;
+	while(last->right != NULL) last = last->right;
+	const Node* first = right;
+	while(first->left != NULL) first = first->left;
+
+	if(last->author == first->author)
+	{
+		Node* head;
+		right = remove_first(right, head);
+		Node* tail;
+		left = remove_last(left, tail);
+
+		tail->length += head->length;
+		tail->left = tail->right = NULL;
+		update(tail);
+
+		delete head;
+		--m_n_runs;
+
+		left = merge(left, tail);
+	}
+
+	left = merge(left, right);
+}
+
+Gobby::AuthorshipIndex::Node*
+Gobby::AuthorshipIndex::remove_first(Node* node, Node*& first)
+{
+	if(node->left == NULL)
+	{
+		first = node;
+		return node->right;
+	}
+
+	node->left = remove_first(node->left, first);
+	update(node);
+	return node;
+}
+
+Gobby::AuthorshipIndex::Node*
+Gobby::AuthorshipIndex::remove_last(Node* node, Node*& last)
+{
+	if(node->right == NULL)
+	{
+		last = node;
+		return node->left;
+	}
+
+	node->right = remove_last(node->right, last);
+	update(node);
+	return node;
+}
+
+void Gobby::AuthorshipIndex::free_tree(Node* node)
+{
+	if(node == NULL) return;
+
+	free_tree(node->left);
+	free_tree(node->right);
+	delete node;
+	--m_n_runs;
+}
+
+void Gobby::AuthorshipIndex::insert_run(unsigned int pos, unsigned int len,
+                                        unsigned int author)
+{
+	if(len == 0) return;
+
+	Node* left;
+	Node* right;
+	split(m_root, pos, left, right);
+
+	Node* node = new Node(author, len, g_random_int());
+	++m_n_runs;
+
+	join(left, node);
+	join(left, right);
+	m_root = left;
+}
+
+void Gobby::AuthorshipIndex::erase_range(unsigned int pos, unsigned int len)
+{
+	if(len == 0) return;
+
+	Node* left;
+	Node* middle;
+	Node* right;
+	split(m_root, pos, left, middle);
+	split(middle, len, middle, right);
+
+	free_tree(middle);
+
+	join(left, right);
+	m_root = left;
+}
+
+void Gobby::AuthorshipIndex::foreach_run_impl(const Node* node,
+                                              unsigned int offset,
+                                              unsigned int begin,
+                                              unsigned int end,
+                                              const SlotRun& slot) const
+{
+	if(node == NULL) return;
+	if(offset >= end || offset + node->subtree_length <= begin) return;
+
+	foreach_run_impl(node->left, offset, begin, end, slot);
+
+	const unsigned int node_begin = offset + subtree_length(node->left);
+	const unsigned int node_end = node_begin + node->length;
+
+	const unsigned int run_begin = std::max(node_begin, begin);
+	const unsigned int run_end = std::min(node_end, end);
+	if(run_begin < run_end)
+		slot(run_begin, run_end - run_begin, node->author);
+
+	foreach_run_impl(node->right, node_end, begin, end, slot);
+}
@@ -0,0 +1,135 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_AUTHORSHIPINDEX_HPP_
+#define _GOBBY_AUTHORSHIPINDEX_HPP_
+
+#include <libinftext/inf-text-buffer.h>
+#include <libinftext/inf-text-chunk.h>
+
+#include <sigc++/slot.h>
+
+#include <map>
+
+namespace Gobby
+{
+
+// Keeps track of which user wrote which part of a text buffer. The text is
+// stored as a sequence of runs of equal authorship in a treap which is
+// ordered by character offset, so that the author at a given offset can be
+// looked up in O(log n) without going through the GtkTextTag toggles of
+// the InfTextGtkBuffer. Author 0 means unowned text.
+class AuthorshipIndex
+{
+public:
+	typedef sigc::slot<void, unsigned int, unsigned int, unsigned int>
+		SlotRun;
+
+	AuthorshipIndex(InfTextBuffer* buffer);
+	~AuthorshipIndex();
+
+	// Returns the ID of the user who wrote the character at offset pos,
+	// or 0 if the text is unowned or pos is past the end of the buffer.
+	unsigned int get_author_at(unsigned int pos) const;
+
+	// Returns the number of characters in the buffer written by the
+	// user with the given ID.
+	unsigned int get_char_count(unsigned int author) const;
+
+	unsigned int get_length() const;
+	unsigned int get_n_runs() const { return m_n_runs; }
+
+	// Calls slot with (offset, length, author) for every run of text
+	// with equal authorship that intersects [begin, end), in order. The
+	// first and last run are clipped to the given range.
+	void foreach_run(unsigned int begin, unsigned int end,
+	                 const SlotRun& slot) const;
+
+protected:
+	static void on_text_inserted_static(InfTextBuffer* buffer,
+	                                    guint position,
+	                                    InfTextChunk* chunk,
+	                                    InfUser* user,
+	                                    gpointer user_data)
+	{
+		static_cast<AuthorshipIndex*>(user_data)->
+			on_text_inserted(position, chunk);
+	}
+
+	static void on_text_erased_static(InfTextBuffer* buffer,
+	                                  guint position,
+	                                  InfTextChunk* chunk,
+	                                  InfUser* user,
+	                                  gpointer user_data)
+	{
+		static_cast<AuthorshipIndex*>(user_data)->
+			on_text_erased(position, chunk);
+	}
+
+	void on_text_inserted(unsigned int pos, InfTextChunk* chunk);
+	void on_text_erased(unsigned int pos, InfTextChunk* chunk);
+
+private:
+	struct Node
+	{
+		Node(unsigned int author, unsigned int length,
+		     guint32 priority);
+
+		unsigned int author;
+		unsigned int length;
+		unsigned int subtree_length;
+		guint32 priority;
+
+		Node* left;
+		Node* right;
+	};
+
+	static unsigned int subtree_length(const Node* node)
+	{
+		return node != NULL ? node->subtree_length : 0;
+	}
+
+	static void update(Node* node);
+	static Node* merge(Node* left, Node* right);
+	void split(Node* node, unsigned int pos, Node*& left, Node*& right);
+	void join(Node*& left, Node* right);
+
+	static Node* remove_first(Node* node, Node*& first);
+	static Node* remove_last(Node* node, Node*& last);
+	void free_tree(Node* node);
+
+	void insert_run(unsigned int pos, unsigned int len,
+	                unsigned int author);
+	void erase_range(unsigned int pos, unsigned int len);
+
+	void foreach_run_impl(const Node* node, unsigned int offset,
+	                      unsigned int begin, unsigned int end,
+	                      const SlotRun& slot) const;
+
+	InfTextBuffer* m_buffer;
+	Node* m_root;
+	unsigned int m_n_runs;
+
+	typedef std::map<unsigned int, unsigned int> CountMap;
+	CountMap m_counts;
+
+	gulong m_text_inserted_handle;
+	gulong m_text_erased_handle;
+};
+
+}
+
+#endif // _GOBBY_AUTHORSHIPINDEX_HPP_
@@ -16,7 +16,6 @@
 
 #include "dialogs/password-dialog.hpp"
 #include "core/browser.hpp"
-#include "core/noteplugin.hpp"
 #include "util/file.hpp"
 #include "util/uri.hpp"
 #include "util/i18n.hpp"
@@ -28,87 +27,33 @@
 #include <libinfinity/server/infd-directory.h>
 #include <libinfinity/client/infc-browser.h>
 
-gint compare_func(GtkTreeModel* model, GtkTreeIter* first,
-                  GtkTreeIter* second, gpointer user_data)
+#include <cstring>
+
+namespace
 {
-	gint result;
-	InfBrowser* br_one;
-	InfBrowser* br_two;
-	InfBrowserIter* bri_one;
-	InfBrowserIter* bri_two;
-	GtkTreeIter parent;
-
-	result = 0;
-	if(gtk_tree_model_iter_parent(model, &parent, first))
+	gint compare_func(GtkTreeModel* model, GtkTreeIter* first,
+	                  GtkTreeIter* second, gpointer user_data)
 	{
-		g_assert(gtk_tree_model_iter_parent(model, &parent, second));
-
-		gtk_tree_model_get(
-			model, first,
-			INF_GTK_BROWSER_MODEL_COL_BROWSER, &br_one,
-			INF_GTK_BROWSER_MODEL_COL_NODE, &bri_one,
-			-1);
-		gtk_tree_model_get(
-			model, second,
-			INF_GTK_BROWSER_MODEL_COL_BROWSER, &br_two,
-			INF_GTK_BROWSER_MODEL_COL_NODE, &bri_two,
-			-1);
-
-		if(inf_browser_is_subdirectory(br_one, bri_one) &&
-		   !inf_browser_is_subdirectory(br_two, bri_two))
-		{
-			result = -1;
-		}
-		else if(!inf_browser_is_subdirectory(br_one, bri_one) &&
-		        inf_browser_is_subdirectory(br_two, bri_two))
-		{
-			result = 1;
-		}
-
-		g_object_unref(br_one);
-		g_object_unref(br_two);
-		inf_browser_iter_free(bri_one);
-		inf_browser_iter_free(bri_two);
-	}
+		Gobby::BrowserStore* store =
+			static_cast<Gobby::BrowserStore*>(user_data);
 
-	if(!result)
-	{
-		gchar* name_one;
-		gchar* name_two;
-
-		gtk_tree_model_get(
-			model, first,
-			INF_GTK_BROWSER_MODEL_COL_NAME, &name_one,
-			-1);
-		gtk_tree_model_get(
-			model, second,
-			INF_GTK_BROWSER_MODEL_COL_NAME, &name_two,
-			-1);
-
-		gchar* one = g_utf8_casefold(name_one, -1);
-		gchar* two = g_utf8_casefold(name_two, -1);
-
-		result = g_utf8_collate(one, two);
-
-		g_free(name_one);
-		g_free(name_two);
-		g_free(one);
-		g_free(two);
+		return std::strcmp(store->get_sort_key(first),
+		                   store->get_sort_key(second));
 	}
-
-	return result;
 }
 
 Gobby::Browser::Browser(Gtk::Window& parent,
                         StatusBar& status_bar,
-                        ConnectionManager& connection_manager):
+                        BrowserStore& store,
+                        StateStore& state_store):
 	m_parent(parent),
 	m_status_bar(status_bar),
-	m_connection_manager(connection_manager),
+	m_store(store),
 
 	m_expander(_("_Direct Connection"), true),
 	m_label_hostname(_("Host Name:")),
-	m_entry_hostname(config_filename("recent_hosts"), 5)
+	m_entry_hostname(state_store, "recent-hosts",
+	                 config_filename("recent_hosts"), 5)
 {
 	m_label_hostname.show();
 	m_entry_hostname.set_hexpand(true);
@@ -127,27 +72,11 @@ Gobby::Browser::Browser(Gtk::Window& parent,
 	m_expander.property_expanded().signal_changed().connect(
 		sigc::mem_fun(*this, &Browser::on_expanded_changed));
 
-	m_browser_store = inf_gtk_browser_store_new(
-		connection_manager.get_io(),
-		connection_manager.get_communication_manager());
-	
 	m_sort_model = inf_gtk_browser_model_sort_new(
-		INF_GTK_BROWSER_MODEL(m_browser_store));
+		INF_GTK_BROWSER_MODEL(m_store.get_store()));
 	gtk_tree_sortable_set_default_sort_func(
-		GTK_TREE_SORTABLE(m_sort_model), compare_func, NULL, NULL);
-
-	if(m_connection_manager.get_discovery() != NULL)
-	{
-		inf_gtk_browser_store_add_discovery(
-			m_browser_store,
-			m_connection_manager.get_discovery());
-	}
-
-	Glib::ustring known_hosts_file = config_filename("known_hosts");
-
-	m_cert_checker = inf_gtk_certificate_manager_new(
-		parent.gobj(), m_connection_manager.get_xmpp_manager(),
-		known_hosts_file.c_str());
+		GTK_TREE_SORTABLE(m_sort_model), compare_func, &m_store,
+		NULL);
 
 	m_browser_view =
 		INF_GTK_BROWSER_VIEW(
@@ -162,16 +91,9 @@ Gobby::Browser::Browser(Gtk::Window& parent,
 	m_scroll.set_vexpand(true);
 	m_scroll.show();
 
-	connection_manager.signal_connection_replaced().connect(
+	m_store.get_connection_manager().signal_connection_replaced().connect(
 		sigc::mem_fun(*this, &Browser::on_connection_replaced));
 
-	g_signal_connect(
-		m_browser_store,
-		"set-browser",
-		G_CALLBACK(&on_set_browser_static),
-		this
-	);
-
 	g_signal_connect(
 		m_browser_view,
 		"activate",
@@ -179,6 +101,19 @@ Gobby::Browser::Browser(Gtk::Window& parent,
 		this
 	);
 
+	// Remember which directories are expanded, and expand them again
+	// when their contents show up after reconnecting. This needs to
+	// run after the view has seen the new rows.
+	m_row_expanded_handler = g_signal_connect(
+		m_browser_view, "row-expanded",
+		G_CALLBACK(&on_row_expanded_static), this);
+	m_row_collapsed_handler = g_signal_connect(
+		m_browser_view, "row-collapsed",
+		G_CALLBACK(&on_row_collapsed_static), this);
+	m_row_inserted_handler = g_signal_connect(
+		m_sort_model, "row-inserted",
+		G_CALLBACK(&on_row_inserted_static), this);
+
 	set_row_spacing(6);
 	attach(m_scroll, 0, 0, 1, 1);
 	attach(m_expander, 0, 1, 1, 1);
@@ -190,9 +125,10 @@ Gobby::Browser::Browser(Gtk::Window& parent,
 
 Gobby::Browser::~Browser()
 {
-	g_object_unref(m_browser_store);
+	g_signal_handler_disconnect(m_browser_view, m_row_expanded_handler);
+	g_signal_handler_disconnect(m_browser_view, m_row_collapsed_handler);
+	g_signal_handler_disconnect(m_sort_model, m_row_inserted_handler);
 	g_object_unref(m_sort_model);
-	g_object_unref(m_cert_checker);
 }
 
 void Gobby::Browser::init_accessibility()
@@ -281,21 +217,7 @@ InfBrowser* Gobby::Browser::add_remote(const std::string& hostname,
                                        unsigned int device_index,
                                        bool connect)
 {
-	// Check whether we do have such a connection already:
-	InfXmppConnection* xmpp = m_connection_manager.make_connection(
-		hostname, service, device_index, connect);
-
-	// Should have thrown otherwise:
-	g_assert(xmpp != NULL);
-
-	// TODO: Remove erroneous entry with same name, if any, before
-	// adding.
-
-	InfBrowser* browser = inf_gtk_browser_store_add_connection(
-		m_browser_store, INF_XML_CONNECTION(xmpp),
-		hostname.c_str());
-
-	return browser;
+	return m_store.add_remote(hostname, service, device_index, connect);
 }
 
 InfBrowser* Gobby::Browser::add_remote(const InfIpAddress* address,
@@ -304,55 +226,33 @@ InfBrowser* Gobby::Browser::add_remote(const InfIpAddress* address,
                                        const std::string& hostname,
                                        bool connect)
 {
-	// Check whether we do have such a connection already:
-	InfXmppConnection* xmpp = m_connection_manager.make_connection(
-		address, port, device_index, hostname, connect);
-
-	// Should have thrown otherwise:
-	g_assert(xmpp != NULL);
-
-	// TODO: Remove erroneous entry with same name, if any, before
-	// adding.
-
-	InfBrowser* browser = inf_gtk_browser_store_add_connection(
-		m_browser_store, INF_XML_CONNECTION(xmpp),
-		hostname.c_str());
-
-	return browser;
+	return m_store.add_remote(address, port, device_index, hostname,
+	                          connect);
 }
 
 void Gobby::Browser::add_browser(InfBrowser* browser,
                                  const char* name)
 {
-	inf_gtk_browser_store_add_browser(
-		m_browser_store, browser, name);
+	m_store.add_browser(browser, name);
 }
 
 void Gobby::Browser::remove_browser(InfBrowser* browser)
 {
-	m_connection_manager.remove_connection(
-		INF_XMPP_CONNECTION(
-			infc_browser_get_connection(
-				INFC_BROWSER(browser))));
-
-	inf_gtk_browser_store_remove_browser(
-		m_browser_store, browser);
+	m_store.remove_browser(browser);
 }
 
 void Gobby::Browser::on_connection_replaced(InfXmppConnection* connection,
                                             InfXmppConnection* by)
 {
-	// Remove the browser for the replaced connection, and highlight the
-	// one it was replaced with.
-	inf_gtk_browser_store_remove_connection(
-		m_browser_store, INF_XML_CONNECTION(connection));
+	// The browser store has removed the browser for the replaced
+	// connection already; highlight the one it was replaced with.
 
 	/* The connection exists already, we just use this function to obtain
 	 * the browser.
 	 * TODO: There should be a
 	 * inf_gtk_browser_store_find_browser_for_connection() function */
 	InfBrowser* browser = inf_gtk_browser_store_add_connection(
-		m_browser_store, INF_XML_CONNECTION(by), "");
+		m_store.get_store(), INF_XML_CONNECTION(by), "");
 
 	set_selected(browser, NULL);
 }
@@ -374,26 +274,116 @@ void Gobby::Browser::on_expanded_changed()
 	}
 }
 
-void Gobby::Browser::on_set_browser(GtkTreeIter* iter,
-                                    InfBrowser* old_browser,
-                                    InfBrowser* new_browser)
+void Gobby::Browser::on_row_expanded(GtkTreeIter* iter, bool expanded)
 {
-	if(new_browser)
+	InfBrowser* browser;
+	InfBrowserIter* browser_iter;
+
+	gtk_tree_model_get(GTK_TREE_MODEL(m_sort_model), iter,
+	                   INF_GTK_BROWSER_MODEL_COL_BROWSER, &browser,
+	                   INF_GTK_BROWSER_MODEL_COL_NODE, &browser_iter,
+	                   -1);
+
+	if(browser != NULL && browser_iter != NULL &&
+	   inf_browser_get_status(browser) == INF_BROWSER_OPEN)
+	{
+		m_store.get_explore_cache().set_expanded(
+			browser, browser_iter, expanded);
+	}
+
+	if(browser_iter != NULL) inf_browser_iter_free(browser_iter);
+	if(browser != NULL) g_object_unref(browser);
+}
+
+void Gobby::Browser::on_row_inserted(GtkTreePath* path)
+{
+	GtkTreeModel* model = GTK_TREE_MODEL(m_sort_model);
+	GtkTreeView* view = GTK_TREE_VIEW(m_browser_view);
+
+	// Top-level rows are servers, not children
+	if(gtk_tree_path_get_depth(path) < 2) return;
+
+	GtkTreePath* parent_path = gtk_tree_path_copy(path);
+	gtk_tree_path_up(parent_path);
+
+	// Only expand directories whose parent is shown expanded, or
+	// servers. All but the first child get past the first check.
+	bool expand = false;
+	if(!gtk_tree_view_row_expanded(view, parent_path))
 	{
-		if(INFC_IS_BROWSER(new_browser))
+		if(gtk_tree_path_get_depth(parent_path) == 1)
 		{
-			InfcBrowser* browser = INFC_BROWSER(new_browser);
-			infc_browser_add_plugin(browser, Plugins::C_TEXT);
-			infc_browser_add_plugin(browser, Plugins::C_CHAT);
+			expand = true;
 		}
-		else if(INFD_IS_DIRECTORY(new_browser))
+		else
 		{
-			InfdDirectory* directory =
-				INFD_DIRECTORY(new_browser);
-			infd_directory_add_plugin(directory, Plugins::D_TEXT);
-			infd_directory_add_plugin(directory, Plugins::D_CHAT);
+			GtkTreePath* grandparent_path =
+				gtk_tree_path_copy(parent_path);
+			gtk_tree_path_up(grandparent_path);
+			expand = gtk_tree_view_row_expanded(
+				view, grandparent_path);
+			gtk_tree_path_free(grandparent_path);
 		}
 	}
+
+	if(expand)
+	{
+		GtkTreeIter parent;
+		gtk_tree_model_get_iter(model, &parent, parent_path);
+
+		InfBrowser* browser;
+		InfBrowserIter* browser_iter;
+
+		gtk_tree_model_get(model, &parent,
+		                   INF_GTK_BROWSER_MODEL_COL_BROWSER, &browser,
+		                   INF_GTK_BROWSER_MODEL_COL_NODE,
+		                   &browser_iter,
+		                   -1);
+
+		expand = browser != NULL && browser_iter != NULL &&
+			m_store.get_explore_cache().get_expanded(
+				browser, browser_iter);
+
+		if(browser_iter != NULL) inf_browser_iter_free(browser_iter);
+		if(browser != NULL) g_object_unref(browser);
+	}
+
+	if(expand)
+		gtk_tree_view_expand_row(view, parent_path, FALSE);
+
+	// Explore directories that were expanded the last time once they
+	// are visible, like a click on their expander would. The code
+	// above expands them when their first child shows up.
+	if(gtk_tree_view_row_expanded(view, parent_path))
+	{
+		GtkTreeIter tree_iter;
+		gtk_tree_model_get_iter(model, &tree_iter, path);
+
+		InfBrowser* browser;
+		InfBrowserIter* browser_iter;
+
+		gtk_tree_model_get(model, &tree_iter,
+		                   INF_GTK_BROWSER_MODEL_COL_BROWSER, &browser,
+		                   INF_GTK_BROWSER_MODEL_COL_NODE,
+		                   &browser_iter,
+		                   -1);
+
+		if(browser != NULL && browser_iter != NULL &&
+		   inf_browser_is_subdirectory(browser, browser_iter) &&
+		   !inf_browser_get_explored(browser, browser_iter) &&
+		   inf_browser_get_pending_request(
+			browser, browser_iter, "explore-node") == NULL &&
+		   m_store.get_explore_cache().get_expanded(
+			browser, browser_iter))
+		{
+			inf_browser_explore(browser, browser_iter, NULL, NULL);
+		}
+
+		if(browser_iter != NULL) inf_browser_iter_free(browser_iter);
+		if(browser != NULL) g_object_unref(browser);
+	}
+
+	gtk_tree_path_free(parent_path);
 }
 
 void Gobby::Browser::on_activate(GtkTreeIter* iter)
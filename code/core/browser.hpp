@@ -17,13 +17,12 @@
 #ifndef _GOBBY_BROWSER_HPP_
 #define _GOBBY_BROWSER_HPP_
 
-#include "core/connectionmanager.hpp"
+#include "core/browserstore.hpp"
 #include "core/statusbar.hpp"
 #include "util/historyentry.hpp"
 
 #include <libinfgtk/inf-gtk-browser-store.h>
 #include <libinfgtk/inf-gtk-browser-view.h>
-#include <libinfgtk/inf-gtk-certificate-manager.h>
 #include <libinfgtk/inf-gtk-browser-model.h>
 #include <libinfgtk/inf-gtk-browser-model-sort.h>
 #include <libinfinity/common/inf-browser.h>
@@ -49,11 +48,12 @@ public:
 
 	Browser(Gtk::Window& parent,
 	        StatusBar& status_bar,
-	        ConnectionManager& connection_manager);
+	        BrowserStore& store,
+	        StateStore& state_store);
 	~Browser();
 
 	ConnectionManager& get_connection_manager()
-		{ return m_connection_manager; }
+		{ return m_store.get_connection_manager(); }
 
 	InfGtkBrowserModelSort* get_store() { return m_sort_model; }
 	const InfGtkBrowserModelSort* get_store() const {
@@ -61,6 +61,8 @@ public:
 	}
 
 	InfGtkBrowserView* get_view() { return m_browser_view; }
+	const NodeIndex& get_node_index() const
+		{ return m_store.get_node_index(); }
 
 	bool get_selected_browser(InfBrowser** browser);
 	bool get_selected_iter(InfBrowser* browser, InfBrowserIter* iter);
@@ -83,17 +85,6 @@ public:
 protected:
 	void init_accessibility();
 
-	static void on_set_browser_static(InfGtkBrowserModel* model,
-	                                  GtkTreePath* path,
-	                                  GtkTreeIter* iter,
-	                                  InfBrowser* old_browser,
-	                                  InfBrowser* new_browser,
-	                                  gpointer user_data)
-	{
-		static_cast<Browser*>(user_data)->on_set_browser(
-			iter, old_browser, new_browser);
-	}
-
 	static void on_activate_static(InfGtkBrowserView* view,
 	                               GtkTreeIter* iter,
 	                               gpointer user_data)
@@ -101,20 +92,42 @@ protected:
 		static_cast<Browser*>(user_data)->on_activate(iter);
 	}
 
+	static void on_row_expanded_static(GtkTreeView* tree_view,
+	                                   GtkTreeIter* iter,
+	                                   GtkTreePath* path,
+	                                   gpointer user_data)
+	{
+		static_cast<Browser*>(user_data)->on_row_expanded(iter, true);
+	}
+
+	static void on_row_collapsed_static(GtkTreeView* tree_view,
+	                                    GtkTreeIter* iter,
+	                                    GtkTreePath* path,
+	                                    gpointer user_data)
+	{
+		static_cast<Browser*>(user_data)->on_row_expanded(iter, false);
+	}
+
+	static void on_row_inserted_static(GtkTreeModel* model,
+	                                   GtkTreePath* path,
+	                                   GtkTreeIter* iter,
+	                                   gpointer user_data)
+	{
+		static_cast<Browser*>(user_data)->on_row_inserted(path);
+	}
+
 	void on_connection_replaced(InfXmppConnection* connection,
 	                            InfXmppConnection* by);
+	void on_row_expanded(GtkTreeIter* iter, bool expanded);
+	void on_row_inserted(GtkTreePath* path);
 	void on_expanded_changed();
-	void on_set_browser(GtkTreeIter* iter, InfBrowser* old_browser,
-	                    InfBrowser* new_browser);
 	void on_activate(GtkTreeIter* iter);
 	void on_hostname_activate();
 
 	Gtk::Window& m_parent;
 	StatusBar& m_status_bar;
-	ConnectionManager& m_connection_manager;
+	BrowserStore& m_store;
 
-	InfGtkCertificateManager* m_cert_checker;
-	InfGtkBrowserStore* m_browser_store;
 	InfGtkBrowserView* m_browser_view;
 	Gtk::ScrolledWindow m_scroll;
 
@@ -125,6 +138,10 @@ protected:
 
 	InfGtkBrowserModelSort* m_sort_model;
 
+	gulong m_row_expanded_handler;
+	gulong m_row_collapsed_handler;
+	gulong m_row_inserted_handler;
+
 	SignalConnect m_signal_connect;
 	SignalActivate m_signal_activate;
 };
@@ -0,0 +1,349 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/browserstore.hpp"
+#include "core/noteplugin.hpp"
+
+#include <libinfinity/client/infc-browser.h>
+
+#include <vector>
+
+Gobby::BrowserStore::BrowserStore(ConnectionManager& connection_manager,
+                                  StateStore& state_store):
+	m_connection_manager(connection_manager),
+	m_store(inf_gtk_browser_store_new(
+		connection_manager.get_io(),
+		connection_manager.get_communication_manager())),
+	m_node_index(INF_GTK_BROWSER_MODEL(m_store)),
+	m_explore_cache(INF_GTK_BROWSER_MODEL(m_store), state_store)
+{
+	if(m_connection_manager.get_discovery() != NULL)
+	{
+		inf_gtk_browser_store_add_discovery(
+			m_store, m_connection_manager.get_discovery());
+	}
+
+	m_set_browser_handler = g_signal_connect(
+		m_store, "set-browser",
+		G_CALLBACK(&on_set_browser_static), this);
+
+	// These need to run before the handlers of the sort models, which
+	// are created later, so that they never see outdated keys.
+	m_row_changed_handler = g_signal_connect(
+		m_store, "row-changed",
+		G_CALLBACK(&on_row_changed_static), this);
+	m_row_deleted_handler = g_signal_connect(
+		m_store, "row-deleted",
+		G_CALLBACK(&on_row_deleted_static), this);
+
+	m_connection_manager.signal_connection_replaced().connect(
+		sigc::mem_fun(*this, &BrowserStore::on_connection_replaced));
+}
+
+Gobby::BrowserStore::~BrowserStore()
+{
+	g_signal_handler_disconnect(m_store, m_set_browser_handler);
+	g_signal_handler_disconnect(m_store, m_row_changed_handler);
+	g_signal_handler_disconnect(m_store, m_row_deleted_handler);
+
+	for(BrowserMap::iterator iter = m_browsers.begin();
+	    iter != m_browsers.end(); ++iter)
+	{
+		g_signal_handler_disconnect(
+			iter->first, iter->second.node_removed_handler);
+		g_signal_handler_disconnect(
+			iter->first, iter->second.notify_status_handler);
+	}
+
+	g_object_unref(m_store);
+}
+
+InfBrowser* Gobby::BrowserStore::add_remote(const std::string& hostname,
+                                            const std::string& service,
+                                            unsigned int device_index,
+                                            bool connect)
+{
+	// Check whether we do have such a connection already:
+	InfXmppConnection* xmpp = m_connection_manager.make_connection(
+		hostname, service, device_index, connect);
+
+	// Should have thrown otherwise:
+	g_assert(xmpp != NULL);
+
+	// TODO: Remove erroneous entry with same name, if any, before
+	// adding.
+
+	return inf_gtk_browser_store_add_connection(
+		m_store, INF_XML_CONNECTION(xmpp), hostname.c_str());
+}
+
+InfBrowser* Gobby::BrowserStore::add_remote(const InfIpAddress* address,
+                                            guint port,
+                                            unsigned int device_index,
+                                            const std::string& hostname,
+                                            bool connect)
+{
+	// Check whether we do have such a connection already:
+	InfXmppConnection* xmpp = m_connection_manager.make_connection(
+		address, port, device_index, hostname, connect);
+
+	// Should have thrown otherwise:
+	g_assert(xmpp != NULL);
+
+	// TODO: Remove erroneous entry with same name, if any, before
+	// adding.
+
+	return inf_gtk_browser_store_add_connection(
+		m_store, INF_XML_CONNECTION(xmpp), hostname.c_str());
+}
+
+void Gobby::BrowserStore::add_browser(InfBrowser* browser,
+                                      const char* name)
+{
+	inf_gtk_browser_store_add_browser(m_store, browser, name);
+}
+
+void Gobby::BrowserStore::remove_browser(InfBrowser* browser)
+{
+	m_connection_manager.remove_connection(
+		INF_XMPP_CONNECTION(
+			infc_browser_get_connection(
+				INFC_BROWSER(browser))));
+
+	inf_gtk_browser_store_remove_browser(m_store, browser);
+}
+
+const char* Gobby::BrowserStore::get_sort_key(GtkTreeIter* iter)
+{
+	const RowKey row(iter);
+	SortKeyMap::iterator map_iter = m_sort_keys.find(row);
+	if(map_iter != m_sort_keys.end() && map_iter->second.valid)
+		return map_iter->second.key.c_str();
+
+	GtkTreeModel* model = GTK_TREE_MODEL(m_store);
+
+	// Servers are sorted by name only
+	InfBrowser* browser = NULL;
+	InfBrowserIter* browser_iter = NULL;
+	bool is_subdirectory = false;
+	GtkTreeIter parent;
+	if(gtk_tree_model_iter_parent(model, &parent, iter))
+	{
+		gtk_tree_model_get(
+			model, iter,
+			INF_GTK_BROWSER_MODEL_COL_BROWSER, &browser,
+			INF_GTK_BROWSER_MODEL_COL_NODE, &browser_iter,
+			-1);
+
+		is_subdirectory =
+			inf_browser_is_subdirectory(browser, browser_iter);
+	}
+
+	gchar* name;
+	gtk_tree_model_get(
+		model, iter, INF_GTK_BROWSER_MODEL_COL_NAME, &name, -1);
+
+	gchar* casefolded = g_utf8_casefold(name, -1);
+	gchar* collate_key = g_utf8_collate_key(casefolded, -1);
+
+	std::string key(is_subdirectory ? "0" : "1");
+	key += collate_key;
+
+	g_free(name);
+	g_free(casefolded);
+	g_free(collate_key);
+
+	if(map_iter == m_sort_keys.end())
+	{
+		SortKey sort_key;
+		sort_key.browser = browser;
+		sort_key.node_id = browser_iter ? browser_iter->node_id : 0;
+
+		map_iter = m_sort_keys.insert(
+			SortKeyMap::value_type(row, sort_key)).first;
+
+		if(browser != NULL)
+		{
+			const NodeKey node(browser, browser_iter->node_id);
+			m_node_rows.insert(NodeRowMap::value_type(node, row));
+
+			InfBrowserIter parent_iter = *browser_iter;
+			if(inf_browser_get_parent(browser, &parent_iter))
+			{
+				m_children.insert(ChildMap::value_type(
+					NodeKey(browser, parent_iter.node_id),
+					node));
+			}
+		}
+	}
+
+	if(browser != NULL)
+	{
+		g_object_unref(browser);
+		inf_browser_iter_free(browser_iter);
+	}
+
+	// Elements of the map stay where they are when others are added,
+	// so the returned key remains valid while the row exists.
+	map_iter->second.key.swap(key);
+	map_iter->second.valid = true;
+	return map_iter->second.key.c_str();
+}
+
+void Gobby::BrowserStore::on_set_browser(InfBrowser* old_browser,
+                                         InfBrowser* new_browser)
+{
+	if(old_browser != NULL)
+	{
+		BrowserMap::iterator map_iter = m_browsers.find(old_browser);
+		g_assert(map_iter != m_browsers.end());
+
+		g_signal_handler_disconnect(
+			old_browser, map_iter->second.node_removed_handler);
+		g_signal_handler_disconnect(
+			old_browser, map_iter->second.notify_status_handler);
+
+		m_browsers.erase(map_iter);
+		remove_browser_keys(old_browser);
+	}
+
+	if(new_browser != NULL)
+	{
+		g_assert(m_browsers.find(new_browser) == m_browsers.end());
+		BrowserInfo& info = m_browsers[new_browser];
+
+		info.node_removed_handler = g_signal_connect(
+			G_OBJECT(new_browser), "node-removed",
+			G_CALLBACK(on_node_removed_static), this);
+		info.notify_status_handler = g_signal_connect(
+			G_OBJECT(new_browser), "notify::status",
+			G_CALLBACK(on_notify_status_static), this);
+	}
+
+	// The local directory gets its plugins from the self hoster
+	if(new_browser && INFC_IS_BROWSER(new_browser))
+	{
+		InfcBrowser* browser = INFC_BROWSER(new_browser);
+		infc_browser_add_plugin(browser, Plugins::C_TEXT);
+		infc_browser_add_plugin(browser, Plugins::C_CHAT);
+	}
+}
+
+void Gobby::BrowserStore::on_node_removed(InfBrowser* browser,
+                                          InfBrowserIter* iter)
+{
+	remove_node_key(NodeKey(browser, iter->node_id));
+}
+
+void Gobby::BrowserStore::on_notify_status(InfBrowser* browser)
+{
+	InfBrowserStatus status;
+	g_object_get(G_OBJECT(browser), "status", &status, NULL);
+
+	// The nodes go away with the connection, and their IDs might be
+	// used for other nodes after reconnecting.
+	if(status == INF_BROWSER_CLOSED)
+		remove_browser_keys(browser);
+}
+
+void Gobby::BrowserStore::on_row_changed(GtkTreeIter* iter)
+{
+	// The row might have been renamed
+	SortKeyMap::iterator map_iter = m_sort_keys.find(RowKey(iter));
+	if(map_iter != m_sort_keys.end())
+		map_iter->second.valid = false;
+}
+
+void Gobby::BrowserStore::on_row_deleted(GtkTreePath* path)
+{
+	// Rows of nodes are removed with the nodes, but for a server we
+	// only learn that some top-level row has gone away. There are only
+	// few of them, so drop the keys of all servers.
+	if(gtk_tree_path_get_depth(path) != 1) return;
+
+	for(SortKeyMap::iterator iter = m_sort_keys.begin();
+	    iter != m_sort_keys.end(); )
+	{
+		if(iter->second.browser == NULL)
+			iter = m_sort_keys.erase(iter);
+		else
+			++iter;
+	}
+}
+
+void Gobby::BrowserStore::remove_node_key(const NodeKey& node)
+{
+	NodeRowMap::iterator row_iter = m_node_rows.find(node);
+	if(row_iter != m_node_rows.end())
+	{
+		m_sort_keys.erase(row_iter->second);
+		m_node_rows.erase(row_iter);
+	}
+
+	std::pair<ChildMap::iterator, ChildMap::iterator> range =
+		m_children.equal_range(node);
+
+	std::vector<NodeKey> children;
+	for(ChildMap::iterator iter = range.first;
+	    iter != range.second; ++iter)
+	{
+		children.push_back(iter->second);
+	}
+
+	m_children.erase(range.first, range.second);
+
+	for(std::vector<NodeKey>::const_iterator iter = children.begin();
+	    iter != children.end(); ++iter)
+	{
+		remove_node_key(*iter);
+	}
+}
+
+void Gobby::BrowserStore::remove_browser_keys(InfBrowser* browser)
+{
+	NodeRowMap::iterator row_end =
+		m_node_rows.lower_bound(NodeKey(browser, 0));
+	const NodeRowMap::iterator row_begin = row_end;
+	while(row_end != m_node_rows.end() &&
+	      row_end->first.first == browser)
+	{
+		m_sort_keys.erase(row_end->second);
+		++row_end;
+	}
+
+	m_node_rows.erase(row_begin, row_end);
+
+	ChildMap::iterator child_end =
+		m_children.lower_bound(NodeKey(browser, 0));
+	const ChildMap::iterator child_begin = child_end;
+	while(child_end != m_children.end() &&
+	      child_end->first.first == browser)
+	{
+		++child_end;
+	}
+
+	m_children.erase(child_begin, child_end);
+}
+
+void Gobby::BrowserStore::on_connection_replaced(
+	InfXmppConnection* connection,
+	InfXmppConnection* by)
+{
+	// Remove the browser for the replaced connection. The browsers of
+	// the windows then highlight the one it was replaced with.
+	inf_gtk_browser_store_remove_connection(
+		m_store, INF_XML_CONNECTION(connection));
+}
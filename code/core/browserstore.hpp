@@ -0,0 +1,204 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_BROWSERSTORE_HPP_
+#define _GOBBY_BROWSERSTORE_HPP_
+
+#include "core/connectionmanager.hpp"
+#include "core/explorecache.hpp"
+#include "core/nodeindex.hpp"
+
+#include <libinfgtk/inf-gtk-browser-store.h>
+#include <libinfinity/common/inf-browser.h>
+
+#include <sigc++/trackable.h>
+
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace Gobby
+{
+
+// The list of servers and their document trees, shared by all windows. Each
+// window shows it in its own Browser, but there is only one InfBrowser per
+// connection, so that all windows see the same subscriptions.
+class BrowserStore: public sigc::trackable
+{
+public:
+	BrowserStore(ConnectionManager& connection_manager,
+	             StateStore& state_store);
+	~BrowserStore();
+
+	ConnectionManager& get_connection_manager()
+		{ return m_connection_manager; }
+
+	InfGtkBrowserStore* get_store() { return m_store; }
+	const NodeIndex& get_node_index() const { return m_node_index; }
+	ExploreCache& get_explore_cache() { return m_explore_cache; }
+
+	InfBrowser* add_remote(const std::string& hostname,
+	                       const std::string& service,
+	                       unsigned int device_index,
+	                       bool connect);
+	InfBrowser* add_remote(const InfIpAddress* address, guint port,
+	                       unsigned int device_index,
+	                       const std::string& hostname,
+	                       bool connect);
+	void add_browser(InfBrowser* browser, const char* name);
+	void remove_browser(InfBrowser* browser);
+
+	// Returns a key for sorting the row of the store at iter:
+	// directories come before documents, then rows are sorted
+	// case-insensitively by name. Two keys can be compared with
+	// std::strcmp(). Keys are cached until their row is renamed or
+	// removed, so that sorting large directories does not need to look
+	// up and collate the names for every single comparison.
+	const char* get_sort_key(GtkTreeIter* iter);
+
+protected:
+	static void on_set_browser_static(InfGtkBrowserModel* model,
+	                                  GtkTreePath* path,
+	                                  GtkTreeIter* iter,
+	                                  InfBrowser* old_browser,
+	                                  InfBrowser* new_browser,
+	                                  gpointer user_data)
+	{
+		static_cast<BrowserStore*>(user_data)->on_set_browser(
+			old_browser, new_browser);
+	}
+
+	static void on_node_removed_static(InfBrowser* browser,
+	                                   InfBrowserIter* iter,
+	                                   InfRequest* request,
+	                                   gpointer user_data)
+	{
+		static_cast<BrowserStore*>(user_data)->on_node_removed(
+			browser, iter);
+	}
+
+	static void on_notify_status_static(GObject* object,
+	                                    GParamSpec* pspec,
+	                                    gpointer user_data)
+	{
+		static_cast<BrowserStore*>(user_data)->on_notify_status(
+			INF_BROWSER(object));
+	}
+
+	static void on_row_changed_static(GtkTreeModel* model,
+	                                  GtkTreePath* path,
+	                                  GtkTreeIter* iter,
+	                                  gpointer user_data)
+	{
+		static_cast<BrowserStore*>(user_data)->on_row_changed(iter);
+	}
+
+	static void on_row_deleted_static(GtkTreeModel* model,
+	                                  GtkTreePath* path,
+	                                  gpointer user_data)
+	{
+		static_cast<BrowserStore*>(user_data)->on_row_deleted(path);
+	}
+
+	void on_set_browser(InfBrowser* old_browser, InfBrowser* new_browser);
+	void on_node_removed(InfBrowser* browser, InfBrowserIter* iter);
+	void on_notify_status(InfBrowser* browser);
+	void on_row_changed(GtkTreeIter* iter);
+	void on_row_deleted(GtkTreePath* path);
+	void on_connection_replaced(InfXmppConnection* connection,
+	                            InfXmppConnection* by);
+
+	ConnectionManager& m_connection_manager;
+	InfGtkBrowserStore* m_store;
+	NodeIndex m_node_index;
+	ExploreCache m_explore_cache;
+
+	gulong m_set_browser_handler;
+	gulong m_row_changed_handler;
+	gulong m_row_deleted_handler;
+
+	// The store's iterators persist, so their contents identify a row
+	// for as long as it exists.
+	struct RowKey
+	{
+		RowKey(const GtkTreeIter* iter):
+			user_data(iter->user_data),
+			user_data2(iter->user_data2),
+			user_data3(iter->user_data3) {}
+
+		bool operator==(const RowKey& other) const
+		{
+			return user_data == other.user_data &&
+			       user_data2 == other.user_data2 &&
+			       user_data3 == other.user_data3;
+		}
+
+		gpointer user_data;
+		gpointer user_data2;
+		gpointer user_data3;
+	};
+
+	struct RowKeyHash
+	{
+		std::size_t operator()(const RowKey& key) const
+		{
+			return g_direct_hash(key.user_data) ^
+			       (g_direct_hash(key.user_data2) * 31) ^
+			       (g_direct_hash(key.user_data3) * 131);
+		}
+	};
+
+	typedef std::pair<InfBrowser*, guint> NodeKey;
+
+	struct SortKey
+	{
+		std::string key;
+		// False if the row has been renamed since the key was made
+		bool valid;
+		// The node of the row, or NULL for the top-level rows of
+		// the servers
+		InfBrowser* browser;
+		guint node_id;
+	};
+
+	struct BrowserInfo
+	{
+		gulong node_removed_handler;
+		gulong notify_status_handler;
+	};
+
+	void remove_node_key(const NodeKey& node);
+	void remove_browser_keys(InfBrowser* browser);
+
+	typedef std::unordered_map<RowKey, SortKey, RowKeyHash> SortKeyMap;
+	SortKeyMap m_sort_keys;
+
+	// Rows of the nodes that have a key, to remove it when the node is
+	// removed, and the nodes with a key below each node. Removing a
+	// subdirectory does not emit node-removed for its children.
+	typedef std::map<NodeKey, RowKey> NodeRowMap;
+	NodeRowMap m_node_rows;
+	typedef std::multimap<NodeKey, NodeKey> ChildMap;
+	ChildMap m_children;
+
+	typedef std::map<InfBrowser*, BrowserInfo> BrowserMap;
+	BrowserMap m_browsers;
+};
+
+}
+
+#endif // _GOBBY_BROWSERSTORE_HPP_
@@ -17,16 +17,317 @@
 #include "core/certificatemanager.hpp"
 #include "util/file.hpp"
 #include "util/i18n.hpp"
+#include "util/startupprofile.hpp"
 
 #include <libinfinity/common/inf-cert-util.h>
 
+#include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
 
+// GnuTLS 3.5.6 introduced the RFC 7919 FFDHE groups, which make the
+// generation of our own DH parameters unnecessary.
+#if GNUTLS_VERSION_NUMBER >= 0x030506
+# define GOBBY_HAVE_KNOWN_DH_PARAMS
+#endif
+
+namespace
+{
+	GQuark certificate_manager_error_quark()
+	{
+		return g_quark_from_static_string(
+			"GOBBY_CERTIFICATE_MANAGER_ERROR");
+	}
+
+	gnutls_dh_params_t read_dh_params()
+	{
+		const std::string filename =
+			Gobby::config_filename("dh_params.pem");
+
+		GError* error = NULL;
+		gnutls_dh_params_t dh_params =
+			inf_cert_util_read_dh_params(filename.c_str(), &error);
+
+		if(error != NULL)
+		{
+			if(error->domain != G_FILE_ERROR ||
+			   error->code != G_FILE_ERROR_NOENT)
+			{
+				g_warning(_("Failed to read Diffie-Hellman "
+				            "parameters: %s"),
+				          error->message);
+			}
+
+			g_error_free(error);
+		}
+
+		return dh_params;
+	}
+
+	// Returns the certificates in the given file, or NULL if an error
+	// occurs.
+	gnutls_x509_crt_t* read_certificates(const std::string& filename,
+	                                     guint& n_certs,
+	                                     GError** error)
+	{
+		GPtrArray* array = inf_cert_util_read_certificate(
+			filename.c_str(), NULL, error);
+		if(array == NULL) return NULL;
+
+		n_certs = array->len;
+		gnutls_x509_crt_t* certs =
+			reinterpret_cast<gnutls_x509_crt_t*>(
+				g_ptr_array_free(array, FALSE));
+
+		if(n_certs == 0)
+		{
+			g_set_error(
+				error,
+				certificate_manager_error_quark(),
+				1,
+				"%s",
+				_("File does not contain a "
+				  "X.509 certificate")
+			);
+
+			g_free(certs);
+			return NULL;
+		}
+
+		return certs;
+	}
+
+	void read_trust(const std::string& filename,
+	                std::vector<gnutls_x509_crt_t>& trust,
+	                GError** error)
+	{
+		if(filename.empty()) return;
+
+		GPtrArray* array = inf_cert_util_read_certificate(
+			filename.c_str(), NULL, error);
+		if(array != NULL)
+		{
+			guint n_certs = array->len;
+			gnutls_x509_crt_t* certs =
+				reinterpret_cast<gnutls_x509_crt_t*>(
+					g_ptr_array_free(array, FALSE));
+			trust.assign(certs, certs + n_certs);
+			g_free(certs);
+		}
+	}
+
+	// Drops the certificates and sets error if they do not belong to
+	// the given key.
+	void check_certificate_key(InfCertificateChain*& certificates,
+	                           gnutls_x509_privkey_t key,
+	                           GError** error)
+	{
+		if(!key || !certificates) return;
+
+		gnutls_x509_crt_t crt =
+			inf_certificate_chain_get_own_certificate(
+				certificates);
+		if(!inf_cert_util_check_certificate_key(crt, key))
+		{
+			inf_certificate_chain_unref(certificates);
+			certificates = NULL;
+
+			g_set_error(
+				error,
+				certificate_manager_error_quark(),
+				0,
+				"%s",
+				_("Certificate does not belong to the "
+				  "chosen key")
+			);
+		}
+	}
+
+	// Pass NULL for key and certificates if authentication is
+	// disabled. Adding the system CAs is what makes this expensive.
+	InfCertificateCredentials*
+	create_credentials(gnutls_x509_privkey_t key,
+	                   InfCertificateChain* certificates,
+	                   bool use_system_trust,
+	                   const std::vector<gnutls_x509_crt_t>& trust,
+	                   gnutls_dh_params_t dh_params)
+	{
+		InfCertificateCredentials* creds =
+			inf_certificate_credentials_new();
+		gnutls_certificate_credentials_t gnutls_creds =
+			inf_certificate_credentials_get(creds);
+
+		if(key != NULL && certificates != NULL)
+		{
+			gnutls_certificate_set_x509_key(
+				gnutls_creds,
+				inf_certificate_chain_get_raw(certificates),
+				inf_certificate_chain_get_n_certificates(
+					certificates),
+				key
+			);
+		}
+
+		if(use_system_trust)
+		{
+			const int n_cas =
+				gnutls_certificate_set_x509_system_trust(
+					gnutls_creds);
+			if(n_cas < 0)
+			{
+				g_warning("Failed to add system CAs: %s\n",
+					gnutls_strerror(n_cas));
+			}
+		}
+
+		if(!trust.empty())
+		{
+			gnutls_certificate_set_x509_trust(
+				gnutls_creds,
+				&trust[0],
+				trust.size()
+			);
+		}
+
+		if(dh_params != NULL)
+		{
+			gnutls_certificate_set_dh_params(
+				gnutls_creds, dh_params);
+		}
+#ifdef GOBBY_HAVE_KNOWN_DH_PARAMS
+		else
+		{
+			gnutls_certificate_set_known_dh_params(
+				gnutls_creds, GNUTLS_SEC_PARAM_MEDIUM);
+		}
+#endif
+
+		gnutls_certificate_set_verify_flags(
+			gnutls_creds, GNUTLS_VERIFY_ALLOW_X509_V1_CA_CRT);
+
+		return creds;
+	}
+}
+
+// Everything that is read in the background on startup
+struct Gobby::CertificateManager::LoadResult
+{
+	LoadResult():
+		dh_params(NULL), key(NULL), key_error(NULL),
+		certificates(NULL), certificate_error(NULL),
+		trust_error(NULL), credentials(NULL)
+	{
+	}
+
+	// Frees whatever has not been taken over by the manager
+	~LoadResult()
+	{
+		if(credentials != NULL)
+			inf_certificate_credentials_unref(credentials);
+		if(trust_error != NULL)
+			g_error_free(trust_error);
+		for(unsigned int i = 0; i < trust.size(); ++i)
+			gnutls_x509_crt_deinit(trust[i]);
+		if(certificate_error != NULL)
+			g_error_free(certificate_error);
+		if(certificates != NULL)
+			inf_certificate_chain_unref(certificates);
+		if(key_error != NULL)
+			g_error_free(key_error);
+		if(key != NULL)
+			gnutls_x509_privkey_deinit(key);
+		if(dh_params != NULL)
+			gnutls_dh_params_deinit(dh_params);
+	}
+
+	gnutls_dh_params_t dh_params;
+	gnutls_x509_privkey_t key;
+	GError* key_error;
+	InfCertificateChain* certificates;
+	GError* certificate_error;
+	std::vector<gnutls_x509_crt_t> trust;
+	GError* trust_error;
+	InfCertificateCredentials* credentials;
+};
+
+class Gobby::CertificateManager::Loader: public AsyncOperation
+{
+public:
+	Loader(CertificateManager& manager,
+	       std::promise<std::unique_ptr<LoadResult> > promise):
+		m_manager(manager), m_promise(std::move(promise)),
+		m_key_file(manager.m_preferences.security.key_file),
+		m_certificate_file(
+			manager.m_preferences.security.certificate_file),
+		m_trusted_cas(manager.m_preferences.security.trusted_cas),
+		m_use_system_trust(
+			manager.m_preferences.security.use_system_trust),
+		m_authentication_enabled(
+			manager.m_preferences.security.authentication_enabled)
+	{
+	}
+
+protected:
+	virtual void run()
+	{
+		std::unique_ptr<LoadResult> result(new LoadResult);
+
+		result->dh_params = read_dh_params();
+
+		if(!m_key_file.empty())
+		{
+			result->key = inf_cert_util_read_private_key(
+				m_key_file.c_str(), &result->key_error);
+		}
+
+		if(!m_certificate_file.empty())
+		{
+			guint n_certs;
+			gnutls_x509_crt_t* certs = read_certificates(
+				m_certificate_file, n_certs,
+				&result->certificate_error);
+			if(certs != NULL)
+			{
+				result->certificates =
+					inf_certificate_chain_new(
+						certs, n_certs);
+			}
+		}
+
+		check_certificate_key(result->certificates, result->key,
+		                      &result->certificate_error);
+
+		read_trust(m_trusted_cas, result->trust,
+		           &result->trust_error);
+
+		result->credentials = create_credentials(
+			m_authentication_enabled ? result->key : NULL,
+			result->certificates, m_use_system_trust,
+			result->trust, result->dh_params);
+
+		m_promise.set_value(std::move(result));
+	}
+
+	virtual void finish()
+	{
+		m_manager.wait();
+	}
+
+private:
+	CertificateManager& m_manager;
+	std::promise<std::unique_ptr<LoadResult> > m_promise;
+
+	const std::string m_key_file;
+	const std::string m_certificate_file;
+	const std::string m_trusted_cas;
+	const bool m_use_system_trust;
+	const bool m_authentication_enabled;
+};
+
 Gobby::CertificateManager::CertificateManager(Preferences& preferences):
 	m_preferences(preferences),
 	m_dh_params(NULL), m_key(NULL), m_certificates(NULL),
 	m_credentials(NULL), m_key_error(NULL), m_certificate_error(NULL),
-	m_trust_error(NULL)
+	m_trust_error(NULL), m_loaded(false)
 {
 	m_conn_key_file = m_preferences.security.key_file.
 		signal_changed().connect(sigc::mem_fun(
@@ -49,13 +350,15 @@ Gobby::CertificateManager::CertificateManager(Preferences& preferences):
 				 &CertificateManager::
 					on_authentication_enabled_changed));
 
-	// TODO: Load these only on request, to improve the startup time
-	load_dh_params();
-	load_key();
-	load_certificate();
-	load_trust();
+	// Use empty credentials until everything has been loaded
+	m_credentials = create_credentials(NULL, NULL, false, m_trust, NULL);
 
-	make_credentials();
+	std::promise<std::unique_ptr<LoadResult> > promise;
+	m_load_result = promise.get_future();
+	m_load_handle = AsyncOperation::start(
+		std::unique_ptr<AsyncOperation>(
+			new Loader(*this, std::move(promise))),
+		WorkerPool::PRIORITY_HIGH);
 }
 
 Gobby::CertificateManager::~CertificateManager()
@@ -72,8 +375,46 @@ Gobby::CertificateManager::~CertificateManager()
 		gnutls_dh_params_deinit(m_dh_params);
 }
 
+void Gobby::CertificateManager::wait()
+{
+	if(m_loaded) return;
+	m_loaded = true;
+
+	// This blocks if the loader is still running
+	std::unique_ptr<LoadResult> result = m_load_result.get();
+	m_load_handle.reset();
+
+	g_assert(m_dh_params == NULL && m_key == NULL &&
+	         m_certificates == NULL && m_trust.empty());
+
+	std::swap(m_dh_params, result->dh_params);
+	std::swap(m_key, result->key);
+	std::swap(m_key_error, result->key_error);
+	std::swap(m_certificates, result->certificates);
+	std::swap(m_certificate_error, result->certificate_error);
+	std::swap(m_trust, result->trust);
+	std::swap(m_trust_error, result->trust_error);
+
+	// The result frees the preliminary credentials
+	std::swap(m_credentials, result->credentials);
+	startup_profile_mark("certificates");
+
+	m_signal_credentials_changed.emit();
+}
+
+bool Gobby::CertificateManager::needs_dh_params() const
+{
+#ifdef GOBBY_HAVE_KNOWN_DH_PARAMS
+	return false;
+#else
+	return m_dh_params == NULL;
+#endif
+}
+
 void Gobby::CertificateManager::set_dh_params(gnutls_dh_params_t dh_params)
 {
+	wait();
+
 	gnutls_dh_params_t old_dh_params = m_dh_params;
 
 	GError* error = NULL;
@@ -110,6 +451,7 @@ void Gobby::CertificateManager::set_private_key(gnutls_x509_privkey_t key,
                                                 const GError* error)
 {
 	g_assert(key == NULL || error == NULL);
+	wait();
 
 	gnutls_x509_privkey_t old_key = m_key;
 	InfCertificateChain* old_certificates = m_certificates;
@@ -195,6 +537,7 @@ void Gobby::CertificateManager::set_certificates(gnutls_x509_crt_t* certs,
                                                  const GError* error)
 {
 	g_assert(n_certs == 0 || error == NULL);
+	wait();
 
 	InfCertificateChain* old_certificates = m_certificates;
 	m_certificates = NULL;
@@ -263,31 +606,6 @@ void Gobby::CertificateManager::set_certificates(gnutls_x509_crt_t* certs,
 	}
 }
 
-void Gobby::CertificateManager::load_dh_params()
-{
-	const std::string filename = config_filename("dh_params.pem");
-
-	GError* error = NULL;
-	gnutls_dh_params_t dh_params =
-		inf_cert_util_read_dh_params(filename.c_str(), &error);
-
-	if(error != NULL)
-	{
-		if(error->domain != G_FILE_ERROR ||
-		   error->code != G_FILE_ERROR_NOENT)
-		{
-			g_warning(_("Failed to read Diffie-Hellman "
-			            "parameters: %s"),
-			          error->message);
-		}
-
-		g_error_free(error);
-	}
-
-	if(dh_params != NULL)
-		set_dh_params(dh_params);
-}
-
 void Gobby::CertificateManager::load_key()
 {
 	const std::string& filename = m_preferences.security.key_file;
@@ -315,38 +633,13 @@ void Gobby::CertificateManager::load_certificate()
 	if(!filename.empty())
 	{
 		GError* error = NULL;
-		GPtrArray* array = inf_cert_util_read_certificate(
-			filename.c_str(), NULL, &error);
-		if(array != NULL)
-		{
-			g_assert(error == NULL);
-			guint n_certs = array->len;
-			gnutls_x509_crt_t* certs =
-				reinterpret_cast<gnutls_x509_crt_t*>(
-					g_ptr_array_free(array, FALSE));
+		guint n_certs;
+		gnutls_x509_crt_t* certs =
+			read_certificates(filename, n_certs, &error);
 
-			if(n_certs > 0)
-			{
-				set_certificates(certs, n_certs, NULL);
-			}
-			else
-			{
-				g_set_error(
-					&error,
-					g_quark_from_static_string(
-						"GOBBY_CERTIFICATE_MANAGER_"
-						"ERROR"),
-					1,
-					"%s",
-					_("File does not contain a "
-					  "X.509 certificate")
-				);
-				
-				set_certificates(NULL, 0, error);
-
-				g_error_free(error);
-				g_free(certs);
-			}
+		if(certs != NULL)
+		{
+			set_certificates(certs, n_certs, NULL);
 		}
 		else
 		{
@@ -367,22 +660,7 @@ void Gobby::CertificateManager::load_trust()
 	old_trust.swap(m_trust);
 
 	GError* error = NULL;
-	const std::string& filename = m_preferences.security.trusted_cas;
-
-	if(!filename.empty())
-	{
-		GPtrArray* array = inf_cert_util_read_certificate(
-			filename.c_str(), NULL, &error);
-		if(array != NULL)
-		{
-			guint n_certs = array->len;
-			gnutls_x509_crt_t* certs =
-				reinterpret_cast<gnutls_x509_crt_t*>(
-					g_ptr_array_free(array, FALSE));
-			m_trust.assign(certs, certs + n_certs);
-			g_free(certs);
-		}
-	}
+	read_trust(m_preferences.security.trusted_cas, m_trust, &error);
 
 	if(m_trust_error != NULL)
 		g_error_free(m_trust_error);
@@ -401,66 +679,17 @@ void Gobby::CertificateManager::check_certificate_signature()
 	if(!m_key || !m_certificates) return;
 	g_assert(m_key_error == NULL && m_certificate_error == NULL);
 
-	gnutls_x509_crt_t crt =
-		inf_certificate_chain_get_own_certificate(m_certificates);
-	if(!inf_cert_util_check_certificate_key(crt, m_key))
-	{
-		inf_certificate_chain_unref(m_certificates);
-		m_certificates = NULL;
-
-		g_set_error(
-			&m_certificate_error,
-			g_quark_from_static_string(
-				"GOBBY_CERTIFICATE_MANAGER_ERROR"),
-			0,
-			"%s",
-			_("Certificate does not belong to the chosen key")
-		);
-	}
+	check_certificate_key(m_certificates, m_key, &m_certificate_error);
 }
 
 void Gobby::CertificateManager::make_credentials()
 {
-	InfCertificateCredentials* creds = inf_certificate_credentials_new();
-	gnutls_certificate_credentials_t gnutls_creds =
-		inf_certificate_credentials_get(creds);
-
-	if(m_preferences.security.authentication_enabled &&
-	   m_key != NULL && m_certificates != NULL)
-	{
-		gnutls_certificate_set_x509_key(
-			gnutls_creds,
-			inf_certificate_chain_get_raw(m_certificates),
-			inf_certificate_chain_get_n_certificates(m_certificates),
-			m_key
-		);
-	}
-
-	if(m_preferences.security.use_system_trust)
-	{
-		const int n_cas = gnutls_certificate_set_x509_system_trust(
-			gnutls_creds);
-		if(n_cas < 0)
-		{
-			g_warning("Failed to add system CAs: %s\n",
-				gnutls_strerror(n_cas));
-		}
-	}
-
-	if(!m_trust.empty())
-	{
-		gnutls_certificate_set_x509_trust(
-			gnutls_creds,
-			&m_trust[0],
-			m_trust.size()
-		);
-	}
-
-	if(m_dh_params != NULL)
-		gnutls_certificate_set_dh_params(gnutls_creds, m_dh_params);
+	const bool use_key = m_preferences.security.authentication_enabled;
 
-	gnutls_certificate_set_verify_flags(
-		gnutls_creds, GNUTLS_VERIFY_ALLOW_X509_V1_CA_CRT);
+	InfCertificateCredentials* creds = create_credentials(
+		use_key ? m_key : NULL, m_certificates,
+		m_preferences.security.use_system_trust,
+		m_trust, m_dh_params);
 
 	InfCertificateCredentials* old_creds = m_credentials;
 	m_credentials = creds;
@@ -473,23 +702,27 @@ void Gobby::CertificateManager::make_credentials()
 
 void Gobby::CertificateManager::on_key_file_changed()
 {
+	wait();
 	load_key();
 	//make_credentials();
 }
 
 void Gobby::CertificateManager::on_certificate_file_changed()
 {
+	wait();
 	load_certificate();
 	//make_credentials();
 }
 
 void Gobby::CertificateManager::on_trusted_cas_changed()
 {
+	wait();
 	load_trust();
 	//make_credentials();
 }
 
 void Gobby::CertificateManager::on_authentication_enabled_changed()
 {
+	wait();
 	make_credentials();
 }
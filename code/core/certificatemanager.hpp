@@ -18,17 +18,39 @@
 #define _GOBBY_CERTIFICATEMANAGER_HPP_
 
 #include "core/preferences.hpp"
+#include "util/asyncoperation.hpp"
+
+#include <future>
+#include <memory>
 
 namespace Gobby
 {
+	// The DH parameters, key, certificate and trusted CAs are read in a
+	// background thread on construction, so that startup does not block
+	// on parsing them. Until they are loaded, the getters below return
+	// NULL and the credentials contain no certificates at all;
+	// signal_credentials_changed is emitted once loading has finished.
 	class CertificateManager
 	{
 	public:
 		CertificateManager(Preferences& preferences);
 		~CertificateManager();
 
+		bool is_loaded() const { return m_loaded; }
+
+		// Blocks until the files have been loaded. Call this before
+		// anything that makes use of the credentials, such as a TLS
+		// handshake.
+		void wait();
+
 		gnutls_dh_params_t get_dh_params() const
 			{ return m_dh_params; }
+		// Returns whether DH parameters need to be generated and set
+		// with set_dh_params() for DHE key exchange to be available.
+		// This is not the case if the parameters have been loaded
+		// already, or if GnuTLS is recent enough to offer the
+		// predefined groups from RFC 7919.
+		bool needs_dh_params() const;
 		gnutls_x509_privkey_t get_private_key() const
 			{ return m_key; }
 		InfCertificateChain* get_certificates() const
@@ -92,7 +114,13 @@ namespace Gobby
 
 		signal_credentials_changed_type m_signal_credentials_changed;
 	private:
-		void load_dh_params();
+		class Loader;
+		struct LoadResult;
+
+		bool m_loaded;
+		std::future<std::unique_ptr<LoadResult> > m_load_result;
+		std::unique_ptr<AsyncOperation::Handle> m_load_handle;
+
 		void load_key();
 		void load_certificate();
 		void load_trust();
@@ -18,7 +18,7 @@
 
 #include <libinfgtk/inf-gtk-io.h>
 
-Gobby::ConnectionManager::ConnectionManager(const CertificateManager& manager,
+Gobby::ConnectionManager::ConnectionManager(CertificateManager& manager,
                                             const Preferences& preferences):
 	m_cert_manager(manager),
 	m_preferences(preferences),
@@ -75,6 +75,7 @@ Gobby::ConnectionManager::~ConnectionManager()
 		g_signal_handler_disconnect(
 			G_OBJECT(it->first),
 			it->second.notify_status_handler);
+		delete it->second.metrics;
 	}
 
 	g_signal_handler_disconnect(G_OBJECT(m_xmpp_manager),
@@ -205,6 +206,11 @@ Gobby::ConnectionManager::create_connection(InfTcpConnection* connection,
 	}
 	else
 	{
+		// The TLS handshake needs the final credentials. Connections
+		// which are not opened yet get them in on_notify_status().
+		if(connect)
+			m_cert_manager.wait();
+
 		InfXmppConnection* xmpp = inf_xmpp_connection_new(
 			connection, INF_XMPP_CONNECTION_CLIENT,
 			NULL, hostname.c_str(),
@@ -229,6 +235,30 @@ void Gobby::ConnectionManager::remove_connection(InfXmppConnection* connection)
 		m_xmpp_manager, connection);
 }
 
+const Gobby::ConnectionMetrics*
+Gobby::ConnectionManager::get_metrics(InfXmppConnection* connection) const
+{
+	std::map<InfXmppConnection*, ConnectionInfo>::const_iterator iter =
+		m_connections.find(connection);
+	if(iter == m_connections.end()) return NULL;
+	return iter->second.metrics;
+}
+
+std::string Gobby::ConnectionManager::dump_metrics_json() const
+{
+	std::string json = "[";
+	for(std::map<InfXmppConnection*, ConnectionInfo>::const_iterator it =
+		m_connections.begin();
+	    it != m_connections.end(); ++it)
+	{
+		if(it != m_connections.begin()) json += ",";
+		json += "\n  " + it->second.metrics->to_json();
+	}
+
+	json += "\n]\n";
+	return json;
+}
+
 void Gobby::ConnectionManager::set_sasl_context(InfSaslContext* sasl_context,
                                                 const char* mechanisms)
 {
@@ -266,6 +296,7 @@ void Gobby::ConnectionManager::on_connection_added(InfXmppConnection* xmpp)
 	info.notify_status_handler = g_signal_connect(
 		G_OBJECT(xmpp), "notify::status",
 		G_CALLBACK(on_notify_status_static), this);
+	info.metrics = new ConnectionMetrics(xmpp);
 
 	m_connections[xmpp] = info;
 }
@@ -281,6 +312,7 @@ void Gobby::ConnectionManager::on_connection_removed(
 	ConnectionInfo& info = iter->second;
 	g_signal_handler_disconnect(G_OBJECT(xmpp),
 	                            info.notify_status_handler);
+	delete info.metrics;
 
 	m_connections.erase(iter);
 
@@ -373,4 +405,16 @@ void Gobby::ConnectionManager::on_notify_status(InfXmppConnection* connection)
 			G_OBJECT(connection), "credentials",
 			m_cert_manager.get_credentials(), NULL);
 	}
+
+	// Connections that were created while the certificate manager was
+	// still loading, such as discovered ones, have preliminary
+	// credentials. Replace them before the TLS handshake starts.
+	if(status == INF_XML_CONNECTION_OPENING &&
+	   !m_cert_manager.is_loaded())
+	{
+		m_cert_manager.wait();
+		g_object_set(
+			G_OBJECT(connection), "credentials",
+			m_cert_manager.get_credentials(), NULL);
+	}
 }
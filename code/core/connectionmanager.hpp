@@ -19,6 +19,7 @@
 
 #include "core/preferences.hpp"
 #include "core/certificatemanager.hpp"
+#include "core/connectionmetrics.hpp"
 
 #include <libinfinity/communication/inf-communication-manager.h>
 #include <libinfinity/common/inf-discovery-avahi.h>
@@ -39,7 +40,7 @@ public:
 	typedef sigc::signal<void, InfXmppConnection*, InfXmppConnection*>
 		SignalConnectionReplaced;
 
-	ConnectionManager(const CertificateManager& cert_manager,
+	ConnectionManager(CertificateManager& cert_manager,
 	                  const Preferences& preferences);
 	~ConnectionManager();
 
@@ -70,6 +71,15 @@ public:
 
 	void remove_connection(InfXmppConnection* connection);
 
+	// Returns traffic statistics for the given connection, or NULL if
+	// the connection is not managed by this class.
+	const ConnectionMetrics*
+	get_metrics(InfXmppConnection* connection) const;
+
+	// Returns the statistics of all managed connections as a JSON
+	// array.
+	std::string dump_metrics_json() const;
+
 	// SASL context to be used for all new connections
 	void set_sasl_context(InfSaslContext* sasl_context,
 	                      const char* mechanisms);
@@ -116,7 +126,7 @@ protected:
 	void on_credentials_changed();
 	void on_notify_status(InfXmppConnection* connection);
 
-	const CertificateManager& m_cert_manager;
+	CertificateManager& m_cert_manager;
 	const Preferences& m_preferences;
 
 	InfIo* m_io;
@@ -126,6 +136,7 @@ protected:
 	struct ConnectionInfo
 	{
 		gulong notify_status_handler;
+		ConnectionMetrics* metrics;
 	};
 
 	std::map<InfXmppConnection*, ConnectionInfo> m_connections;
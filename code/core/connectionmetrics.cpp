@@ -0,0 +1,282 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/connectionmetrics.hpp"
+
+#include <libinfinity/common/inf-ip-address.h>
+
+#include <sstream>
+
+namespace
+{
+	// Number of unanswered requests to remember. Requests the other side
+	// never replies to, for example because we are replying to one of
+	// its requests, are forgotten when more than this are pending.
+	const unsigned int MAX_PENDING = 64;
+
+	std::string get_seq(xmlNodePtr xml)
+	{
+		xmlChar* seq = xmlGetProp(
+			xml, reinterpret_cast<const xmlChar*>("seq"));
+		if(seq == NULL) return std::string();
+
+		// Replies may prefix the sequence number with the sequence
+		// ID of the connection, as in "seq_id/seq".
+		std::string result(reinterpret_cast<const char*>(seq));
+		xmlFree(seq);
+
+		std::string::size_type pos = result.rfind('/');
+		if(pos != std::string::npos)
+			result.erase(0, pos + 1);
+		return result;
+	}
+
+	// The toplevel XML node of a message is a <group> element which
+	// contains the actual messages for that communication group.
+	bool is_group(xmlNodePtr xml)
+	{
+		return xmlStrcmp(
+			xml->name,
+			reinterpret_cast<const xmlChar*>("group")) == 0;
+	}
+
+	void append_json_string(std::ostringstream& stream,
+	                        const std::string& str)
+	{
+		stream << '"';
+		for(std::string::const_iterator iter = str.begin();
+		    iter != str.end(); ++iter)
+		{
+			const unsigned char c = *iter;
+			if(c == '"' || c == '\\')
+			{
+				stream << '\\' << c;
+			}
+			else if(c < 0x20)
+			{
+				gchar buf[8];
+				g_snprintf(buf, sizeof(buf), "\\u%04x", c);
+				stream << buf;
+			}
+			else
+			{
+				stream << c;
+			}
+		}
+		stream << '"';
+	}
+}
+
+Gobby::ConnectionMetrics::ConnectionMetrics(InfXmppConnection* connection):
+	m_xmpp(connection), m_bytes_sent(0), m_bytes_received(0),
+	m_messages_sent(0), m_messages_received(0), m_rtt_samples(0),
+	m_rtt_last(0), m_rtt_min(0), m_rtt_smoothed(0)
+{
+	for(unsigned int i = 0; i < N_BUCKETS; ++i)
+		m_buckets[i] = 0;
+
+	g_object_ref(m_xmpp);
+	g_object_get(G_OBJECT(m_xmpp), "tcp-connection", &m_tcp, NULL);
+
+	m_xml_sent_handler = g_signal_connect_after(
+		G_OBJECT(m_xmpp), "sent",
+		G_CALLBACK(on_xml_sent_static), this);
+	m_xml_received_handler = g_signal_connect_after(
+		G_OBJECT(m_xmpp), "received",
+		G_CALLBACK(on_xml_received_static), this);
+	m_tcp_sent_handler = g_signal_connect_after(
+		G_OBJECT(m_tcp), "sent",
+		G_CALLBACK(on_tcp_sent_static), this);
+	m_tcp_received_handler = g_signal_connect_after(
+		G_OBJECT(m_tcp), "received",
+		G_CALLBACK(on_tcp_received_static), this);
+}
+
+Gobby::ConnectionMetrics::~ConnectionMetrics()
+{
+	g_signal_handler_disconnect(m_xmpp, m_xml_sent_handler);
+	g_signal_handler_disconnect(m_xmpp, m_xml_received_handler);
+	g_signal_handler_disconnect(m_tcp, m_tcp_sent_handler);
+	g_signal_handler_disconnect(m_tcp, m_tcp_received_handler);
+
+	g_object_unref(m_tcp);
+	g_object_unref(m_xmpp);
+}
+
+unsigned int Gobby::ConnectionMetrics::get_bucket_limit(unsigned int bucket)
+{
+	g_assert(bucket < N_BUCKETS);
+	if(bucket == N_BUCKETS - 1) return 0;
+	return 1u << bucket;
+}
+
+std::string Gobby::ConnectionMetrics::to_json() const
+{
+	std::ostringstream stream;
+
+	gchar* hostname;
+	g_object_get(G_OBJECT(m_xmpp), "remote-hostname", &hostname, NULL);
+	InfIpAddress* address;
+	guint port;
+	g_object_get(G_OBJECT(m_tcp),
+	             "remote-address", &address,
+	             "remote-port", &port,
+	             NULL);
+
+	stream << "{\"hostname\": ";
+	append_json_string(stream, hostname != NULL ? hostname : "");
+	g_free(hostname);
+
+	stream << ", \"address\": ";
+	if(address != NULL)
+	{
+		gchar* address_str = inf_ip_address_to_string(address);
+		append_json_string(stream, address_str);
+		g_free(address_str);
+		inf_ip_address_free(address);
+	}
+	else
+	{
+		stream << "null";
+	}
+
+	stream << ", \"port\": " << port
+	       << ", \"bytes_sent\": " << m_bytes_sent
+	       << ", \"bytes_received\": " << m_bytes_received
+	       << ", \"messages_sent\": " << m_messages_sent
+	       << ", \"messages_received\": " << m_messages_received
+	       << ", \"requests_pending\": " << m_pending.size()
+	       << ", \"rtt_us\": {\"samples\": " << m_rtt_samples
+	       << ", \"last\": " << m_rtt_last
+	       << ", \"min\": " << m_rtt_min
+	       << ", \"smoothed\": " << m_rtt_smoothed
+	       << "}, \"reply_latency_ms\": [";
+
+	for(unsigned int i = 0; i < N_BUCKETS; ++i)
+	{
+		if(i > 0) stream << ", ";
+
+		stream << "{\"le\": ";
+		if(get_bucket_limit(i) != 0) stream << get_bucket_limit(i);
+		else stream << "null";
+		stream << ", \"count\": " << m_buckets[i] << "}";
+	}
+
+	stream << "]}";
+	return stream.str();
+}
+
+void Gobby::ConnectionMetrics::on_xml_sent(xmlNodePtr xml)
+{
+	const gint64 now = g_get_monotonic_time();
+	if(!is_group(xml))
+	{
+		on_message_sent(xml, now);
+		return;
+	}
+
+	for(xmlNodePtr child = xml->children; child != NULL;
+	    child = child->next)
+	{
+		if(child->type == XML_ELEMENT_NODE)
+			on_message_sent(child, now);
+	}
+}
+
+void Gobby::ConnectionMetrics::on_xml_received(xmlNodePtr xml)
+{
+	const gint64 now = g_get_monotonic_time();
+	if(!is_group(xml))
+	{
+		on_message_received(xml, now);
+		return;
+	}
+
+	for(xmlNodePtr child = xml->children; child != NULL;
+	    child = child->next)
+	{
+		if(child->type == XML_ELEMENT_NODE)
+			on_message_received(child, now);
+	}
+}
+
+void Gobby::ConnectionMetrics::on_message_sent(xmlNodePtr xml, gint64 now)
+{
+	++m_messages_sent;
+
+	const std::string seq = get_seq(xml);
+	if(seq.empty()) return;
+
+	// Replies can themselves carry the sequence number of the request
+	// they reply to, so only the first message with a given number
+	// starts a measurement.
+	if(!m_pending.insert(PendingMap::value_type(seq, now)).second)
+		return;
+
+	m_pending_order.push_back(seq);
+	while(m_pending_order.size() > MAX_PENDING)
+	{
+		m_pending.erase(m_pending_order.front());
+		m_pending_order.pop_front();
+	}
+}
+
+void Gobby::ConnectionMetrics::on_message_received(xmlNodePtr xml,
+                                                   gint64 now)
+{
+	++m_messages_received;
+
+	const std::string seq = get_seq(xml);
+	if(seq.empty()) return;
+
+	PendingMap::iterator iter = m_pending.find(seq);
+	if(iter == m_pending.end()) return;
+
+	add_rtt_sample(now - iter->second);
+	m_pending.erase(iter);
+	// m_pending_order is cleaned up lazily: erasing a sequence number
+	// from m_pending that is no longer there is harmless.
+}
+
+void Gobby::ConnectionMetrics::add_rtt_sample(gint64 rtt)
+{
+	if(rtt < 0) rtt = 0;
+
+	if(m_rtt_samples == 0)
+	{
+		m_rtt_min = rtt;
+		m_rtt_smoothed = rtt;
+	}
+	else
+	{
+		if(rtt < m_rtt_min) m_rtt_min = rtt;
+		// Same smoothing factor as for the TCP round-trip time
+		// estimate (RFC 6298).
+		m_rtt_smoothed += (rtt - m_rtt_smoothed) / 8;
+	}
+
+	m_rtt_last = rtt;
+	++m_rtt_samples;
+
+	unsigned int bucket = 0;
+	while(bucket < N_BUCKETS - 1 &&
+	      rtt >= static_cast<gint64>(get_bucket_limit(bucket)) * 1000)
+	{
+		++bucket;
+	}
+
+	++m_buckets[bucket];
+}
@@ -0,0 +1,146 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_CONNECTIONMETRICS_HPP_
+#define _GOBBY_CONNECTIONMETRICS_HPP_
+
+#include <libinfinity/common/inf-xmpp-connection.h>
+#include <libinfinity/common/inf-tcp-connection.h>
+
+#include <libxml/tree.h>
+
+#include <glib.h>
+
+#include <string>
+#include <deque>
+#include <map>
+
+namespace Gobby
+{
+
+// Collects traffic statistics for a single connection: bytes and messages
+// in both directions, and the time between sending a request and receiving
+// the first reply to it, which is matched up by the request's sequence
+// number. Byte counts are taken from the TCP connection, so they include
+// the XMPP and TLS overhead.
+class ConnectionMetrics
+{
+public:
+	// Reply latencies are put into buckets whose upper limits are
+	// powers of two milliseconds, from 1ms to 2048ms. The last bucket
+	// holds everything above.
+	static const unsigned int N_BUCKETS = 13;
+
+	ConnectionMetrics(InfXmppConnection* connection);
+	~ConnectionMetrics();
+
+	InfXmppConnection* get_connection() const { return m_xmpp; }
+
+	guint64 get_bytes_sent() const { return m_bytes_sent; }
+	guint64 get_bytes_received() const { return m_bytes_received; }
+	guint64 get_messages_sent() const { return m_messages_sent; }
+	guint64 get_messages_received() const { return m_messages_received; }
+
+	// Round-trip times in microseconds. All of them are zero as long as
+	// get_rtt_samples() is zero.
+	guint64 get_rtt_samples() const { return m_rtt_samples; }
+	gint64 get_rtt_last() const { return m_rtt_last; }
+	gint64 get_rtt_min() const { return m_rtt_min; }
+	gint64 get_rtt_smoothed() const { return m_rtt_smoothed; }
+
+	// Upper limit of the given bucket in milliseconds, or 0 for the last
+	// bucket, which has no upper limit.
+	static unsigned int get_bucket_limit(unsigned int bucket);
+	guint64 get_bucket_count(unsigned int bucket) const
+	{
+		return m_buckets[bucket];
+	}
+
+	// Returns the statistics as a JSON object.
+	std::string to_json() const;
+
+protected:
+	static void on_xml_sent_static(InfXmlConnection* connection,
+	                               xmlNodePtr xml,
+	                               gpointer user_data)
+	{
+		static_cast<ConnectionMetrics*>(user_data)->on_xml_sent(xml);
+	}
+
+	static void on_xml_received_static(InfXmlConnection* connection,
+	                                   xmlNodePtr xml,
+	                                   gpointer user_data)
+	{
+		static_cast<ConnectionMetrics*>(user_data)->
+			on_xml_received(xml);
+	}
+
+	static void on_tcp_sent_static(InfTcpConnection* connection,
+	                               gconstpointer data,
+	                               guint len,
+	                               gpointer user_data)
+	{
+		static_cast<ConnectionMetrics*>(user_data)->
+			m_bytes_sent += len;
+	}
+
+	static void on_tcp_received_static(InfTcpConnection* connection,
+	                                   gconstpointer data,
+	                                   guint len,
+	                                   gpointer user_data)
+	{
+		static_cast<ConnectionMetrics*>(user_data)->
+			m_bytes_received += len;
+	}
+
+	void on_xml_sent(xmlNodePtr xml);
+	void on_xml_received(xmlNodePtr xml);
+
+	void on_message_sent(xmlNodePtr xml, gint64 now);
+	void on_message_received(xmlNodePtr xml, gint64 now);
+	void add_rtt_sample(gint64 rtt);
+
+	InfXmppConnection* m_xmpp;
+	InfTcpConnection* m_tcp;
+
+	guint64 m_bytes_sent;
+	guint64 m_bytes_received;
+	guint64 m_messages_sent;
+	guint64 m_messages_received;
+
+	guint64 m_rtt_samples;
+	gint64 m_rtt_last;
+	gint64 m_rtt_min;
+	gint64 m_rtt_smoothed;
+	guint64 m_buckets[N_BUCKETS];
+
+	// Requests that have not been replied to yet, by sequence number,
+	// with the time they were sent. The queue holds the sequence numbers
+	// in the order the requests were sent, so that the oldest can be
+	// dropped if the other side does not reply to them.
+	typedef std::map<std::string, gint64> PendingMap;
+	PendingMap m_pending;
+	std::deque<std::string> m_pending_order;
+
+	gulong m_xml_sent_handler;
+	gulong m_xml_received_handler;
+	gulong m_tcp_sent_handler;
+	gulong m_tcp_received_handler;
+};
+
+}
+
+#endif // _GOBBY_CONNECTIONMETRICS_HPP_
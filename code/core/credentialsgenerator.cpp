@@ -205,6 +205,8 @@ std::unique_ptr<Gobby::DHParamsGeneratorHandle>
 Gobby::create_dh_params(unsigned int bits,
                         const SlotDHParamsGeneratorDone& done_slot)
 {
+	// This can take minutes, so don't hold up other work
 	std::unique_ptr<AsyncOperation> operation(new DHgen(bits, done_slot));
-	return AsyncOperation::start(std::move(operation));
+	return AsyncOperation::start(std::move(operation),
+	                             WorkerPool::PRIORITY_LOW);
 }
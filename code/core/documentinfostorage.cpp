@@ -24,8 +24,18 @@
 #include <glibmm/miscutils.h>
 #include <glibmm/exception.h>
 
+#include <glib/gstdio.h>
+
+#include <set>
+#include <vector>
+
 namespace
 {
+	const char SECTION[] = "documents";
+
+	// Infos that have not been set for this long are dropped
+	const gint64 MAX_AGE = 365 * 24 * 60 * 60;
+
 	Gobby::DocumentInfoStorage::EolStyle
 	eol_style_from_text(const std::string& text)
 	{
@@ -51,8 +61,14 @@ namespace
 		}
 	}
 
+	gint64 now()
+	{
+		return g_get_real_time() / G_USEC_PER_SEC;
+	}
+
 	std::string load_document(xmlpp::Element* node,
-	                          Gobby::DocumentInfoStorage::Info& info)
+	                          Gobby::DocumentInfoStorage::Info& info,
+	                          gint64& last_used)
 	{
 		std::string root;
 
@@ -77,13 +93,48 @@ namespace
 					text->get_content());
 			else if(child->get_name() == "encoding")
 				info.encoding = text->get_content();
+			else if(child->get_name() == "last-used")
+				last_used = g_ascii_strtoll(
+					text->get_content().c_str(), NULL, 10);
 		}
 
 		return root;
 	}
 
-	// Location to store the documents file:
-	std::string filename()
+	// Infos are stored as tab-separated fields in the state store
+	std::string encode_entry(const Gobby::DocumentInfoStorage::Info& info,
+	                         gint64 last_used)
+	{
+		gchar last_used_str[G_ASCII_DTOSTR_BUF_SIZE];
+		g_snprintf(last_used_str, sizeof(last_used_str),
+		           "%" G_GINT64_FORMAT, last_used);
+
+		return info.uri.raw() + "\t" +
+			eol_style_to_text(info.eol_style) +
+			"\t" + info.encoding + "\t" + last_used_str;
+	}
+
+	bool decode_entry(const std::string& value,
+	                  Gobby::DocumentInfoStorage::Info& info,
+	                  gint64& last_used)
+	{
+		gchar** fields = g_strsplit(value.c_str(), "\t", 4);
+		const bool valid = g_strv_length(fields) == 4;
+
+		if(valid)
+		{
+			info.uri = fields[0];
+			info.eol_style = eol_style_from_text(fields[1]);
+			info.encoding = fields[2];
+			last_used = g_ascii_strtoll(fields[3], NULL, 10);
+		}
+
+		g_strfreev(fields);
+		return valid;
+	}
+
+	// Location of the documents file of older versions:
+	std::string legacy_filename()
 	{
 		return Gobby::config_filename("documents.xml");
 	}
@@ -120,28 +171,12 @@ private:
 	gulong m_node_removed_handler;
 };
 
-Gobby::DocumentInfoStorage::DocumentInfoStorage(InfGtkBrowserModel* model):
-	m_model(model)
+Gobby::DocumentInfoStorage::DocumentInfoStorage(InfGtkBrowserModel* model,
+                                                StateStore& store):
+	m_store(store), m_loaded(false), m_model(model)
 {
-	xmlpp::DomParser parser;
-
-	try
-	{
-		parser.parse_file(filename());
-		xmlpp::Document* document = parser.get_document();
-		if(document)
-		{
-			xmlpp::Element* root = document->get_root_node();
-			if(root)
-			{
-				init(root);
-			}
-		}
-	}
-	catch(xmlpp::exception& e)
-	{
-		// Could not read file, ignore
-	}
+	if(!m_store.has_section(SECTION))
+		migrate();
 
 	g_object_ref(m_model);
 
@@ -152,45 +187,11 @@ Gobby::DocumentInfoStorage::DocumentInfoStorage(InfGtkBrowserModel* model):
 
 Gobby::DocumentInfoStorage::~DocumentInfoStorage()
 {
-	try
-	{
-		create_directory_with_parents(
-			Glib::path_get_dirname(filename()), 0700);
-		xmlpp::Document document;
-		xmlpp::Element* root = document.create_root_node("documents");
-
-		for(InfoMap::iterator iter = m_infos.begin();
-		    iter != m_infos.end(); ++ iter)
-		{
-			xmlpp::Element* child = root->add_child("document");
-
-			xmlpp::Element* root_child = child->add_child("root");
-			root_child->set_child_text(iter->first);
-
-			xmlpp::Element* uri_child = child->add_child("uri");
-			uri_child->set_child_text(iter->second.uri);
-
-			xmlpp::Element* eol_style_child =
-				child->add_child("eol-style");
-			eol_style_child->set_child_text(
-				eol_style_to_text(iter->second.eol_style));
-
-			xmlpp::Element* encoding_child =
-				child->add_child("encoding");
-			encoding_child->set_child_text(iter->second.encoding);
-		}
-
-		document.write_to_file_formatted(filename());
-	}
-	catch(Glib::Exception& e)
+	for(RequestMap::iterator iter = m_explore_requests.begin();
+	    iter != m_explore_requests.end(); ++ iter)
 	{
-		g_warning("Could not write documents file: %s",
-		          e.what().c_str());
-	}
-	catch(std::exception& e)
-	{
-		g_warning("Could not write documents file: %s",
-		          e.what());
+		g_signal_handler_disconnect(iter->first, iter->second);
+		g_object_unref(iter->first);
 	}
 
 	g_signal_handler_disconnect(m_model, m_set_browser_handler);
@@ -203,28 +204,89 @@ Gobby::DocumentInfoStorage::~DocumentInfoStorage()
 	}
 }
 
-void Gobby::DocumentInfoStorage::init(xmlpp::Element* node)
+void Gobby::DocumentInfoStorage::load() const
 {
-	xmlpp::Node::NodeList list = node->get_children();
-	for(xmlpp::Node::NodeList::iterator iter = list.begin();
-	    iter != list.end();
-	    ++ iter)
+	if(m_loaded) return;
+	m_loaded = true;
+
+	const gint64 expiry = now() - MAX_AGE;
+	std::vector<std::string> expired_keys;
+
+	const StateStore::Section& section = m_store.get_section(SECTION);
+	for(StateStore::Section::const_iterator iter = section.begin();
+	    iter != section.end(); ++ iter)
 	{
-		xmlpp::Element* child = dynamic_cast<xmlpp::Element*>(*iter);
-		if(child == NULL) continue;
+		Entry entry;
+		if(!decode_entry(iter->second, entry.info, entry.last_used))
+			continue;
+
+		// Drop infos that have not been used for a long time
+		if(entry.last_used < expiry)
+			expired_keys.push_back(iter->first);
+		else
+			m_infos[iter->first] = entry;
+	}
+
+	for(std::vector<std::string>::const_iterator iter =
+		expired_keys.begin();
+	    iter != expired_keys.end(); ++ iter)
+	{
+		m_store.remove(SECTION, *iter);
+	}
+}
+
+// Imports the documents.xml file written by older versions into the state
+// store.
+void Gobby::DocumentInfoStorage::migrate()
+{
+	m_store.clear(SECTION);
+
+	xmlpp::DomParser parser;
 
-		if(child->get_name() == "document")
+	try
+	{
+		parser.parse_file(legacy_filename());
+		xmlpp::Document* document = parser.get_document();
+		xmlpp::Element* root =
+			document ? document->get_root_node() : NULL;
+		if(root)
 		{
-			Info info;
-			std::string root = load_document(child, info);
-			m_infos[root] = info;
+			xmlpp::Node::NodeList list = root->get_children();
+			for(xmlpp::Node::NodeList::iterator iter =
+				list.begin();
+			    iter != list.end();
+			    ++ iter)
+			{
+				xmlpp::Element* child =
+					dynamic_cast<xmlpp::Element*>(*iter);
+				if(child == NULL) continue;
+
+				if(child->get_name() == "document")
+				{
+					Info info;
+					// The file has no timestamps, so
+					// start to age the infos now.
+					gint64 last_used = now();
+					std::string key = load_document(
+						child, info, last_used);
+					m_store.set(SECTION, key,
+					            encode_entry(
+							info, last_used));
+				}
+			}
 		}
 	}
+	catch(xmlpp::exception& e)
+	{
+		// Could not read file, ignore
+	}
+
+	g_unlink(legacy_filename().c_str());
 }
 
 std::string
 Gobby::DocumentInfoStorage::get_key(InfBrowser* browser,
-                                    const InfBrowserIter* iter) const
+                                    const InfBrowserIter* iter)
 {
 	std::string prefix;
 	if(INFC_IS_BROWSER(browser))
@@ -260,8 +322,10 @@ Gobby::DocumentInfoStorage::get_info(InfBrowser* browser,
 const Gobby::DocumentInfoStorage::Info*
 Gobby::DocumentInfoStorage::get_info(const std::string& key) const
 {
+	load();
+
 	InfoMap::const_iterator map_iter = m_infos.find(key);
-	if(map_iter != m_infos.end()) return &map_iter->second;
+	if(map_iter != m_infos.end()) return &map_iter->second.info;
 	return NULL;
 }
 
@@ -275,7 +339,13 @@ void Gobby::DocumentInfoStorage::set_info(InfBrowser* browser,
 void Gobby::DocumentInfoStorage::set_info(const std::string& key,
                                           const Info& info)
 {
-	m_infos[key] = info;
+	load();
+
+	Entry& entry = m_infos[key];
+	entry.info = info;
+	entry.last_used = now();
+
+	m_store.set(SECTION, key, encode_entry(info, entry.last_used));
 }
 
 void Gobby::DocumentInfoStorage::on_set_browser(GtkTreeIter* iter,
@@ -297,11 +367,21 @@ void Gobby::DocumentInfoStorage::on_set_browser(GtkTreeIter* iter,
 		g_assert(m_browsers.find(new_browser) == m_browsers.end());
 		m_browsers[new_browser] = new BrowserConn(*this, new_browser);
 
-		// TODO: Remove all infos that refer to no longer existing
-		// documents in all explored directories in browser. Also
-		// add all existing explore requests, to check
-		// subdirectories when the explore finishes (see
-		// on_begin_request_explore_node).
+		// Check the directories that have been explored already,
+		// and those that are being explored right now when the
+		// exploration finishes.
+		if(inf_browser_get_status(new_browser) == INF_BROWSER_OPEN)
+		{
+			InfBrowserIter root;
+			inf_browser_get_root(new_browser, &root);
+			prune_directory(new_browser, &root);
+		}
+
+		GSList* requests = inf_browser_list_pending_requests(
+			new_browser, NULL, "explore-node");
+		for(GSList* item = requests; item != NULL; item = item->next)
+			add_explore_request(INF_REQUEST(item->data));
+		g_slist_free(requests);
 	}
 }
 
@@ -310,19 +390,116 @@ void Gobby::DocumentInfoStorage::
 	                              InfBrowserIter* iter,
 	                              InfRequest* request)
 {
-	// TODO: When request has finished, remove all infos that refer to
-	// no longer existing documents in the explored directory.
+	add_explore_request(request);
 }
 
 void Gobby::DocumentInfoStorage::on_node_removed(InfBrowser* browser,
                                                  InfBrowserIter* iter,
                                                  InfRequest* request)
 {
+	load();
+
 	// Remove info when the corresponding document is removed.
 	std::string key = get_key(browser, iter);
-	InfoMap::iterator map_iter = m_infos.find(key);
+	if(m_infos.find(key) != m_infos.end())
+		erase(key);
+}
 
-	if(map_iter != m_infos.end())
-		m_infos.erase(map_iter);
+void Gobby::DocumentInfoStorage::on_explore_finished(
+	InfRequest* request, const InfRequestResult* result,
+	const GError* error)
+{
+	RequestMap::iterator iter = m_explore_requests.find(request);
+	g_assert(iter != m_explore_requests.end());
+
+	g_signal_handler_disconnect(request, iter->second);
+	m_explore_requests.erase(iter);
+
+	if(error == NULL)
+	{
+		InfBrowser* browser;
+		const InfBrowserIter* browser_iter;
+		inf_request_result_get_explore_node(
+			result, &browser, &browser_iter);
+
+		prune_directory(browser, browser_iter);
+	}
+
+	g_object_unref(request);
+}
+
+void Gobby::DocumentInfoStorage::add_explore_request(InfRequest* request)
+{
+	if(m_explore_requests.find(request) != m_explore_requests.end())
+		return;
+
+	g_object_ref(request);
+	m_explore_requests[request] = g_signal_connect_after(
+		G_OBJECT(request), "finished",
+		G_CALLBACK(on_explore_finished_static), this);
+}
+
+// Removes all infos that refer to no longer existing documents in the
+// given directory and its explored subdirectories.
+void Gobby::DocumentInfoStorage::prune_directory(InfBrowser* browser,
+                                                 const InfBrowserIter* iter)
+{
+	if(!inf_browser_get_explored(browser, iter)) return;
+
+	load();
+
+	std::string prefix = get_key(browser, iter);
+	if(prefix[prefix.length() - 1] != '/') prefix += '/';
+
+	std::set<std::string> names;
+	std::vector<InfBrowserIter> subdirectories;
+
+	InfBrowserIter child = *iter;
+	if(inf_browser_get_child(browser, &child))
+	{
+		do
+		{
+			names.insert(inf_browser_get_node_name(
+				browser, &child));
+			if(inf_browser_is_subdirectory(browser, &child))
+				subdirectories.push_back(child);
+		} while(inf_browser_get_next(browser, &child));
+	}
+
+	std::vector<std::string> dead_keys;
+	for(InfoMap::const_iterator map_iter = m_infos.lower_bound(prefix);
+	    map_iter != m_infos.end() &&
+	    map_iter->first.compare(0, prefix.length(), prefix) == 0;
+	    ++ map_iter)
+	{
+		const std::string::size_type end =
+			map_iter->first.find('/', prefix.length());
+		const std::string name = map_iter->first.substr(
+			prefix.length(),
+			end == std::string::npos ?
+				std::string::npos : end - prefix.length());
+
+		if(names.find(name) == names.end())
+			dead_keys.push_back(map_iter->first);
+	}
+
+	for(std::vector<std::string>::const_iterator key_iter =
+		dead_keys.begin();
+	    key_iter != dead_keys.end(); ++ key_iter)
+	{
+		erase(*key_iter);
+	}
+
+	for(std::vector<InfBrowserIter>::const_iterator dir_iter =
+		subdirectories.begin();
+	    dir_iter != subdirectories.end(); ++ dir_iter)
+	{
+		prune_directory(browser, &*dir_iter);
+	}
 }
 
+void Gobby::DocumentInfoStorage::erase(const std::string& key)
+{
+	m_infos.erase(key);
+	m_store.remove(SECTION, key);
+}
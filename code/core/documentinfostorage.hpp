@@ -17,9 +17,11 @@
 #ifndef _GOBBY_OPERATIONS_DOCUMENTINFO_STORAGE_HPP_
 #define _GOBBY_OPERATIONS_DOCUMENTINFO_STORAGE_HPP_
 
+#include "util/statestore.hpp"
+
 #include <libinfgtk/inf-gtk-browser-model.h>
+#include <libinfinity/common/inf-request-result.h>
 
-#include <libxml++/nodes/element.h>
 #include <glibmm/ustring.h>
 #include <sigc++/trackable.h>
 
@@ -28,6 +30,11 @@
 namespace Gobby
 {
 
+// Remembers the URI, encoding and line ending style of documents, so that
+// they can be saved again in the same way. The infos are kept in the
+// "documents" section of the state store, and are only decoded when the
+// first info is needed. Infos of documents that no longer exist or that
+// have not been used for a long time are dropped.
 class DocumentInfoStorage: public sigc::trackable
 {
 public:
@@ -43,11 +50,12 @@ public:
 		std::string encoding;
 	};
 
-	DocumentInfoStorage(InfGtkBrowserModel* model);
+	DocumentInfoStorage(InfGtkBrowserModel* model, StateStore& store);
 	~DocumentInfoStorage();
 
-	std::string get_key(InfBrowser* browser,
-	                    const InfBrowserIter* iter) const;
+	// Identifies a node across connections to the same server
+	static std::string get_key(InfBrowser* browser,
+	                           const InfBrowserIter* iter);
 
 	const Info* get_info(InfBrowser* browser,
 	                     const InfBrowserIter* iter) const;
@@ -95,18 +103,51 @@ protected:
 	void on_node_removed(InfBrowser* browser, InfBrowserIter* iter,
 	                     InfRequest* request);
 
-	typedef std::map<std::string, Info> InfoMap;
-	InfoMap m_infos;
+	static void on_explore_finished_static(InfRequest* request,
+	                                       const InfRequestResult* result,
+	                                       const GError* error,
+	                                       gpointer user_data)
+	{
+		static_cast<DocumentInfoStorage*>(user_data)->
+			on_explore_finished(request, result, error);
+	}
+
+	void on_explore_finished(InfRequest* request,
+	                         const InfRequestResult* result,
+	                         const GError* error);
+
+	struct Entry {
+		Info info;
+		// Time of the last set_info() call, in seconds since the
+		// epoch, to expire infos that are no longer used.
+		gint64 last_used;
+	};
+
+	StateStore& m_store;
+
+	// Decoded lazily on first access, hence mutable
+	typedef std::map<std::string, Entry> InfoMap;
+	mutable InfoMap m_infos;
+	mutable bool m_loaded;
 
 	class BrowserConn;
 	typedef std::map<InfBrowser*, BrowserConn*> BrowserMap;
 	BrowserMap m_browsers;
 
+	typedef std::map<InfRequest*, gulong> RequestMap;
+	RequestMap m_explore_requests;
+
 	gulong m_set_browser_handler;
 	InfGtkBrowserModel* m_model;
 
 private:
-	void init(xmlpp::Element* node);
+	void load() const;
+	void migrate();
+
+	void add_explore_request(InfRequest* request);
+	void prune_directory(InfBrowser* browser,
+	                     const InfBrowserIter* iter);
+	void erase(const std::string& key);
 };
 
 }
@@ -0,0 +1,290 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/explorecache.hpp"
+#include "core/documentinfostorage.hpp"
+
+#include <libinfinity/client/infc-browser.h>
+
+#include <vector>
+
+namespace
+{
+	// Directories on the way to subscribed documents
+	const char SUBSCRIBED_SECTION[] = "explored-directories";
+	// Directories expanded in the browser
+	const char EXPANDED_SECTION[] = "expanded-directories";
+
+	// Directories that have not been used for this long are not
+	// explored ahead of time anymore.
+	const gint64 MAX_AGE = 30 * 24 * 60 * 60;
+
+	// Upper bound for the number of remembered directories of each
+	// kind, so that the cache does not make us download half of a
+	// server.
+	const std::map<std::string, gint64>::size_type MAX_DIRECTORIES = 256;
+
+	gint64 now()
+	{
+		return g_get_real_time() / G_USEC_PER_SEC;
+	}
+}
+
+Gobby::ExploreCache::ExploreCache(InfGtkBrowserModel* model,
+                                  StateStore& store):
+	m_model(model), m_store(store), m_loaded(false)
+{
+	g_object_ref(m_model);
+
+	m_set_browser_handler = g_signal_connect(
+		G_OBJECT(m_model), "set-browser",
+		G_CALLBACK(&on_set_browser_static), this);
+}
+
+Gobby::ExploreCache::~ExploreCache()
+{
+	for(BrowserMap::iterator iter = m_browsers.begin();
+	    iter != m_browsers.end(); ++iter)
+	{
+		g_signal_handler_disconnect(
+			iter->first, iter->second.notify_status_handler);
+		g_signal_handler_disconnect(
+			iter->first, iter->second.node_added_handler);
+		g_signal_handler_disconnect(
+			iter->first, iter->second.node_removed_handler);
+		g_signal_handler_disconnect(
+			iter->first, iter->second.subscribe_session_handler);
+	}
+
+	g_signal_handler_disconnect(m_model, m_set_browser_handler);
+	g_object_unref(m_model);
+}
+
+bool Gobby::ExploreCache::get_expanded(InfBrowser* browser,
+                                       const InfBrowserIter* iter)
+{
+	if(!INFC_IS_BROWSER(browser)) return false;
+
+	load();
+	if(m_expanded.empty()) return false;
+
+	return m_expanded.find(DocumentInfoStorage::get_key(browser, iter)) !=
+		m_expanded.end();
+}
+
+void Gobby::ExploreCache::set_expanded(InfBrowser* browser,
+                                       const InfBrowserIter* iter,
+                                       bool expanded)
+{
+	if(!INFC_IS_BROWSER(browser)) return;
+
+	load();
+
+	const std::string key = DocumentInfoStorage::get_key(browser, iter);
+	if(expanded)
+		remember(EXPANDED_SECTION, m_expanded, key, now());
+	else
+		forget(EXPANDED_SECTION, m_expanded, key);
+}
+
+void Gobby::ExploreCache::on_set_browser(InfBrowser* old_browser,
+                                         InfBrowser* new_browser)
+{
+	if(old_browser != NULL)
+	{
+		BrowserMap::iterator iter = m_browsers.find(old_browser);
+		if(iter != m_browsers.end())
+		{
+			g_signal_handler_disconnect(
+				old_browser,
+				iter->second.notify_status_handler);
+			g_signal_handler_disconnect(
+				old_browser,
+				iter->second.node_added_handler);
+			g_signal_handler_disconnect(
+				old_browser,
+				iter->second.node_removed_handler);
+			g_signal_handler_disconnect(
+				old_browser,
+				iter->second.subscribe_session_handler);
+			m_browsers.erase(iter);
+		}
+	}
+
+	// Local directories do not need to be explored ahead of time
+	if(new_browser != NULL && INFC_IS_BROWSER(new_browser))
+	{
+		g_assert(m_browsers.find(new_browser) == m_browsers.end());
+		BrowserInfo& info = m_browsers[new_browser];
+
+		info.notify_status_handler = g_signal_connect(
+			G_OBJECT(new_browser), "notify::status",
+			G_CALLBACK(on_notify_status_static), this);
+		info.node_added_handler = g_signal_connect(
+			G_OBJECT(new_browser), "node-added",
+			G_CALLBACK(on_node_added_static), this);
+		info.node_removed_handler = g_signal_connect(
+			G_OBJECT(new_browser), "node-removed",
+			G_CALLBACK(on_node_removed_static), this);
+		info.subscribe_session_handler = g_signal_connect(
+			G_OBJECT(new_browser), "subscribe-session",
+			G_CALLBACK(on_subscribe_session_static), this);
+
+		on_notify_status(new_browser);
+	}
+}
+
+void Gobby::ExploreCache::on_notify_status(InfBrowser* browser)
+{
+	if(inf_browser_get_status(browser) == INF_BROWSER_OPEN)
+	{
+		InfBrowserIter root;
+		inf_browser_get_root(browser, &root);
+		prefetch(browser, &root);
+	}
+}
+
+void Gobby::ExploreCache::on_node_added(InfBrowser* browser,
+                                        InfBrowserIter* iter)
+{
+	if(inf_browser_is_subdirectory(browser, iter))
+		prefetch(browser, iter);
+}
+
+void Gobby::ExploreCache::on_node_removed(InfBrowser* browser,
+                                          InfBrowserIter* iter)
+{
+	if(!inf_browser_is_subdirectory(browser, iter)) return;
+
+	load();
+
+	const std::string key = DocumentInfoStorage::get_key(browser, iter);
+	forget(SUBSCRIBED_SECTION, m_subscribed, key);
+	forget(EXPANDED_SECTION, m_expanded, key);
+}
+
+void Gobby::ExploreCache::on_subscribe_session(InfBrowser* browser,
+                                               InfBrowserIter* iter)
+{
+	load();
+
+	const gint64 last_used = now();
+
+	InfBrowserIter parent = *iter;
+	while(inf_browser_get_parent(browser, &parent))
+	{
+		remember(SUBSCRIBED_SECTION, m_subscribed,
+		         DocumentInfoStorage::get_key(browser, &parent),
+		         last_used);
+	}
+}
+
+void Gobby::ExploreCache::load()
+{
+	if(m_loaded) return;
+	m_loaded = true;
+
+	load_section(SUBSCRIBED_SECTION, m_subscribed);
+	load_section(EXPANDED_SECTION, m_expanded);
+}
+
+void Gobby::ExploreCache::load_section(const char* section,
+                                       DirectoryMap& directories)
+{
+	const gint64 expiry = now() - MAX_AGE;
+	std::vector<std::string> expired_keys;
+
+	const StateStore::Section& entries = m_store.get_section(section);
+	for(StateStore::Section::const_iterator iter = entries.begin();
+	    iter != entries.end(); ++iter)
+	{
+		const gint64 last_used =
+			g_ascii_strtoll(iter->second.c_str(), NULL, 10);
+
+		if(last_used < expiry)
+			expired_keys.push_back(iter->first);
+		else
+			directories[iter->first] = last_used;
+	}
+
+	for(std::vector<std::string>::const_iterator iter =
+		expired_keys.begin();
+	    iter != expired_keys.end(); ++iter)
+	{
+		m_store.remove(section, *iter);
+	}
+}
+
+void Gobby::ExploreCache::prefetch(InfBrowser* browser,
+                                   const InfBrowserIter* iter)
+{
+	if(inf_browser_get_explored(browser, iter)) return;
+	if(inf_browser_get_pending_request(
+		browser, iter, "explore-node") != NULL)
+	{
+		return;
+	}
+
+	load();
+	if(m_subscribed.empty()) return;
+
+	const std::string key = DocumentInfoStorage::get_key(browser, iter);
+	if(m_subscribed.find(key) != m_subscribed.end())
+	{
+		// Nobody waits for this one. Subscriptions that need the
+		// directory pick up the pending request.
+		inf_browser_explore(browser, iter, NULL, NULL);
+	}
+}
+
+void Gobby::ExploreCache::remember(const char* section,
+                                   DirectoryMap& directories,
+                                   const std::string& key,
+                                   gint64 last_used)
+{
+	directories[key] = last_used;
+
+	gchar last_used_str[G_ASCII_DTOSTR_BUF_SIZE];
+	g_snprintf(last_used_str, sizeof(last_used_str),
+	           "%" G_GINT64_FORMAT, last_used);
+	m_store.set(section, key, last_used_str);
+
+	if(directories.size() > MAX_DIRECTORIES)
+	{
+		DirectoryMap::iterator oldest = directories.begin();
+		for(DirectoryMap::iterator iter = directories.begin();
+		    iter != directories.end(); ++iter)
+		{
+			if(iter->second < oldest->second)
+				oldest = iter;
+		}
+
+		m_store.remove(section, oldest->first);
+		directories.erase(oldest);
+	}
+}
+
+void Gobby::ExploreCache::forget(const char* section,
+                                 DirectoryMap& directories,
+                                 const std::string& key)
+{
+	DirectoryMap::iterator iter = directories.find(key);
+	if(iter != directories.end())
+	{
+		m_store.remove(section, key);
+		directories.erase(iter);
+	}
+}
@@ -0,0 +1,144 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_EXPLORECACHE_HPP_
+#define _GOBBY_EXPLORECACHE_HPP_
+
+#include "util/statestore.hpp"
+
+#include <libinfgtk/inf-gtk-browser-model.h>
+#include <libinfinity/common/inf-browser.h>
+
+#include <sigc++/trackable.h>
+
+#include <string>
+#include <map>
+
+namespace Gobby
+{
+
+// Remembers the directories on the way to documents that have been
+// subscribed to on remote servers in the state store. When a connection to
+// such a server is made, these directories are explored as soon as their
+// nodes show up, all at once, so that opening a document deep down in the
+// tree after a restart does not wait for one exploration after the other.
+// It also remembers the directories that were expanded in the browser, so
+// that the browser can expand them again. Node IDs are assigned by the
+// server and can only be used once the server has told us about the node,
+// so the cache stores paths, not IDs.
+class ExploreCache: public sigc::trackable
+{
+public:
+	ExploreCache(InfGtkBrowserModel* model, StateStore& store);
+	~ExploreCache();
+
+	// Whether the directory was expanded in the browser the last time
+	// it was shown. Always false for local directories.
+	bool get_expanded(InfBrowser* browser, const InfBrowserIter* iter);
+	void set_expanded(InfBrowser* browser, const InfBrowserIter* iter,
+	                  bool expanded);
+
+protected:
+	static void on_set_browser_static(InfGtkBrowserModel* model,
+	                                  GtkTreePath* path,
+	                                  GtkTreeIter* iter,
+	                                  InfBrowser* old_browser,
+	                                  InfBrowser* new_browser,
+	                                  gpointer user_data)
+	{
+		static_cast<ExploreCache*>(user_data)->
+			on_set_browser(old_browser, new_browser);
+	}
+
+	static void on_notify_status_static(GObject* object,
+	                                    GParamSpec* pspec,
+	                                    gpointer user_data)
+	{
+		static_cast<ExploreCache*>(user_data)->
+			on_notify_status(INF_BROWSER(object));
+	}
+
+	static void on_node_added_static(InfBrowser* browser,
+	                                 InfBrowserIter* iter,
+	                                 InfRequest* request,
+	                                 gpointer user_data)
+	{
+		static_cast<ExploreCache*>(user_data)->
+			on_node_added(browser, iter);
+	}
+
+	static void on_node_removed_static(InfBrowser* browser,
+	                                   InfBrowserIter* iter,
+	                                   InfRequest* request,
+	                                   gpointer user_data)
+	{
+		static_cast<ExploreCache*>(user_data)->
+			on_node_removed(browser, iter);
+	}
+
+	static void on_subscribe_session_static(InfBrowser* browser,
+	                                        InfBrowserIter* iter,
+	                                        InfSessionProxy* proxy,
+	                                        InfRequest* request,
+	                                        gpointer user_data)
+	{
+		static_cast<ExploreCache*>(user_data)->
+			on_subscribe_session(browser, iter);
+	}
+
+	void on_set_browser(InfBrowser* old_browser, InfBrowser* new_browser);
+	void on_notify_status(InfBrowser* browser);
+	void on_node_added(InfBrowser* browser, InfBrowserIter* iter);
+	void on_node_removed(InfBrowser* browser, InfBrowserIter* iter);
+	void on_subscribe_session(InfBrowser* browser, InfBrowserIter* iter);
+
+	// Directory keys as made by DocumentInfoStorage::get_key(), with the
+	// time they were last used.
+	typedef std::map<std::string, gint64> DirectoryMap;
+
+	void load();
+	void load_section(const char* section, DirectoryMap& directories);
+	void prefetch(InfBrowser* browser, const InfBrowserIter* iter);
+	void remember(const char* section, DirectoryMap& directories,
+	              const std::string& key, gint64 last_used);
+	void forget(const char* section, DirectoryMap& directories,
+	            const std::string& key);
+
+	struct BrowserInfo
+	{
+		gulong notify_status_handler;
+		gulong node_added_handler;
+		gulong node_removed_handler;
+		gulong subscribe_session_handler;
+	};
+
+	InfGtkBrowserModel* m_model;
+	StateStore& m_store;
+
+	// Decoded lazily when the first remote browser opens
+	DirectoryMap m_subscribed;
+	DirectoryMap m_expanded;
+	bool m_loaded;
+
+	typedef std::map<InfBrowser*, BrowserInfo> BrowserMap;
+	BrowserMap m_browsers;
+
+	gulong m_set_browser_handler;
+};
+
+}
+
+#endif // _GOBBY_EXPLORECACHE_HPP_
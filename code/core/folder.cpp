@@ -27,8 +27,6 @@
 #include <stdexcept>
 #include <iostream> // For std::cerr
 
-#include <libinfinity/adopted/inf-adopted-session-record.h>
-
 namespace
 {
 	class KeyMap
@@ -61,44 +59,6 @@ namespace
 		typedef std::map<guint, unsigned int> map_type;
 		map_type m_keyvals;
 	};
-
-	void record(InfTextSession* session, const Glib::ustring& title)
-	{
-		std::string dirname = Glib::build_filename(
-			Glib::get_home_dir(), ".infinote-records");
-		std::string filename = Glib::build_filename(
-			dirname, title + ".record.xml");
-
-		try
-		{
-			Gobby::create_directory_with_parents(dirname, 0700);
-
-			InfAdoptedSessionRecord* record =
-				inf_adopted_session_record_new(
-					INF_ADOPTED_SESSION(session));
-
-			GError* error = NULL;
-			inf_adopted_session_record_start_recording(
-				record, filename.c_str(), &error);
-			if(error != NULL)
-			{
-				g_object_unref(record);
-
-				std::string what = error->message;
-				g_error_free(error);
-				throw std::runtime_error(what);
-			}
-
-			g_object_set_data_full(
-				G_OBJECT(session), "GOBBY_SESSION_RECORD",
-				record, g_object_unref);
-		}
-		catch(std::exception& ex)
-		{
-			std::cerr << "Failed to create record '" << filename
-			          << "': " << ex.what() << std::endl;
-		}
-	}
 }
 
 Gobby::Folder::Folder(bool hide_single_tab,
@@ -118,8 +78,7 @@ Gobby::Folder::Folder(bool hide_single_tab,
 
 Gobby::Folder::~Folder()
 {
-	// Remove all documents explicitely, so that all sessions are closed,
-	// and records finished.
+	// Remove all documents explicitely, so that all sessions are closed.
 	while(get_n_pages())
 		remove_document(get_document(0));
 }
@@ -156,9 +115,6 @@ Gobby::Folder::add_text_session(InfTextSession* session,
 
 	set_tab_reorderable(*userview, true);
 
-	// Record the session, for debugging purposes:
-	record(session, title);
-
 	if(m_hide_single_tab && get_n_pages() > 1)
 		set_show_tabs(true);
 	return *view;
@@ -202,10 +158,7 @@ void Gobby::Folder::remove_document(SessionView& view)
 {
 	m_signal_document_removed.emit(view);
 
-	// Finish the record
 	InfSession* session = view.get_session();
-	g_object_set_data(G_OBJECT(session), "GOBBY_SESSION_RECORD", NULL);
-
 	g_object_ref(session);
 	// This relies on the sessionuserview being the direct parent of
 	// view - maybe we should make a loop here instead which searches
@@ -168,6 +168,22 @@ void Gobby::FolderManager::add_document(InfBrowser* browser,
                                         const InfBrowserIter* iter,
                                         InfSessionProxy* proxy,
                                         UserJoinRef userjoin)
+{
+	add_document_impl(browser, iter, proxy, userjoin, true);
+}
+
+void Gobby::FolderManager::add_background_document(InfBrowser* browser,
+                                                   const InfBrowserIter* iter,
+                                                   InfSessionProxy* proxy)
+{
+	add_document_impl(browser, iter, proxy, NULL, false);
+}
+
+void Gobby::FolderManager::add_document_impl(InfBrowser* browser,
+                                             const InfBrowserIter* iter,
+                                             InfSessionProxy* proxy,
+                                             UserJoinRef userjoin,
+                                             bool activate)
 {
 	gchar* hostname;
 
@@ -251,10 +267,16 @@ void Gobby::FolderManager::add_document(InfBrowser* browser,
 	g_free(hostname);
 
 	// Highlight the newly created session
-	folder->switch_to_document(*view);
-	if(text_view)
-		gtk_widget_grab_focus(GTK_WIDGET(text_view->get_text_view()));
-	if(iter) m_browser.set_selected(browser, iter);
+	if(activate)
+	{
+		folder->switch_to_document(*view);
+		if(text_view)
+		{
+			gtk_widget_grab_focus(
+				GTK_WIDGET(text_view->get_text_view()));
+		}
+		if(iter) m_browser.set_selected(browser, iter);
+	}
 
 	g_assert(m_session_map.find(session) == m_session_map.end());
 	m_session_map[session] =
@@ -339,7 +361,10 @@ void Gobby::FolderManager::on_unsubscribe_session(InfBrowser* browser,
 		// TODO: It would be nice to keep the session itself alive,
 		// and to only unsubscribe all clients and set the local users
 		// to unavailable.
-		if(inf_session_get_subscription_group(session) != NULL)
+		// The session can be closed already by another window
+		// showing the same document.
+		if(inf_session_get_subscription_group(session) != NULL &&
+		   inf_session_get_status(session) != INF_SESSION_CLOSED)
 		{
 			lookup_document(session)->set_info(
 				_("The document has been removed from the server."),
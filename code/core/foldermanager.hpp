@@ -57,6 +57,10 @@ public:
 	// Add a SessionView for the given session
 	void add_document(InfBrowser* browser, const InfBrowserIter* iter,
 	                  InfSessionProxy* proxy, UserJoinRef userjoin);
+	// Same as add_document(), but leaves the current document as it is.
+	void add_background_document(InfBrowser* browser,
+	                             const InfBrowserIter* iter,
+	                             InfSessionProxy* proxy);
 	void remove_document(SessionView& view);
 
 	SessionView* lookup_document(InfSession* session) const;
@@ -104,6 +108,12 @@ protected:
 	                            InfSessionProxy* proxy,
 	                            InfRequest* request);
 
+	void add_document_impl(InfBrowser* browser,
+	                       const InfBrowserIter* iter,
+	                       InfSessionProxy* proxy,
+	                       UserJoinRef userjoin,
+	                       bool activate);
+
 	void on_text_document_added(SessionView& view);
 	void on_chat_document_added(SessionView& view);
 	void on_document_removed(SessionView& view);
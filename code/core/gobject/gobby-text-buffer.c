@@ -0,0 +1,620 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/gobject/gobby-text-buffer.h"
+
+#include <libinftext/inf-text-default-buffer.h>
+#include <libinfinity/common/inf-buffer.h>
+
+#include <gtksourceview/gtksource.h>
+
+typedef struct _GobbyTextBufferPrivate GobbyTextBufferPrivate;
+struct _GobbyTextBufferPrivate {
+  InfUserTable* user_table;
+
+  /* Either an InfTextDefaultBuffer or, while the buffer is shown, an
+   * InfTextGtkBuffer. All calls are forwarded to it. */
+  InfTextBuffer* buffer;
+  guint n_gtk_users;
+};
+
+enum {
+  PROP_0,
+
+  PROP_USER_TABLE,
+
+  /* overridden */
+  PROP_MODIFIED
+};
+
+#define GOBBY_TEXT_BUFFER_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), GOBBY_TYPE_TEXT_BUFFER, GobbyTextBufferPrivate))
+
+static void gobby_text_buffer_buffer_iface_init(InfBufferInterface* iface);
+static void gobby_text_buffer_text_buffer_iface_init(InfTextBufferInterface* iface);
+G_DEFINE_TYPE_WITH_CODE(GobbyTextBuffer, gobby_text_buffer, G_TYPE_OBJECT,
+  G_ADD_PRIVATE(GobbyTextBuffer)
+  G_IMPLEMENT_INTERFACE(INF_TYPE_BUFFER, gobby_text_buffer_buffer_iface_init)
+  G_IMPLEMENT_INTERFACE(INF_TEXT_TYPE_BUFFER, gobby_text_buffer_text_buffer_iface_init))
+
+static void
+gobby_text_buffer_text_inserted_cb(InfTextBuffer* buffer,
+                                   guint pos,
+                                   InfTextChunk* chunk,
+                                   InfUser* user,
+                                   gpointer user_data)
+{
+  inf_text_buffer_text_inserted(
+    INF_TEXT_BUFFER(user_data),
+    pos,
+    chunk,
+    user
+  );
+}
+
+static void
+gobby_text_buffer_text_erased_cb(InfTextBuffer* buffer,
+                                 guint pos,
+                                 InfTextChunk* chunk,
+                                 InfUser* user,
+                                 gpointer user_data)
+{
+  inf_text_buffer_text_erased(
+    INF_TEXT_BUFFER(user_data),
+    pos,
+    chunk,
+    user
+  );
+}
+
+static void
+gobby_text_buffer_notify_modified_cb(GObject* object,
+                                     GParamSpec* pspec,
+                                     gpointer user_data)
+{
+  g_object_notify(G_OBJECT(user_data), "modified");
+}
+
+/* Moves the text over into new_buffer and forwards to it from now on. The
+ * content does not change, so this does not emit any signals. */
+static void
+gobby_text_buffer_set_buffer(GobbyTextBuffer* buffer,
+                             InfTextBuffer* new_buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  InfTextChunk* chunk;
+  gboolean modified;
+
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  if(priv->buffer != NULL)
+  {
+    chunk = inf_text_buffer_get_slice(
+      priv->buffer,
+      0,
+      inf_text_buffer_get_length(priv->buffer)
+    );
+
+    modified = inf_buffer_get_modified(INF_BUFFER(priv->buffer));
+
+    /* Copying the text is not something the local user can undo */
+    if(INF_TEXT_IS_GTK_BUFFER(new_buffer))
+    {
+      gtk_source_buffer_begin_not_undoable_action(
+        GTK_SOURCE_BUFFER(
+          inf_text_gtk_buffer_get_text_buffer(INF_TEXT_GTK_BUFFER(new_buffer))
+        )
+      );
+    }
+
+    inf_text_buffer_insert_chunk(new_buffer, 0, chunk, NULL);
+    inf_buffer_set_modified(INF_BUFFER(new_buffer), modified);
+
+    if(INF_TEXT_IS_GTK_BUFFER(new_buffer))
+    {
+      gtk_source_buffer_end_not_undoable_action(
+        GTK_SOURCE_BUFFER(
+          inf_text_gtk_buffer_get_text_buffer(INF_TEXT_GTK_BUFFER(new_buffer))
+        )
+      );
+    }
+
+    inf_text_chunk_free(chunk);
+
+    g_signal_handlers_disconnect_by_func(
+      G_OBJECT(priv->buffer),
+      G_CALLBACK(gobby_text_buffer_text_inserted_cb),
+      buffer
+    );
+
+    g_signal_handlers_disconnect_by_func(
+      G_OBJECT(priv->buffer),
+      G_CALLBACK(gobby_text_buffer_text_erased_cb),
+      buffer
+    );
+
+    g_signal_handlers_disconnect_by_func(
+      G_OBJECT(priv->buffer),
+      G_CALLBACK(gobby_text_buffer_notify_modified_cb),
+      buffer
+    );
+
+    g_object_unref(priv->buffer);
+  }
+
+  priv->buffer = new_buffer;
+
+  if(new_buffer != NULL)
+  {
+    g_object_ref(new_buffer);
+
+    /* Connect after, so that the text has been changed by the time the
+     * signal is emitted on the forwarding buffer. */
+    g_signal_connect_after(
+      G_OBJECT(new_buffer),
+      "text-inserted",
+      G_CALLBACK(gobby_text_buffer_text_inserted_cb),
+      buffer
+    );
+
+    g_signal_connect_after(
+      G_OBJECT(new_buffer),
+      "text-erased",
+      G_CALLBACK(gobby_text_buffer_text_erased_cb),
+      buffer
+    );
+
+    g_signal_connect(
+      G_OBJECT(new_buffer),
+      "notify::modified",
+      G_CALLBACK(gobby_text_buffer_notify_modified_cb),
+      buffer
+    );
+  }
+}
+
+static void
+gobby_text_buffer_init(GobbyTextBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  priv->user_table = NULL;
+  priv->buffer = NULL;
+  priv->n_gtk_users = 0;
+}
+
+static void
+gobby_text_buffer_constructed(GObject* object)
+{
+  InfTextDefaultBuffer* default_buffer;
+
+  G_OBJECT_CLASS(gobby_text_buffer_parent_class)->constructed(object);
+
+  default_buffer = inf_text_default_buffer_new("UTF-8");
+  gobby_text_buffer_set_buffer(
+    GOBBY_TEXT_BUFFER(object),
+    INF_TEXT_BUFFER(default_buffer)
+  );
+  g_object_unref(default_buffer);
+}
+
+static void
+gobby_text_buffer_dispose(GObject* object)
+{
+  GobbyTextBuffer* buffer;
+  GobbyTextBufferPrivate* priv;
+
+  buffer = GOBBY_TEXT_BUFFER(object);
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  if(priv->buffer != NULL)
+  {
+    g_signal_handlers_disconnect_by_func(
+      G_OBJECT(priv->buffer),
+      G_CALLBACK(gobby_text_buffer_text_inserted_cb),
+      buffer
+    );
+
+    g_signal_handlers_disconnect_by_func(
+      G_OBJECT(priv->buffer),
+      G_CALLBACK(gobby_text_buffer_text_erased_cb),
+      buffer
+    );
+
+    g_signal_handlers_disconnect_by_func(
+      G_OBJECT(priv->buffer),
+      G_CALLBACK(gobby_text_buffer_notify_modified_cb),
+      buffer
+    );
+
+    g_object_unref(priv->buffer);
+    priv->buffer = NULL;
+  }
+
+  if(priv->user_table != NULL)
+  {
+    g_object_unref(priv->user_table);
+    priv->user_table = NULL;
+  }
+
+  G_OBJECT_CLASS(gobby_text_buffer_parent_class)->dispose(object);
+}
+
+static void
+gobby_text_buffer_set_property(GObject* object,
+                               guint prop_id,
+                               const GValue* value,
+                               GParamSpec* pspec)
+{
+  GobbyTextBuffer* buffer;
+  GobbyTextBufferPrivate* priv;
+
+  buffer = GOBBY_TEXT_BUFFER(object);
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  switch(prop_id)
+  {
+  case PROP_USER_TABLE:
+    g_assert(priv->user_table == NULL); /* construct only */
+    priv->user_table = INF_USER_TABLE(g_value_dup_object(value));
+    break;
+  case PROP_MODIFIED:
+    inf_buffer_set_modified(
+      INF_BUFFER(priv->buffer),
+      g_value_get_boolean(value)
+    );
+
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    break;
+  }
+}
+
+static void
+gobby_text_buffer_get_property(GObject* object,
+                               guint prop_id,
+                               GValue* value,
+                               GParamSpec* pspec)
+{
+  GobbyTextBuffer* buffer;
+  GobbyTextBufferPrivate* priv;
+
+  buffer = GOBBY_TEXT_BUFFER(object);
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  switch(prop_id)
+  {
+  case PROP_USER_TABLE:
+    g_value_set_object(value, priv->user_table);
+    break;
+  case PROP_MODIFIED:
+    g_value_set_boolean(
+      value,
+      inf_buffer_get_modified(INF_BUFFER(priv->buffer))
+    );
+
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    break;
+  }
+}
+
+static void
+gobby_text_buffer_class_init(GobbyTextBufferClass* text_buffer_class)
+{
+  GObjectClass* object_class;
+  object_class = G_OBJECT_CLASS(text_buffer_class);
+
+  object_class->constructed = gobby_text_buffer_constructed;
+  object_class->dispose = gobby_text_buffer_dispose;
+  object_class->set_property = gobby_text_buffer_set_property;
+  object_class->get_property = gobby_text_buffer_get_property;
+
+  g_object_class_install_property(
+    object_class,
+    PROP_USER_TABLE,
+    g_param_spec_object(
+      "user-table",
+      "User table",
+      "A user table of the participating users",
+      INF_TYPE_USER_TABLE,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+    )
+  );
+
+  g_object_class_override_property(object_class, PROP_MODIFIED, "modified");
+}
+
+static gboolean
+gobby_text_buffer_buffer_get_modified(InfBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_buffer_get_modified(INF_BUFFER(priv->buffer));
+}
+
+static void
+gobby_text_buffer_buffer_set_modified(InfBuffer* buffer,
+                                      gboolean modified)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  inf_buffer_set_modified(INF_BUFFER(priv->buffer), modified);
+}
+
+static const gchar*
+gobby_text_buffer_get_encoding(InfTextBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_get_encoding(priv->buffer);
+}
+
+static guint
+gobby_text_buffer_get_length(InfTextBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_get_length(priv->buffer);
+}
+
+static InfTextChunk*
+gobby_text_buffer_get_slice(InfTextBuffer* buffer,
+                            guint pos,
+                            guint len)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_get_slice(priv->buffer, pos, len);
+}
+
+static void
+gobby_text_buffer_insert_text(InfTextBuffer* buffer,
+                              guint pos,
+                              InfTextChunk* chunk,
+                              InfUser* user)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  /* The buffer emits text-inserted, which we forward */
+  inf_text_buffer_insert_chunk(priv->buffer, pos, chunk, user);
+}
+
+static void
+gobby_text_buffer_erase_text(InfTextBuffer* buffer,
+                             guint pos,
+                             guint len,
+                             InfUser* user)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  /* The buffer emits text-erased, which we forward */
+  inf_text_buffer_erase_text(priv->buffer, pos, len, user);
+}
+
+static InfTextBufferIter*
+gobby_text_buffer_create_begin_iter(InfTextBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_create_begin_iter(priv->buffer);
+}
+
+static InfTextBufferIter*
+gobby_text_buffer_create_end_iter(InfTextBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_create_end_iter(priv->buffer);
+}
+
+static void
+gobby_text_buffer_destroy_iter(InfTextBuffer* buffer,
+                               InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  inf_text_buffer_destroy_iter(priv->buffer, iter);
+}
+
+static gboolean
+gobby_text_buffer_iter_next(InfTextBuffer* buffer,
+                            InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_iter_next(priv->buffer, iter);
+}
+
+static gboolean
+gobby_text_buffer_iter_prev(InfTextBuffer* buffer,
+                            InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_iter_prev(priv->buffer, iter);
+}
+
+static gpointer
+gobby_text_buffer_iter_get_text(InfTextBuffer* buffer,
+                                InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_iter_get_text(priv->buffer, iter);
+}
+
+static guint
+gobby_text_buffer_iter_get_offset(InfTextBuffer* buffer,
+                                  InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_iter_get_offset(priv->buffer, iter);
+}
+
+static guint
+gobby_text_buffer_iter_get_length(InfTextBuffer* buffer,
+                                  InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_iter_get_length(priv->buffer, iter);
+}
+
+static gsize
+gobby_text_buffer_iter_get_bytes(InfTextBuffer* buffer,
+                                 InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_iter_get_bytes(priv->buffer, iter);
+}
+
+static guint
+gobby_text_buffer_iter_get_author(InfTextBuffer* buffer,
+                                  InfTextBufferIter* iter)
+{
+  GobbyTextBufferPrivate* priv;
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  return inf_text_buffer_iter_get_author(priv->buffer, iter);
+}
+
+static void
+gobby_text_buffer_buffer_iface_init(InfBufferInterface* iface)
+{
+  iface->get_modified = gobby_text_buffer_buffer_get_modified;
+  iface->set_modified = gobby_text_buffer_buffer_set_modified;
+}
+
+static void
+gobby_text_buffer_text_buffer_iface_init(InfTextBufferInterface* iface)
+{
+  iface->get_encoding = gobby_text_buffer_get_encoding;
+  iface->get_length = gobby_text_buffer_get_length;
+  iface->get_slice = gobby_text_buffer_get_slice;
+  iface->insert_text = gobby_text_buffer_insert_text;
+  iface->erase_text = gobby_text_buffer_erase_text;
+  iface->create_begin_iter = gobby_text_buffer_create_begin_iter;
+  iface->create_end_iter = gobby_text_buffer_create_end_iter;
+  iface->destroy_iter = gobby_text_buffer_destroy_iter;
+  iface->iter_next = gobby_text_buffer_iter_next;
+  iface->iter_prev = gobby_text_buffer_iter_prev;
+  iface->iter_get_text = gobby_text_buffer_iter_get_text;
+  iface->iter_get_offset = gobby_text_buffer_iter_get_offset;
+  iface->iter_get_length = gobby_text_buffer_iter_get_length;
+  iface->iter_get_bytes = gobby_text_buffer_iter_get_bytes;
+  iface->iter_get_author = gobby_text_buffer_iter_get_author;
+  iface->text_inserted = NULL;
+  iface->text_erased = NULL;
+}
+
+GobbyTextBuffer*
+gobby_text_buffer_new(InfUserTable* user_table)
+{
+  GObject* object;
+
+  object = g_object_new(
+    GOBBY_TYPE_TEXT_BUFFER,
+    "user-table", user_table,
+    NULL
+  );
+
+  return GOBBY_TEXT_BUFFER(object);
+}
+
+/**
+ * gobby_text_buffer_acquire_gtk_buffer:
+ * @buffer: A #GobbyTextBuffer.
+ *
+ * Moves the text of @buffer into an #InfTextGtkBuffer, if it is not there
+ * already, so that it can be shown in a #GtkTextView. The returned buffer
+ * is owned by @buffer and stays valid until the matching call to
+ * gobby_text_buffer_release_gtk_buffer().
+ *
+ * Returns: The #InfTextGtkBuffer holding the text of @buffer.
+ */
+InfTextGtkBuffer*
+gobby_text_buffer_acquire_gtk_buffer(GobbyTextBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  GtkSourceBuffer* textbuffer;
+  InfTextGtkBuffer* gtk_buffer;
+
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+
+  if(priv->n_gtk_users == 0)
+  {
+    textbuffer = gtk_source_buffer_new(NULL);
+    gtk_buffer = inf_text_gtk_buffer_new(
+      GTK_TEXT_BUFFER(textbuffer),
+      priv->user_table
+    );
+
+    gobby_text_buffer_set_buffer(buffer, INF_TEXT_BUFFER(gtk_buffer));
+
+    g_object_unref(gtk_buffer);
+    g_object_unref(textbuffer);
+  }
+
+  ++priv->n_gtk_users;
+  return INF_TEXT_GTK_BUFFER(priv->buffer);
+}
+
+/**
+ * gobby_text_buffer_release_gtk_buffer:
+ * @buffer: A #GobbyTextBuffer.
+ *
+ * Releases a buffer obtained with gobby_text_buffer_acquire_gtk_buffer().
+ * When it is not used anymore, the text is moved back into an
+ * #InfTextDefaultBuffer, and the #InfTextGtkBuffer is dropped.
+ */
+void
+gobby_text_buffer_release_gtk_buffer(GobbyTextBuffer* buffer)
+{
+  GobbyTextBufferPrivate* priv;
+  InfTextDefaultBuffer* default_buffer;
+
+  priv = GOBBY_TEXT_BUFFER_PRIVATE(buffer);
+  g_return_if_fail(priv->n_gtk_users > 0);
+
+  --priv->n_gtk_users;
+  if(priv->n_gtk_users == 0)
+  {
+    default_buffer = inf_text_default_buffer_new("UTF-8");
+    gobby_text_buffer_set_buffer(buffer, INF_TEXT_BUFFER(default_buffer));
+    g_object_unref(default_buffer);
+  }
+}
@@ -0,0 +1,75 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __GOBBY_TEXT_BUFFER_H__
+#define __GOBBY_TEXT_BUFFER_H__
+
+#include <libinftextgtk/inf-text-gtk-buffer.h>
+#include <libinfinity/common/inf-user-table.h>
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GOBBY_TYPE_TEXT_BUFFER                 (gobby_text_buffer_get_type())
+#define GOBBY_TEXT_BUFFER(obj)                 (G_TYPE_CHECK_INSTANCE_CAST((obj), GOBBY_TYPE_TEXT_BUFFER, GobbyTextBuffer))
+#define GOBBY_TEXT_BUFFER_CLASS(klass)         (G_TYPE_CHECK_CLASS_CAST((klass), GOBBY_TYPE_TEXT_BUFFER, GobbyTextBufferClass))
+#define GOBBY_IS_TEXT_BUFFER(obj)              (G_TYPE_CHECK_INSTANCE_TYPE((obj), GOBBY_TYPE_TEXT_BUFFER))
+#define GOBBY_IS_TEXT_BUFFER_CLASS(klass)      (G_TYPE_CHECK_CLASS_TYPE((klass), GOBBY_TYPE_TEXT_BUFFER))
+#define GOBBY_TEXT_BUFFER_GET_CLASS(obj)       (G_TYPE_INSTANCE_GET_CLASS((obj), GOBBY_TYPE_TEXT_BUFFER, GobbyTextBufferClass))
+
+typedef struct _GobbyTextBuffer GobbyTextBuffer;
+typedef struct _GobbyTextBufferClass GobbyTextBufferClass;
+
+/**
+ * GobbyTextBufferClass:
+ *
+ * This structure does not contain any public fields.
+ */
+struct _GobbyTextBufferClass {
+  /*< private >*/
+  GObjectClass parent_class;
+};
+
+/**
+ * GobbyTextBuffer:
+ *
+ * #GobbyTextBuffer is an #InfTextBuffer which keeps its text in an
+ * #InfTextDefaultBuffer as long as it is not shown. While it is shown, the
+ * text lives in an #InfTextGtkBuffer instead, which is created on demand.
+ */
+struct _GobbyTextBuffer {
+  /*< private >*/
+  GObject parent;
+};
+
+GType
+gobby_text_buffer_get_type(void) G_GNUC_CONST;
+
+GobbyTextBuffer*
+gobby_text_buffer_new(InfUserTable* user_table);
+
+InfTextGtkBuffer*
+gobby_text_buffer_acquire_gtk_buffer(GobbyTextBuffer* buffer);
+
+void
+gobby_text_buffer_release_gtk_buffer(GobbyTextBuffer* buffer);
+
+G_END_DECLS
+
+#endif /* __GOBBY_TEXT_BUFFER_H__ */
+
+/* vim:set et sw=2 ts=2: */
@@ -13,7 +13,6 @@
  * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
-
 #include "core/knownhoststorage.hpp"
 #include "util/file.hpp"
 
@@ -24,10 +23,16 @@
 
 #include <glibmm/miscutils.h>
 
+#include <glib/gstdio.h>
+
 #include <libinfinity/common/inf-protocol.h>
 
+#include <cstring>
+
 namespace
 {
+	const char SECTION[] = "hosts";
+
 	struct HostInfo
 	{
 		std::string name;
@@ -35,6 +40,13 @@ namespace
 		std::string service;
 	};
 
+	// Hosts are stored with "hostname service" as key and the name as
+	// value. Neither host names nor services can contain spaces.
+	std::string host_key(const HostInfo& info)
+	{
+		return info.hostname + " " + info.service;
+	}
+
 	bool load_host(xmlpp::Element* node, HostInfo& info)
 	{
 		bool found_name = false;
@@ -74,29 +86,197 @@ namespace
 		return found_name && found_hostname;
 	}
 
-	// Location to store the hosts file:
-	std::string filename()
+	// Fills info with the connection parameters of the given browser
+	// model item. Returns false for items that should not be stored,
+	// such as discovered ones.
+	bool get_host(GtkTreeModel* model, GtkTreeIter* iter,
+	              InfBrowser* browser, HostInfo& info)
+	{
+		InfDiscovery* discovery;
+		gtk_tree_model_get(
+			model, iter,
+			INF_GTK_BROWSER_MODEL_COL_DISCOVERY, &discovery,
+			-1);
+
+		// Skip items that were discovered
+		if(discovery != NULL)
+		{
+			g_object_unref(discovery);
+			return false;
+		}
+
+		if(!INFC_IS_BROWSER(browser))
+			return false;
+
+		InfXmlConnection* connection =
+			infc_browser_get_connection(INFC_BROWSER(browser));
+		if(connection == NULL || !INF_IS_XMPP_CONNECTION(connection))
+			return false;
+
+		InfTcpConnection* tcp;
+		g_object_get(
+			G_OBJECT(connection), "tcp-connection", &tcp, NULL);
+
+		InfNameResolver* resolver;
+		g_object_get(G_OBJECT(tcp), "resolver", &resolver, NULL);
+		g_object_unref(tcp);
+
+		// TODO: If resolver is NULL, should we instead
+		// record hostname and port number?
+		if(resolver == NULL)
+			return false;
+
+		const char* hostname =
+			inf_name_resolver_get_hostname(resolver);
+		const char* service =
+			inf_name_resolver_get_service(resolver);
+		const char* srv =
+			inf_name_resolver_get_srv(resolver);
+
+		if(strcmp(srv, "_infinote._tcp") != 0)
+		{
+			g_object_unref(resolver);
+			return false;
+		}
+
+		gchar* name;
+		gtk_tree_model_get(
+			model, iter,
+			INF_GTK_BROWSER_MODEL_COL_NAME, &name,
+			-1);
+
+		info.name = name;
+		info.hostname = hostname;
+		info.service = service;
+
+		g_free(name);
+		g_object_unref(resolver);
+		return true;
+	}
+
+	// Location of the hosts file of older versions:
+	std::string legacy_filename()
 	{
 		return Gobby::config_filename("hosts.xml");
 	}
 }
 
-Gobby::KnownHostStorage::KnownHostStorage(Browser& browser):
-	m_browser(browser)
+Gobby::KnownHostStorage::KnownHostStorage(BrowserStore& browser_store,
+                                          StateStore& store):
+	m_browser_store(browser_store), m_store(store), m_loaded(false)
+{
+}
+
+Gobby::KnownHostStorage::~KnownHostStorage()
+{
+	// Nothing to do if the hosts have never been shown in the browser
+	if(!m_loaded) return;
+
+	g_signal_handler_disconnect(m_browser_store.get_store(),
+	                            m_set_browser_handler);
+
+	// Forget about hosts that have been removed from the browser
+	StateStore::Section hosts;
+
+	GtkTreeModel* model = GTK_TREE_MODEL(m_browser_store.get_store());
+
+	GtkTreeIter iter;
+	for(gboolean have_item = gtk_tree_model_get_iter_first(model, &iter);
+	    have_item == TRUE;
+	    have_item = gtk_tree_model_iter_next(model, &iter))
+	{
+		InfBrowser* browser;
+		gtk_tree_model_get(
+			model, &iter,
+			INF_GTK_BROWSER_MODEL_COL_BROWSER, &browser,
+			-1);
+		if(browser == NULL) continue;
+
+		HostInfo info;
+		if(get_host(model, &iter, browser, info))
+			hosts[host_key(info)] = info.name;
+
+		g_object_unref(browser);
+	}
+
+	// Copy, since we modify the section while iterating
+	const StateStore::Section old_hosts = m_store.get_section(SECTION);
+	for(StateStore::Section::const_iterator iter = old_hosts.begin();
+	    iter != old_hosts.end(); ++ iter)
+	{
+		if(hosts.find(iter->first) == hosts.end())
+			m_store.remove(SECTION, iter->first);
+	}
+
+	for(StateStore::Section::const_iterator iter = hosts.begin();
+	    iter != hosts.end(); ++ iter)
+	{
+		m_store.set(SECTION, iter->first, iter->second);
+	}
+}
+
+void Gobby::KnownHostStorage::load()
 {
+	if(m_loaded) return;
+	m_loaded = true;
+
+	if(!m_store.has_section(SECTION))
+		migrate();
+
+	const StateStore::Section& section = m_store.get_section(SECTION);
+	for(StateStore::Section::const_iterator iter = section.begin();
+	    iter != section.end(); ++ iter)
+	{
+		const std::string::size_type pos = iter->first.rfind(' ');
+		if(pos == std::string::npos) continue;
+
+		// TODO: Store device name as well so that we can recover
+		// IPv6 link-local connections.
+		m_browser_store.add_remote(iter->first.substr(0, pos),
+		                           iter->first.substr(pos + 1),
+		                           0, false);
+	}
+
+	m_set_browser_handler = g_signal_connect_after(
+		G_OBJECT(m_browser_store.get_store()), "set-browser",
+		G_CALLBACK(on_set_browser_static), this);
+}
+
+void Gobby::KnownHostStorage::on_set_browser(GtkTreeIter* iter,
+                                             InfBrowser* new_browser)
+{
+	if(new_browser == NULL) return;
+
+	HostInfo info;
+	if(get_host(GTK_TREE_MODEL(m_browser_store.get_store()), iter,
+	            new_browser, info))
+	{
+		m_store.set(SECTION, host_key(info), info.name);
+	}
+}
+
+// Imports the hosts.xml file written by older versions into the state
+// store.
+void Gobby::KnownHostStorage::migrate()
+{
+	m_store.clear(SECTION);
+
 	xmlpp::DomParser parser;
 
 	try
 	{
-		parser.parse_file(filename());
+		parser.parse_file(legacy_filename());
 	}
 	catch(xmlpp::exception& e)
 	{
 		// Could not open file, or file is invalid. Start
 		// with a single entry.
-		std::string service = Glib::ustring::compose(
+		HostInfo info;
+		info.name = "gobby.0x539.de";
+		info.hostname = "gobby.0x539.de";
+		info.service = Glib::ustring::compose(
 			"%1", inf_protocol_get_default_port());
-		browser.add_remote("gobby.0x539.de", service, 0, false);
+		m_store.set(SECTION, host_key(info), info.name);
 	}
 
 	try
@@ -123,14 +303,9 @@ Gobby::KnownHostStorage::KnownHostStorage(Browser& browser):
 					if(child->get_name() == "host" &&
 					   load_host(child, info))
 					{
-						// TODO: Store device name
-						// in the file as well so
-						// that we can recover IPv6
-						// link-local connections.
-						browser.add_remote(
-							info.hostname,
-							info.service,
-							0, false);
+						m_store.set(SECTION,
+						            host_key(info),
+						            info.name);
 					}
 				}
 			}
@@ -140,125 +315,6 @@ Gobby::KnownHostStorage::KnownHostStorage(Browser& browser):
 	{
 		// Could not read file, ignore
 	}
-}
-
-Gobby::KnownHostStorage::~KnownHostStorage()
-{
-	try
-	{
-		create_directory_with_parents(
-			Glib::path_get_dirname(filename()), 0700);
-		xmlpp::Document document;
-		xmlpp::Element* root = document.create_root_node("hosts");
-		
-		GtkTreeModel* model = GTK_TREE_MODEL(m_browser.get_store());
-
-		GtkTreeIter iter;
-		for(gboolean have_item =
-			gtk_tree_model_get_iter_first(model, &iter);
-		    have_item == TRUE;
-		    have_item = gtk_tree_model_iter_next(model, &iter))
-		{
-			InfBrowser* browser;
-			InfDiscovery* discovery;
-			gtk_tree_model_get(
-				model, &iter,
-				INF_GTK_BROWSER_MODEL_COL_BROWSER,
-				&browser,
-				INF_GTK_BROWSER_MODEL_COL_DISCOVERY,
-				&discovery,
-				-1);
-
-			// Skip items that were discovered
-			if(discovery != NULL)
-			{
-				g_object_unref(discovery);
-				if(browser != NULL) g_object_unref(browser);
-				continue;
-			}
-
-			if(browser == NULL)
-				continue;
-
-			if(!INFC_IS_BROWSER(browser))
-			{
-				g_object_unref(browser);
-				continue;
-			}
-
-			InfXmlConnection* connection =
-				infc_browser_get_connection(
-					INFC_BROWSER(browser));
-			if(connection == NULL ||
-			   !INF_IS_XMPP_CONNECTION(connection))
-			{
-				g_object_unref(browser);
-				continue;
-			}
-
-			InfTcpConnection* tcp;
-			g_object_get(
-				G_OBJECT(connection), 
-				"tcp-connection", &tcp,
-				NULL);
-			g_object_unref(browser);
-			
-			InfNameResolver* resolver;
-			g_object_get(
-				G_OBJECT(tcp), "resolver", &resolver, NULL);
-			g_object_unref(tcp);
-
-			// TODO: If resolver is NULL, should we instead
-			// record hostname and port number?
-			if(resolver == NULL)
-				continue;
-
-			const char* hostname =
-				inf_name_resolver_get_hostname(resolver);
-			const char* service =
-				inf_name_resolver_get_service(resolver);
-			const char* srv =
-				inf_name_resolver_get_srv(resolver);
-
-			if(strcmp(srv, "_infinote._tcp") != 0)
-			{
-				g_object_unref(resolver);
-				continue;
-			}
-
-			gchar* name;
-			gtk_tree_model_get(
-				model, &iter,
-				INF_GTK_BROWSER_MODEL_COL_NAME, &name,
-				-1);
-
-			xmlpp::Element* child = root->add_child("host");
-			xmlpp::Element* name_elem =
-				child->add_child("name");
-			name_elem->set_child_text(name);
-			
-			xmlpp::Element* hostname_elem =
-				child->add_child("hostname");
-			hostname_elem->set_child_text(hostname);
-
-			xmlpp::Element* service_elem =
-				child->add_child("service");
-			service_elem->set_child_text(service);
-
-			g_object_unref(resolver);
-		}
 
-		document.write_to_file_formatted(filename());
-	}
-	catch(Glib::Exception& e)
-	{
-		g_warning("Could not write hosts file: %s",
-		          e.what().c_str());
-	}
-	catch(std::exception& e)
-	{
-		g_warning("Could not write hosts file: %s",
-		          e.what());
-	}
+	g_unlink(legacy_filename().c_str());
 }
-
@@ -17,22 +17,48 @@
 #ifndef _GOBBY_KNOWN_HOST_STORAGE_HPP_
 #define _GOBBY_KNOWN_HOST_STORAGE_HPP_
 
-#include "core/browser.hpp"
+#include "core/browserstore.hpp"
+#include "util/statestore.hpp"
 
-// This class stores the connection parameters of all connections on
-// shutdown, and on startup reads them back in and creates connection items
-// in the browser.
+// This class stores the connection parameters of all connections in the
+// state store as soon as they are made, and on startup reads them back in
+// and creates connection items in the browser. Hosts that have been removed
+// from the browser are forgotten on shutdown.
+//
+// Creating the connection items is deferred until load() is called, so that
+// it does not delay the first frame.
 namespace Gobby
 {
 
 class KnownHostStorage
 {
 public:
-	KnownHostStorage(Browser& browser);
+	KnownHostStorage(BrowserStore& browser_store, StateStore& store);
 	~KnownHostStorage();
 
+	void load();
+
 protected:
-	Browser& m_browser;
+	static void on_set_browser_static(InfGtkBrowserModel* model,
+	                                  GtkTreePath* path,
+	                                  GtkTreeIter* iter,
+	                                  InfBrowser* old_browser,
+	                                  InfBrowser* new_browser,
+	                                  gpointer user_data)
+	{
+		static_cast<KnownHostStorage*>(user_data)->
+			on_set_browser(iter, new_browser);
+	}
+
+	void on_set_browser(GtkTreeIter* iter, InfBrowser* new_browser);
+
+	void migrate();
+
+	BrowserStore& m_browser_store;
+	StateStore& m_store;
+
+	bool m_loaded;
+	gulong m_set_browser_handler;
 };
 
 }
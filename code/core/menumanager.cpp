@@ -41,7 +41,8 @@ namespace
 	}
 } // anonymous namespace
 
-Gobby::MenuManager::MenuManager(GtkSourceLanguageManager* language_manager)
+Gobby::MenuManager::MenuManager(GtkSourceLanguageManager* language_manager):
+	m_language_manager(language_manager), m_languages_loaded(false)
 {
 	Glib::RefPtr<Gtk::Builder> builder =
 		Gtk::Builder::create_from_resource(
@@ -51,12 +52,18 @@ Gobby::MenuManager::MenuManager(GtkSourceLanguageManager* language_manager)
 		builder->get_object("appmenu"));
 	m_menu = Glib::RefPtr<Gio::Menu>::cast_dynamic(
 		builder->get_object("winmenu"));
+}
+
+void Gobby::MenuManager::load_languages()
+{
+	if(m_languages_loaded) return;
+	m_languages_loaded = true;
 
 	Glib::RefPtr<Gio::Menu> highlight_mode_menu = get_highlight_mode_menu();
 
 	const gchar* const* language_ids =
 		gtk_source_language_manager_get_language_ids(
-			language_manager);
+			m_language_manager);
 	if(language_ids != NULL)
 	{
 		typedef std::list<GtkSourceLanguage*> LanguageList;
@@ -67,7 +74,7 @@ Gobby::MenuManager::MenuManager(GtkSourceLanguageManager* language_manager)
 		{
 			GtkSourceLanguage* language =
 				gtk_source_language_manager_get_language(
-					language_manager, *id);
+					m_language_manager, *id);
 			if(gtk_source_language_get_hidden(language)) continue;
 
 			const std::string section =
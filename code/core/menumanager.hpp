@@ -32,7 +32,14 @@ public:
 
 	Glib::RefPtr<Gio::MenuModel> get_app_menu() { return m_app_menu; }
 	Glib::RefPtr<Gio::MenuModel> get_menu() { return m_menu; }
+
+	// Fills the highlight mode menu. This requires scanning all
+	// language definitions, so it is done only after startup.
+	void load_languages();
 protected:
+	GtkSourceLanguageManager* m_language_manager;
+	bool m_languages_loaded;
+
 	Glib::RefPtr<Gio::Menu> m_app_menu;
 	Glib::RefPtr<Gio::Menu> m_menu;
 
@@ -0,0 +1,414 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/nodeindex.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+	struct Candidate
+	{
+		int score;
+		std::string::size_type length;
+		std::size_t index;
+	};
+
+	// Orders better candidates first: higher scores, then shorter paths.
+	bool is_better(const Candidate& first, const Candidate& second)
+	{
+		if(first.score != second.score)
+			return first.score > second.score;
+		if(first.length != second.length)
+			return first.length < second.length;
+		return first.index < second.index;
+	}
+
+	bool is_separator(char c)
+	{
+		return c == '/' || c == '-' || c == '_' || c == '.' ||
+		       c == ' ';
+	}
+
+	// Scores the match of query within key[begin, end], where both the
+	// first and the last character of the range are matched. name is the
+	// offset of the document name within key.
+	int score_range(const std::string& query, const std::string& key,
+	                std::string::size_type begin,
+	                std::string::size_type end,
+	                std::string::size_type name)
+	{
+		int result = 0;
+		std::string::size_type q = 0;
+		std::string::size_type prev = std::string::npos;
+
+		for(std::string::size_type i = begin;
+		    i <= end && q < query.length(); ++i)
+		{
+			if(key[i] != query[q]) continue;
+
+			result += 16;
+			if(prev != std::string::npos && prev + 1 == i)
+				result += 12;
+			if(i == 0 || is_separator(key[i - 1]))
+				result += 10;
+
+			prev = i;
+			++q;
+		}
+
+		// Penalize characters skipped in between
+		result -= static_cast<int>(end - begin + 1 - query.length());
+
+		// Prefer matches within the document name over matches
+		// spread across the directories leading to it
+		if(begin >= name)
+			result += 20;
+
+		return result;
+	}
+}
+
+Gobby::NodeIndex::NodeIndex(InfGtkBrowserModel* model):
+	m_model(model)
+{
+	g_object_ref(m_model);
+
+	m_set_browser_handler = g_signal_connect(
+		G_OBJECT(m_model), "set-browser",
+		G_CALLBACK(&on_set_browser_static), this);
+}
+
+Gobby::NodeIndex::~NodeIndex()
+{
+	for(BrowserMap::iterator iter = m_browsers.begin();
+	    iter != m_browsers.end(); ++iter)
+	{
+		g_signal_handler_disconnect(
+			iter->first, iter->second.node_added_handler);
+		g_signal_handler_disconnect(
+			iter->first, iter->second.node_removed_handler);
+		g_signal_handler_disconnect(
+			iter->first, iter->second.notify_status_handler);
+	}
+
+	g_signal_handler_disconnect(m_model, m_set_browser_handler);
+	g_object_unref(m_model);
+}
+
+Gobby::NodeIndex::MatchList
+Gobby::NodeIndex::search(const Glib::ustring& query,
+                         unsigned int max_matches) const
+{
+	MatchList matches;
+	if(query.empty() || max_matches == 0) return matches;
+
+	gchar* folded = g_utf8_casefold(query.c_str(), -1);
+	const std::string key(folded);
+	g_free(folded);
+
+	const guint64 mask = make_mask(key);
+
+	// Keep the best max_matches candidates in a heap whose top is the
+	// worst of them, so that each entry costs at most O(log k).
+	std::vector<Candidate> heap;
+	heap.reserve(max_matches);
+
+	for(EntryList::size_type i = 0; i < m_entries.size(); ++i)
+	{
+		const Entry& entry = m_entries[i];
+		if((entry.mask & mask) != mask) continue;
+
+		const int entry_score = score(key, entry.key, entry.name);
+		if(entry_score < 0) continue;
+
+		const Candidate candidate = {
+			entry_score, entry.path.length(), i
+		};
+
+		if(heap.size() < max_matches)
+		{
+			heap.push_back(candidate);
+			std::push_heap(heap.begin(), heap.end(), is_better);
+		}
+		else if(is_better(candidate, heap.front()))
+		{
+			std::pop_heap(heap.begin(), heap.end(), is_better);
+			heap.back() = candidate;
+			std::push_heap(heap.begin(), heap.end(), is_better);
+		}
+	}
+
+	std::sort_heap(heap.begin(), heap.end(), is_better);
+
+	matches.reserve(heap.size());
+	for(std::vector<Candidate>::const_iterator iter = heap.begin();
+	    iter != heap.end(); ++iter)
+	{
+		const Entry& entry = m_entries[iter->index];
+		const Match match = { entry.browser, entry.path, iter->score };
+		matches.push_back(match);
+	}
+
+	return matches;
+}
+
+bool Gobby::NodeIndex::has_browser(InfBrowser* browser) const
+{
+	return m_browsers.find(browser) != m_browsers.end();
+}
+
+const std::string&
+Gobby::NodeIndex::get_browser_name(InfBrowser* browser) const
+{
+	BrowserMap::const_iterator iter = m_browsers.find(browser);
+	g_assert(iter != m_browsers.end());
+	return iter->second.name;
+}
+
+void Gobby::NodeIndex::on_set_browser(GtkTreeIter* iter,
+                                      InfBrowser* old_browser,
+                                      InfBrowser* new_browser)
+{
+	if(old_browser != NULL)
+	{
+		BrowserMap::iterator map_iter = m_browsers.find(old_browser);
+		g_assert(map_iter != m_browsers.end());
+
+		g_signal_handler_disconnect(
+			old_browser, map_iter->second.node_added_handler);
+		g_signal_handler_disconnect(
+			old_browser, map_iter->second.node_removed_handler);
+		g_signal_handler_disconnect(
+			old_browser, map_iter->second.notify_status_handler);
+
+		m_browsers.erase(map_iter);
+		remove_browser_entries(old_browser);
+	}
+
+	if(new_browser != NULL)
+	{
+		g_assert(m_browsers.find(new_browser) == m_browsers.end());
+		BrowserInfo& info = m_browsers[new_browser];
+
+		gchar* name;
+		gtk_tree_model_get(
+			GTK_TREE_MODEL(m_model), iter,
+			INF_GTK_BROWSER_MODEL_COL_NAME, &name, -1);
+		if(name != NULL) info.name = name;
+		g_free(name);
+
+		info.node_added_handler = g_signal_connect(
+			G_OBJECT(new_browser), "node-added",
+			G_CALLBACK(on_node_added_static), this);
+		info.node_removed_handler = g_signal_connect(
+			G_OBJECT(new_browser), "node-removed",
+			G_CALLBACK(on_node_removed_static), this);
+		info.notify_status_handler = g_signal_connect(
+			G_OBJECT(new_browser), "notify::status",
+			G_CALLBACK(on_notify_status_static), this);
+
+		// The browser might have explored nodes already, for example
+		// the local directory.
+		on_notify_status(new_browser);
+	}
+}
+
+void Gobby::NodeIndex::on_node_added(InfBrowser* browser,
+                                     InfBrowserIter* iter)
+{
+	add_explored(browser, iter);
+}
+
+void Gobby::NodeIndex::on_node_removed(InfBrowser* browser,
+                                       InfBrowserIter* iter)
+{
+	if(!inf_browser_is_subdirectory(browser, iter))
+	{
+		PositionMap::iterator pos_iter =
+			m_positions.find(NodeKey(browser, iter->node_id));
+		if(pos_iter != m_positions.end())
+			remove_entry(pos_iter->second);
+		return;
+	}
+
+	// Removing a subdirectory does not emit node-removed for its
+	// children, so drop everything below it.
+	gchar* path = inf_browser_get_path(browser, iter);
+	std::string prefix(path);
+	g_free(path);
+
+	if(prefix.empty() || prefix[prefix.length() - 1] != '/')
+		prefix += '/';
+
+	for(EntryList::size_type i = m_entries.size(); i > 0; --i)
+	{
+		const Entry& entry = m_entries[i - 1];
+		if(entry.browser == browser &&
+		   entry.path.compare(0, prefix.length(), prefix) == 0)
+		{
+			remove_entry(i - 1);
+		}
+	}
+}
+
+void Gobby::NodeIndex::on_notify_status(InfBrowser* browser)
+{
+	InfBrowserStatus status;
+	g_object_get(G_OBJECT(browser), "status", &status, NULL);
+
+	if(status == INF_BROWSER_OPEN)
+	{
+		InfBrowserIter root;
+		if(inf_browser_get_root(browser, &root))
+			add_explored(browser, &root);
+	}
+	else if(status == INF_BROWSER_CLOSED)
+	{
+		// The nodes go away with the connection
+		remove_browser_entries(browser);
+	}
+}
+
+guint64 Gobby::NodeIndex::make_mask(const std::string& str)
+{
+	guint64 mask = 0;
+	for(std::string::const_iterator iter = str.begin();
+	    iter != str.end(); ++iter)
+	{
+		mask |= G_GUINT64_CONSTANT(1) <<
+			(static_cast<unsigned char>(*iter) & 63);
+	}
+
+	return mask;
+}
+
+// Returns a negative value if key does not contain all characters of query
+// in order. Otherwise, the better score of two candidate ranges is returned:
+// the first range that contains the query, and the last one. The latter
+// usually finds matches in the document name, which starts at offset name,
+// rather than in the directories leading to it.
+int Gobby::NodeIndex::score(const std::string& query, const std::string& key,
+                             std::string::size_type name)
+{
+	const std::string::size_type n = query.length();
+
+	// Find the end of the first match, then the latest start before it
+	std::string::size_type q = 0;
+	std::string::size_type first_end = 0;
+	for(; first_end < key.length(); ++first_end)
+		if(key[first_end] == query[q] && ++q == n)
+			break;
+	if(q < n) return -1;
+
+	std::string::size_type first_begin = first_end;
+	for(q = n; ; --first_begin)
+		if(key[first_begin] == query[q - 1] && --q == 0)
+			break;
+
+	const int first_score =
+		score_range(query, key, first_begin, first_end, name);
+
+	// If the first match is within the document name already, then so
+	// is the last one, and it is unlikely to be much better.
+	if(first_begin >= name) return first_score;
+
+	// Find the start of the last match, then the earliest end after it
+	std::string::size_type last_begin = key.length();
+	for(q = n; ; )
+		if(key[--last_begin] == query[q - 1] && --q == 0)
+			break;
+	if(last_begin == first_begin) return first_score;
+
+	std::string::size_type last_end = last_begin;
+	for(q = 0; ; ++last_end)
+		if(key[last_end] == query[q] && ++q == n)
+			break;
+
+	return std::max(
+		first_score,
+		score_range(query, key, last_begin, last_end, name));
+}
+
+void Gobby::NodeIndex::add_explored(InfBrowser* browser,
+                                    InfBrowserIter* iter)
+{
+	if(!inf_browser_is_subdirectory(browser, iter))
+	{
+		add_entry(browser, iter);
+	}
+	else if(inf_browser_get_explored(browser, iter))
+	{
+		InfBrowserIter child = *iter;
+		if(inf_browser_get_child(browser, &child))
+		{
+			do
+			{
+				add_explored(browser, &child);
+			} while(inf_browser_get_next(browser, &child));
+		}
+	}
+}
+
+void Gobby::NodeIndex::add_entry(InfBrowser* browser,
+                                 const InfBrowserIter* iter)
+{
+	const NodeKey node_key(browser, iter->node_id);
+	if(m_positions.find(node_key) != m_positions.end()) return;
+
+	gchar* path = inf_browser_get_path(browser, iter);
+	gchar* folded = g_utf8_casefold(path, -1);
+
+	Entry entry;
+	entry.browser = browser;
+	entry.node_id = iter->node_id;
+	entry.path = path;
+	entry.key = folded;
+	entry.mask = make_mask(entry.key);
+
+	const std::string::size_type slash = entry.key.rfind('/');
+	entry.name = (slash == std::string::npos) ? 0 : slash + 1;
+
+	g_free(path);
+	g_free(folded);
+
+	m_positions[node_key] = m_entries.size();
+	m_entries.push_back(entry);
+}
+
+void Gobby::NodeIndex::remove_entry(EntryList::size_type index)
+{
+	Entry& entry = m_entries[index];
+	m_positions.erase(NodeKey(entry.browser, entry.node_id));
+
+	if(index + 1 < m_entries.size())
+	{
+		entry = m_entries.back();
+		m_positions[NodeKey(entry.browser, entry.node_id)] = index;
+	}
+
+	m_entries.pop_back();
+}
+
+void Gobby::NodeIndex::remove_browser_entries(InfBrowser* browser)
+{
+	// Walking backwards, every entry moved into a gap has been looked
+	// at already.
+	for(EntryList::size_type i = m_entries.size(); i > 0; --i)
+		if(m_entries[i - 1].browser == browser)
+			remove_entry(i - 1);
+}
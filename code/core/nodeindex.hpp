@@ -0,0 +1,156 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_NODEINDEX_HPP_
+#define _GOBBY_NODEINDEX_HPP_
+
+#include <libinfgtk/inf-gtk-browser-model.h>
+#include <libinfinity/common/inf-browser.h>
+
+#include <glibmm/ustring.h>
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Gobby
+{
+
+// Keeps the paths of all explored documents of all browsers of a browser
+// model in a flat list, so that they can be searched without going through
+// the tree model. The list is updated incrementally as nodes are added and
+// removed.
+class NodeIndex
+{
+public:
+	struct Match
+	{
+		InfBrowser* browser;
+		std::string path;
+		int score;
+	};
+
+	typedef std::vector<Match> MatchList;
+
+	NodeIndex(InfGtkBrowserModel* model);
+	~NodeIndex();
+
+	// Returns the documents whose path contains the characters of query
+	// in order, ignoring case, best matches first. At most max_matches
+	// documents are returned.
+	MatchList search(const Glib::ustring& query,
+	                 unsigned int max_matches) const;
+
+	bool has_browser(InfBrowser* browser) const;
+	const std::string& get_browser_name(InfBrowser* browser) const;
+
+	unsigned int get_n_entries() const { return m_entries.size(); }
+
+protected:
+	static void on_set_browser_static(InfGtkBrowserModel* model,
+	                                  GtkTreePath* path,
+	                                  GtkTreeIter* iter,
+	                                  InfBrowser* old_browser,
+	                                  InfBrowser* new_browser,
+	                                  gpointer user_data)
+	{
+		static_cast<NodeIndex*>(user_data)->
+			on_set_browser(iter, old_browser, new_browser);
+	}
+
+	static void on_node_added_static(InfBrowser* browser,
+	                                 InfBrowserIter* iter,
+	                                 InfRequest* request,
+	                                 gpointer user_data)
+	{
+		static_cast<NodeIndex*>(user_data)->
+			on_node_added(browser, iter);
+	}
+
+	static void on_node_removed_static(InfBrowser* browser,
+	                                   InfBrowserIter* iter,
+	                                   InfRequest* request,
+	                                   gpointer user_data)
+	{
+		static_cast<NodeIndex*>(user_data)->
+			on_node_removed(browser, iter);
+	}
+
+	static void on_notify_status_static(GObject* object,
+	                                    GParamSpec* pspec,
+	                                    gpointer user_data)
+	{
+		static_cast<NodeIndex*>(user_data)->
+			on_notify_status(INF_BROWSER(object));
+	}
+
+	void on_set_browser(GtkTreeIter* iter, InfBrowser* old_browser,
+	                    InfBrowser* new_browser);
+	void on_node_added(InfBrowser* browser, InfBrowserIter* iter);
+	void on_node_removed(InfBrowser* browser, InfBrowserIter* iter);
+	void on_notify_status(InfBrowser* browser);
+
+private:
+	struct Entry
+	{
+		InfBrowser* browser;
+		guint node_id;
+		std::string path;
+		// Case-folded path, and a bit for every byte value (modulo
+		// 64) that occurs in it. A path cannot match a query whose
+		// mask has bits that the path's mask does not have.
+		std::string key;
+		guint64 mask;
+		// Offset of the document name in key
+		std::string::size_type name;
+	};
+
+	struct BrowserInfo
+	{
+		std::string name;
+		gulong node_added_handler;
+		gulong node_removed_handler;
+		gulong notify_status_handler;
+	};
+
+	static guint64 make_mask(const std::string& str);
+	static int score(const std::string& query, const std::string& key,
+	                 std::string::size_type name);
+
+	void add_explored(InfBrowser* browser, InfBrowserIter* iter);
+	void add_entry(InfBrowser* browser, const InfBrowserIter* iter);
+	void remove_entry(std::vector<Entry>::size_type index);
+	void remove_browser_entries(InfBrowser* browser);
+
+	InfGtkBrowserModel* m_model;
+	gulong m_set_browser_handler;
+
+	typedef std::map<InfBrowser*, BrowserInfo> BrowserMap;
+	BrowserMap m_browsers;
+
+	// Entries are removed by moving the last one into the gap, so the
+	// position of every entry is tracked in m_positions.
+	typedef std::vector<Entry> EntryList;
+	EntryList m_entries;
+
+	typedef std::pair<InfBrowser*, guint> NodeKey;
+	typedef std::map<NodeKey, EntryList::size_type> PositionMap;
+	PositionMap m_positions;
+};
+
+}
+
+#endif // _GOBBY_NODEINDEX_HPP_
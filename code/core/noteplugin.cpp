@@ -15,6 +15,7 @@
  */
 
 #include "core/noteplugin.hpp"
+#include "core/gobject/gobby-text-buffer.h"
 
 #include <libinftextgtk/inf-text-gtk-buffer.h>
 #include <libinftext/inf-text-session.h>
@@ -32,8 +33,10 @@
 
 namespace
 {
+	typedef InfTextBuffer*(*BufferFunc)(InfUserTable* user_table);
+
 	InfTextBuffer*
-	make_buffer(InfUserTable* user_table)
+	make_gtk_buffer(InfUserTable* user_table)
 	{
 		GtkSourceBuffer* textbuffer = gtk_source_buffer_new(NULL);
 
@@ -45,6 +48,16 @@ namespace
 		return INF_TEXT_BUFFER(buffer);
 	}
 
+	// For sessions of the local directory. Most of them are only
+	// hosted for remote users, so the buffer only creates a GtkTextBuffer
+	// with its B-tree and tag table once the session is shown.
+	InfTextBuffer*
+	make_directory_buffer(InfUserTable* user_table)
+	{
+		return INF_TEXT_BUFFER(gobby_text_buffer_new(user_table));
+	}
+
+	template<BufferFunc make_buffer>
 	InfSession*
 	text_session_new(InfIo* io, InfCommunicationManager* manager,
 	                 InfSessionStatus status,
@@ -70,6 +83,7 @@ namespace
 		return INF_SESSION(session);
 	}
 
+	template<BufferFunc make_buffer>
 	InfSession*
 	text_session_read(InfdStorage* storage,
 	                  InfIo* io,
@@ -179,7 +193,7 @@ namespace
 	{
 		NULL,
 		"InfText",
-		text_session_new
+		text_session_new<make_gtk_buffer>
 	};
 
 	const InfcNotePlugin C_CHAT_PLUGIN =
@@ -194,8 +208,8 @@ namespace
 		NULL,
 		"InfdFilesystemStorage",
 		"InfText",
-		text_session_new,
-		text_session_read,
+		text_session_new<make_directory_buffer>,
+		text_session_read<make_directory_buffer>,
 		text_session_write
 	};
 
@@ -61,7 +61,10 @@ Gobby::Preferences::Editor::Editor(
 	indentation_auto(settings, entry, "auto-indentation"),
 	homeend_smart(settings, entry, "smart-homeend"),
 	autosave_enabled(settings, entry, "autosave-enabled"),
-	autosave_interval(settings, entry, "autosave-interval")
+	autosave_interval(settings, entry, "autosave-interval"),
+	record_sessions(settings, entry, "record-sessions"),
+	record_max_size(settings, entry, "record-max-size"),
+	record_max_files(settings, entry, "record-max-files")
 {
 }
 
@@ -112,7 +115,10 @@ Gobby::Preferences::Network::Network(
 	const Glib::RefPtr<Gio::Settings>& settings,
 	Config::ParentEntry& entry)
 :
-	keepalive(settings, entry, "keepalive")
+	keepalive(settings, entry, "keepalive"),
+	background_sessions(settings, entry, "background-sessions"),
+	background_sessions_size(settings, entry, "background-sessions-size"),
+	batch_window(settings, entry, "batch-window")
 {
 }
 
@@ -614,6 +614,9 @@ public:
 		Option<bool> homeend_smart;
 		Option<bool> autosave_enabled;
 		Option<unsigned int> autosave_interval;
+		Option<bool> record_sessions;
+		Option<unsigned int> record_max_size;
+		Option<unsigned int> record_max_files;
 	};
 
 	class View
@@ -674,6 +677,9 @@ public:
 		        Config::ParentEntry& entry);
 
 		Option<InfKeepalive> keepalive;
+		Option<unsigned int> background_sessions;
+		Option<unsigned int> background_sessions_size;
+		Option<unsigned int> batch_window;
 	};
 
 private:
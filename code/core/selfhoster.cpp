@@ -15,6 +15,7 @@
  */
 
 #include "core/selfhoster.hpp"
+#include "core/noteplugin.hpp"
 #include "util/i18n.hpp"
 
 #include <libinfinity/server/infd-filesystem-storage.h>
@@ -23,21 +24,20 @@ Gobby::SelfHoster::SelfHoster(InfIo* io,
                               InfCommunicationManager* communication_manager,
                               InfLocalPublisher* publisher,
                               InfSaslContext* sasl_context,
-                              StatusBar& status_bar,
                               CertificateManager& cert_manager,
                               const Preferences& preferences):
 	m_sasl_context(sasl_context),
-	m_status_bar(status_bar),
 	m_cert_manager(cert_manager),
 	m_preferences(preferences),
 	m_dh_params_loaded(false),
-	m_info_handle(status_bar.invalid_handle()),
-	m_dh_params_message_handle(status_bar.invalid_handle()),
 	m_directory(infd_directory_new(io, NULL, communication_manager)),
 	m_server(io, publisher)
 {
 	inf_sasl_context_ref(m_sasl_context);
 
+	infd_directory_add_plugin(m_directory, Plugins::D_TEXT);
+	infd_directory_add_plugin(m_directory, Plugins::D_CHAT);
+
 	if(m_preferences.user.keep_local_documents)
 	{
 		const std::string directory =
@@ -91,20 +91,18 @@ bool Gobby::SelfHoster::ensure_dh_params()
 	// generate the parameters but the generation failed.
 	if(m_dh_params_loaded) return true;
 
-	// Load from certificate manager, if available
-	if(m_cert_manager.get_dh_params() != NULL)
+	// Use the parameters from the certificate manager, or the
+	// predefined groups, if available.
+	if(!m_cert_manager.needs_dh_params())
 	{
 		m_dh_params_loaded = true;
 		return true;
 	}
 
 	// Otherwise go and create a new set of parameters
+	set_info(_("Generating 2048-bit Diffie-Hellman parameters..."));
 	if(m_dh_params_handle.get() == NULL)
 	{
-		m_dh_params_message_handle = m_status_bar.add_info_message(
-			_("Generating 2048-bit Diffie-Hellman "
-			  "parameters..."));
-
 		m_dh_params_handle = create_dh_params(
 			2048,
 			sigc::mem_fun(*this, &SelfHoster::on_dh_params_done));
@@ -117,8 +115,7 @@ void Gobby::SelfHoster::on_dh_params_done(const DHParamsGeneratorHandle* hndl,
                                           gnutls_dh_params_t dh_params,
                                           const GError* error)
 {
-	g_assert(m_dh_params_message_handle != m_status_bar.invalid_handle());
-	m_status_bar.remove_message(m_dh_params_message_handle);
+	set_info("");
 
 	// Set this flag also when an error occured, to prevent trying to
 	// re-generate the parameters all the time.
@@ -133,7 +130,7 @@ void Gobby::SelfHoster::on_dh_params_done(const DHParamsGeneratorHandle* hndl,
 	}
 	else
 	{
-		m_status_bar.add_error_message(
+		m_signal_error.emit(
 			_("Failed to generate Diffie-Hellman parameters"),
 			Glib::ustring::compose(
 				_("This means that Perfect Forward Secrecy "
@@ -233,13 +230,6 @@ void Gobby::SelfHoster::apply_preferences()
 		}
 	}
 
-	// Remove old statusbar message, if any
-	if(m_info_handle != m_status_bar.invalid_handle())
-	{
-		m_status_bar.remove_message(m_info_handle);
-		m_info_handle = m_status_bar.invalid_handle();
-	}
-
 	// Close server and all connections if no access is required
 	if(!m_preferences.user.allow_remote_access)
 	{
@@ -248,12 +238,18 @@ void Gobby::SelfHoster::apply_preferences()
 			this);
 		if(m_server.is_open())
 			m_server.close();
+		set_info("");
 		return;
 	}
 
 	// Okay, we want to share our documents, so let's try to start a
 	// server for it.
 
+	// Wait for the certificate manager to load the credentials. It
+	// emits signal_credentials_changed() when done, which brings us
+	// back here.
+	if(!m_cert_manager.is_loaded()) return;
+
 	// Make sure TLS credentials are available.
 	if(m_preferences.security.policy !=
 	   INF_XMPP_CONNECTION_SECURITY_ONLY_UNSECURED &&
@@ -261,7 +257,7 @@ void Gobby::SelfHoster::apply_preferences()
             m_cert_manager.get_private_key() == NULL ||
 	    m_cert_manager.get_certificates() == NULL))
 	{
-		m_info_handle = m_status_bar.add_info_message(
+		set_info(
 			_("In order to start sharing your documents, "
 			  "choose a private key and certificate or "
 			  "create a new pair in the preferences"));
@@ -270,6 +266,7 @@ void Gobby::SelfHoster::apply_preferences()
 
 	// Make sure we have DH parameters
 	if(!ensure_dh_params()) return;
+	set_info("");
 
 	// Okay, go and open a server. If the server is already open the
 	// command below will only change the port and/or security policy.
@@ -284,9 +281,17 @@ void Gobby::SelfHoster::apply_preferences()
 	}
 	catch(const std::exception& ex)
 	{
-		m_status_bar.add_error_message(_("Failed to share documents"),
-		                               ex.what());
+		m_signal_error.emit(_("Failed to share documents"),
+		                    ex.what());
 
 		return;
 	}
 }
+
+void Gobby::SelfHoster::set_info(const Glib::ustring& info)
+{
+	if(info == m_info) return;
+
+	m_info = info;
+	m_signal_info_changed.emit();
+}
@@ -19,7 +19,7 @@
 
 #include "core/credentialsgenerator.hpp"
 #include "core/certificatemanager.hpp"
-#include "core/statusbar.hpp"
+#include "core/preferences.hpp"
 #include "core/server.hpp"
 
 #include <libinfinity/server/infd-directory.h>
@@ -31,18 +31,37 @@
 namespace Gobby
 {
 
+// Hosts the local documents, and shares them with others if configured to
+// do so in the preferences. The self hoster does not show anything itself;
+// the window presents its messages in the status bar, and the dedicated
+// server writes them to the log.
 class SelfHoster: public sigc::trackable
 {
 public:
+	typedef sigc::signal<void> SignalInfoChanged;
+	typedef sigc::signal<void, Glib::ustring, Glib::ustring> SignalError;
+
 	SelfHoster(InfIo* io, InfCommunicationManager* communication_manager,
 	           InfLocalPublisher* publisher,
 	           InfSaslContext* sasl_context,
-	           StatusBar& status_bar,
 	           CertificateManager& cert_manager,
 	           const Preferences& preferences);
 	~SelfHoster();
 
 	InfdDirectory* get_directory() { return m_directory; }
+	const Server& get_server() const { return m_server; }
+
+	// A message explaining what keeps the documents from being shared
+	// right now, or an empty string if there is nothing to say.
+	const Glib::ustring& get_info() const { return m_info; }
+
+	// Nothing is emitted before the certificate manager has finished
+	// loading, so connecting after construction does not miss anything.
+	SignalInfoChanged signal_info_changed() const
+		{ return m_signal_info_changed; }
+	// Emitted with a brief and a detailed description when sharing
+	// the documents failed.
+	SignalError signal_error() const { return m_signal_error; }
 protected:
 	static void directory_foreach_func_close_static(
 		InfXmlConnection* connection,
@@ -61,21 +80,24 @@ protected:
 	void on_require_password_changed();
 	void apply_preferences();
 
+	void set_info(const Glib::ustring& info);
+
 	InfSaslContext* m_sasl_context;
 
-	StatusBar& m_status_bar;
 	CertificateManager& m_cert_manager;
 	const Preferences& m_preferences;
 
 	bool m_dh_params_loaded;
 
-	StatusBar::MessageHandle m_info_handle;
-	StatusBar::MessageHandle m_dh_params_message_handle;
+	Glib::ustring m_info;
 
 	InfdDirectory* m_directory;
 	Server m_server;
 
 	std::unique_ptr<DHParamsGeneratorHandle> m_dh_params_handle;
+
+	SignalInfoChanged m_signal_info_changed;
+	SignalError m_signal_error;
 };
 
 }
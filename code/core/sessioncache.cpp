@@ -0,0 +1,278 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/sessioncache.hpp"
+
+#include <libinftext/inf-text-session.h>
+#include <libinftextgtk/inf-text-gtk-buffer.h>
+#include <libinfinity/adopted/inf-adopted-user.h>
+#include <libinfinity/adopted/inf-adopted-request-log.h>
+
+#include <glibmm/main.h>
+
+namespace
+{
+	// Rough per-item costs used to estimate how much memory a cached
+	// session occupies. The text is stored once in the GtkTextBuffer
+	// and every request in the request logs keeps its operation and
+	// state vector alive.
+	const gsize BYTES_PER_CHAR = 4;
+	const gsize BYTES_PER_REQUEST = 256;
+
+	// How often to check the cache size while there are entries
+	const unsigned int CHECK_INTERVAL = 60;
+
+	void add_request_log_size(InfUser* user, gpointer user_data)
+	{
+		gsize* size = static_cast<gsize*>(user_data);
+
+		InfAdoptedRequestLog* log = inf_adopted_user_get_request_log(
+			INF_ADOPTED_USER(user));
+		*size += BYTES_PER_REQUEST *
+			(inf_adopted_request_log_get_end(log) -
+			 inf_adopted_request_log_get_begin(log));
+	}
+}
+
+Gobby::SessionCache::SessionCache(const Preferences& preferences):
+	m_preferences(preferences), m_size(0)
+{
+	m_preferences.network.background_sessions.signal_changed().connect(
+		sigc::mem_fun(*this, &SessionCache::on_limits_changed));
+	m_preferences.network.background_sessions_size.signal_changed()
+		.connect(sigc::mem_fun(
+			*this, &SessionCache::on_limits_changed));
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+	m_memory_monitor = g_memory_monitor_dup_default();
+	m_low_memory_handle = g_signal_connect(
+		G_OBJECT(m_memory_monitor), "low-memory-warning",
+		G_CALLBACK(on_low_memory_warning_static), this);
+#endif
+}
+
+Gobby::SessionCache::~SessionCache()
+{
+#if GLIB_CHECK_VERSION(2, 64, 0)
+	g_signal_handler_disconnect(m_memory_monitor, m_low_memory_handle);
+	g_object_unref(m_memory_monitor);
+#endif
+
+	// The connections are closed at this point anyway, so there is no
+	// need to unsubscribe explicitly.
+	while(!m_entries.empty())
+		release(m_entries.begin(), false);
+}
+
+bool Gobby::SessionCache::add(InfSessionProxy* proxy, InfUser* user)
+{
+	const unsigned int max_entries =
+		m_preferences.network.background_sessions;
+	if(max_entries == 0) return false;
+
+	// Only client sessions can be kept; hosted sessions stay around
+	// in the directory anyway.
+	if(!INFC_IS_SESSION_PROXY(proxy)) return false;
+	InfcSessionProxy* infc_proxy = INFC_SESSION_PROXY(proxy);
+
+	if(infc_session_proxy_get_subscription_group(infc_proxy) == NULL)
+		return false;
+
+	InfSession* session;
+	g_object_get(G_OBJECT(proxy), "session", &session, NULL);
+
+	if(!INF_TEXT_IS_SESSION(session) ||
+	   inf_session_get_status(session) != INF_SESSION_RUNNING ||
+	   inf_user_get_status(user) == INF_USER_UNAVAILABLE)
+	{
+		g_object_unref(session);
+		return false;
+	}
+
+	g_assert(find(infc_proxy) == m_entries.end());
+
+	// Nobody can type into the document while it is not shown, so
+	// show the user as inactive to the others.
+	inf_text_gtk_buffer_set_active_user(
+		INF_TEXT_GTK_BUFFER(inf_session_get_buffer(session)), NULL);
+	inf_session_set_user_status(session, user, INF_USER_INACTIVE);
+
+	Entry entry;
+	entry.proxy = infc_proxy;
+	entry.user = user;
+	entry.size = estimate_size(session);
+	entry.notify_handle = g_signal_connect(
+		G_OBJECT(infc_proxy), "notify::subscription-group",
+		G_CALLBACK(on_subscription_group_changed_static), this);
+
+	g_object_unref(session);
+
+	g_object_ref(entry.proxy);
+	g_object_ref(entry.user);
+	m_entries.push_front(entry);
+	m_size += entry.size;
+
+	if(!m_check_connection.connected())
+	{
+		m_check_connection = Glib::signal_timeout().connect_seconds(
+			sigc::bind_return(sigc::mem_fun(
+				*this, &SessionCache::on_limits_changed),
+				true),
+			CHECK_INTERVAL);
+	}
+
+	on_limits_changed();
+	return true;
+}
+
+InfUser* Gobby::SessionCache::take(InfSessionProxy* proxy)
+{
+	if(!INFC_IS_SESSION_PROXY(proxy)) return NULL;
+
+	EntryList::iterator iter = find(INFC_SESSION_PROXY(proxy));
+	if(iter == m_entries.end()) return NULL;
+
+	// The session's user table keeps the user alive after the entry
+	// has dropped its reference.
+	InfUser* user = iter->user;
+	if(inf_user_get_status(user) == INF_USER_UNAVAILABLE)
+	{
+		user = NULL;
+	}
+	else
+	{
+		InfSession* session;
+		g_object_get(G_OBJECT(proxy), "session", &session, NULL);
+		inf_session_set_user_status(session, user, INF_USER_ACTIVE);
+		g_object_unref(session);
+	}
+
+	release(iter, false);
+	return user;
+}
+
+void Gobby::SessionCache::on_subscription_group_changed(
+	InfcSessionProxy* proxy)
+{
+	// The session has been closed by the server or the connection
+	// went down, so there is nothing left to keep.
+	if(infc_session_proxy_get_subscription_group(proxy) == NULL)
+	{
+		EntryList::iterator iter = find(proxy);
+		g_assert(iter != m_entries.end());
+		release(iter, false);
+	}
+}
+
+void Gobby::SessionCache::on_limits_changed()
+{
+	const gsize max_size =
+		static_cast<gsize>(
+			m_preferences.network.background_sessions_size) *
+		1024 * 1024;
+
+	evict(m_preferences.network.background_sessions, max_size);
+}
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+void Gobby::SessionCache::on_low_memory_warning(
+	GMemoryMonitorWarningLevel level)
+{
+	// Give back half of the cache at the first warning, and
+	// everything once the system is running out of memory for real.
+	if(level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+		evict(0, 0);
+	else
+	{
+		update_sizes();
+		evict(m_entries.size() / 2, m_size / 2);
+	}
+}
+#endif
+
+gsize Gobby::SessionCache::estimate_size(InfSession* session)
+{
+	gsize size = BYTES_PER_CHAR * inf_text_buffer_get_length(
+		INF_TEXT_BUFFER(inf_session_get_buffer(session)));
+
+	inf_user_table_foreach_user(
+		inf_session_get_user_table(session),
+		add_request_log_size, &size);
+
+	return size;
+}
+
+void Gobby::SessionCache::update_sizes()
+{
+	m_size = 0;
+	for(EntryList::iterator iter = m_entries.begin();
+	    iter != m_entries.end(); ++iter)
+	{
+		InfSession* session;
+		g_object_get(G_OBJECT(iter->proxy), "session", &session, NULL);
+		iter->size = estimate_size(session);
+		g_object_unref(session);
+
+		m_size += iter->size;
+	}
+}
+
+Gobby::SessionCache::EntryList::iterator
+Gobby::SessionCache::find(InfcSessionProxy* proxy)
+{
+	for(EntryList::iterator iter = m_entries.begin();
+	    iter != m_entries.end(); ++iter)
+	{
+		if(iter->proxy == proxy)
+			return iter;
+	}
+
+	return m_entries.end();
+}
+
+void Gobby::SessionCache::release(EntryList::iterator iter, bool unsubscribe)
+{
+	InfcSessionProxy* proxy = iter->proxy;
+	InfUser* user = iter->user;
+
+	g_signal_handler_disconnect(proxy, iter->notify_handle);
+	m_size -= iter->size;
+	m_entries.erase(iter);
+
+	if(m_entries.empty())
+		m_check_connection.disconnect();
+
+	if(unsubscribe)
+		infc_session_proxy_set_connection(proxy, NULL, NULL, 0);
+
+	g_object_unref(user);
+	g_object_unref(proxy);
+}
+
+void Gobby::SessionCache::evict(unsigned int max_entries, gsize max_size)
+{
+	// Other users keep editing the cached sessions, so the sizes
+	// estimated earlier might be outdated by now.
+	update_sizes();
+
+	while(!m_entries.empty() &&
+	      (m_entries.size() > max_entries || m_size > max_size))
+	{
+		EntryList::iterator iter = m_entries.end();
+		--iter;
+		release(iter, true);
+	}
+}
@@ -0,0 +1,121 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_SESSIONCACHE_HPP_
+#define _GOBBY_SESSIONCACHE_HPP_
+
+#include "core/preferences.hpp"
+
+#include <libinfinity/client/infc-session-proxy.h>
+#include <libinfinity/common/inf-session-proxy.h>
+#include <libinfinity/common/inf-user.h>
+
+#include <gio/gio.h>
+#include <sigc++/trackable.h>
+#include <sigc++/connection.h>
+
+#include <list>
+
+namespace Gobby
+{
+
+// Keeps the most recently closed text documents subscribed in the
+// background, so that opening one of them again does not need to
+// synchronize it from the server. The local user stays joined but is set
+// to inactive while the document is not shown. The least recently closed
+// documents are unsubscribed when there are more than the configured
+// number of them, when they are estimated to use more than the configured
+// amount of memory, or when the system reports memory pressure.
+class SessionCache: public sigc::trackable
+{
+public:
+	SessionCache(const Preferences& preferences);
+	~SessionCache();
+
+	// Keeps proxy subscribed after its last view has been closed. Returns
+	// false if the session cannot be kept, in which case the caller
+	// should unsubscribe it itself.
+	bool add(InfSessionProxy* proxy, InfUser* user);
+
+	// Removes proxy from the cache when it is shown again, and returns
+	// the local user that was joined into it, or NULL if the session
+	// was not in the cache or the user has left it in the meanwhile.
+	InfUser* take(InfSessionProxy* proxy);
+
+protected:
+	static void on_subscription_group_changed_static(GObject* object,
+	                                                 GParamSpec* pspec,
+	                                                 gpointer user_data)
+	{
+		static_cast<SessionCache*>(user_data)->
+			on_subscription_group_changed(
+				INFC_SESSION_PROXY(object));
+	}
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+	static void on_low_memory_warning_static(
+		GMemoryMonitor* monitor,
+		GMemoryMonitorWarningLevel level,
+		gpointer user_data)
+	{
+		static_cast<SessionCache*>(user_data)->
+			on_low_memory_warning(level);
+	}
+
+	void on_low_memory_warning(GMemoryMonitorWarningLevel level);
+#endif
+
+	void on_subscription_group_changed(InfcSessionProxy* proxy);
+	void on_limits_changed();
+
+private:
+	struct Entry
+	{
+		InfcSessionProxy* proxy;
+		InfUser* user;
+		gsize size;
+		gulong notify_handle;
+	};
+
+	typedef std::list<Entry> EntryList;
+
+	static gsize estimate_size(InfSession* session);
+	void update_sizes();
+
+	EntryList::iterator find(InfcSessionProxy* proxy);
+	void release(EntryList::iterator iter, bool unsubscribe);
+	void evict(unsigned int max_entries, gsize max_size);
+
+	const Preferences& m_preferences;
+
+	// Most recently closed first
+	EntryList m_entries;
+	gsize m_size;
+
+	// Checks the limits again every now and then while there are
+	// entries, since the cached sessions keep growing with the
+	// changes made by other users.
+	sigc::connection m_check_connection;
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+	GMemoryMonitor* m_memory_monitor;
+	gulong m_low_memory_handle;
+#endif
+};
+
+}
+
+#endif // _GOBBY_SESSIONCACHE_HPP_
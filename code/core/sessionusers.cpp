@@ -0,0 +1,108 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/sessionusers.hpp"
+
+Gobby::SessionUsers::~SessionUsers()
+{
+	for(SessionMap::iterator iter = m_sessions.begin();
+	    iter != m_sessions.end(); ++iter)
+	{
+		if(iter->second.user != NULL)
+			g_object_unref(iter->second.user);
+	}
+}
+
+unsigned int Gobby::SessionUsers::add_view(InfSession* session)
+{
+	return ++m_sessions[session].n_views;
+}
+
+unsigned int Gobby::SessionUsers::remove_view(InfSession* session)
+{
+	SessionMap::iterator iter = m_sessions.find(session);
+	g_assert(iter != m_sessions.end());
+	g_assert(iter->second.n_views > 0);
+
+	const unsigned int n_views = --iter->second.n_views;
+	if(n_views == 0)
+	{
+		if(iter->second.user != NULL)
+			g_object_unref(iter->second.user);
+		m_sessions.erase(iter);
+	}
+
+	return n_views;
+}
+
+InfUser* Gobby::SessionUsers::get_user(InfSession* session) const
+{
+	SessionMap::const_iterator iter = m_sessions.find(session);
+	if(iter == m_sessions.end()) return NULL;
+
+	// The user might have left the session in the meanwhile, for
+	// example after a connection loss.
+	InfUser* user = iter->second.user;
+	if(user != NULL && inf_user_get_status(user) == INF_USER_UNAVAILABLE)
+		return NULL;
+
+	return user;
+}
+
+void Gobby::SessionUsers::set_user(InfSession* session, InfUser* user)
+{
+	SessionMap::iterator iter = m_sessions.find(session);
+	g_assert(iter != m_sessions.end());
+
+	if(user != NULL)
+		g_object_ref(user);
+	if(iter->second.user != NULL)
+		g_object_unref(iter->second.user);
+	iter->second.user = user;
+}
+
+void Gobby::SessionUsers::begin_join(InfSession* session)
+{
+	SessionMap::iterator iter = m_sessions.find(session);
+	g_assert(iter != m_sessions.end());
+	g_assert(!iter->second.joining);
+
+	iter->second.joining = true;
+}
+
+void Gobby::SessionUsers::end_join(InfSession* session, InfUser* user,
+                                   const GError* error)
+{
+	// The session is gone already if the last window showing it has
+	// been closed while joining.
+	SessionMap::iterator iter = m_sessions.find(session);
+	if(iter == m_sessions.end()) return;
+
+	g_assert(iter->second.joining);
+	iter->second.joining = false;
+
+	if(user != NULL)
+		set_user(session, user);
+
+	m_signal_join_finished.emit(session, user, error);
+}
+
+bool Gobby::SessionUsers::is_joining(InfSession* session) const
+{
+	SessionMap::const_iterator iter = m_sessions.find(session);
+	if(iter == m_sessions.end()) return false;
+	return iter->second.joining;
+}
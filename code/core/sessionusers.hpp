@@ -0,0 +1,88 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_SESSIONUSERS_HPP_
+#define _GOBBY_SESSIONUSERS_HPP_
+
+#include <libinfinity/common/inf-session.h>
+#include <libinfinity/common/inf-user.h>
+
+#include <sigc++/signal.h>
+
+#include <map>
+
+namespace Gobby
+{
+
+// Keeps track of the documents that are shown in more than one window. A
+// session is joined only once, by the first window that shows it, and the
+// other windows reuse that user. A window only leaves the session when it
+// is the last one showing it.
+class SessionUsers
+{
+public:
+	// Emitted by end_join(). user is the user that has joined, or NULL
+	// if the join failed, in which case error is set, or if it was
+	// cancelled, in which case error is NULL as well.
+	typedef sigc::signal<void, InfSession*, InfUser*, const GError*>
+		SignalJoinFinished;
+
+	~SessionUsers();
+
+	// Returns the number of windows that show the session, including
+	// the one that has just been added.
+	unsigned int add_view(InfSession* session);
+	// Returns the number of windows that still show the session.
+	unsigned int remove_view(InfSession* session);
+
+	// Returns the local user that has joined the session, or NULL if
+	// none has joined yet.
+	InfUser* get_user(InfSession* session) const;
+	void set_user(InfSession* session, InfUser* user);
+
+	// A window calls begin_join() when it starts to join the session,
+	// and end_join() once the join has finished. In between, other
+	// windows showing the session wait for signal_join_finished()
+	// instead of joining a second user.
+	void begin_join(InfSession* session);
+	void end_join(InfSession* session, InfUser* user,
+	              const GError* error);
+	bool is_joining(InfSession* session) const;
+
+	SignalJoinFinished signal_join_finished() const
+	{
+		return m_signal_join_finished;
+	}
+
+protected:
+	struct Info
+	{
+		Info(): n_views(0), joining(false), user(NULL) {}
+
+		unsigned int n_views;
+		bool joining;
+		InfUser* user;
+	};
+
+	typedef std::map<InfSession*, Info> SessionMap;
+	SessionMap m_sessions;
+
+	SignalJoinFinished m_signal_join_finished;
+};
+
+}
+
+#endif // _GOBBY_SESSIONUSERS_HPP_
@@ -326,50 +326,21 @@ void Gobby::StatusBar::on_document_removed(SessionView& view)
 {
 	if(m_current_view == &view)
 	{
-		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
-			m_current_view->get_text_buffer());
-
-		g_signal_handler_disconnect(buffer, m_mark_set_handler);
-		g_signal_handler_disconnect(buffer, m_changed_handler);
-		g_signal_handler_disconnect(m_current_view->get_text_view(),
-		                            m_toverwrite_handler);
-
+		m_changes_connection.disconnect();
 		m_current_view = NULL;
 	}
 }
 
 void Gobby::StatusBar::on_document_changed(SessionView* view)
 {
-	if(m_current_view)
-	{
-		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
-			m_current_view->get_text_buffer());
-
-		g_signal_handler_disconnect(buffer, m_mark_set_handler);
-		g_signal_handler_disconnect(buffer, m_changed_handler);
-		g_signal_handler_disconnect(m_current_view->get_text_view(),
-		                            m_toverwrite_handler);
-	}
-
+	m_changes_connection.disconnect();
 	m_current_view = dynamic_cast<TextSessionView*>(view);
 
 	if(m_current_view)
 	{
-		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
-			m_current_view->get_text_buffer());
-
-		m_mark_set_handler = g_signal_connect_after(
-			G_OBJECT(buffer), "mark-set",
-			G_CALLBACK(on_mark_set_static), this);
-
-		m_changed_handler = g_signal_connect_after(
-			G_OBJECT(buffer), "changed",
-			G_CALLBACK(on_changed_static), this);
-
-		m_toverwrite_handler = g_signal_connect_after(
-			G_OBJECT(m_current_view->get_text_view()),
-			"notify::overwrite",
-			G_CALLBACK(on_toggled_overwrite_static), this);
+		m_changes_connection = m_current_view->
+			get_change_dispatcher().signal_changed().connect(
+				sigc::mem_fun(*this, &StatusBar::on_changes));
 	}
 
 	// Initial update
@@ -382,23 +353,16 @@ void Gobby::StatusBar::on_view_changed()
 	else hide();
 }
 
-void Gobby::StatusBar::on_mark_set(GtkTextMark* mark)
+void Gobby::StatusBar::on_changes(unsigned int changes,
+                                  const TextChangeDispatcher::AuthorList&)
 {
-	GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
-		m_current_view->get_text_buffer());
-
-	if(mark == gtk_text_buffer_get_insert(buffer))
+	// The selection bound does not affect the position display
+	if(changes & (TextChangeDispatcher::CHANGE_TEXT |
+	              TextChangeDispatcher::CHANGE_CURSOR |
+	              TextChangeDispatcher::CHANGE_OVERWRITE))
+	{
 		update_pos_display();
-}
-
-void Gobby::StatusBar::on_toggled_overwrite()
-{
-	update_pos_display();
-}
-
-void Gobby::StatusBar::on_changed()
-{
-	update_pos_display();
+	}
 }
 
 void Gobby::StatusBar::update_pos_display()
@@ -73,27 +73,6 @@ protected:
 	                          const Glib::ustring& dialog_message,
 	                          unsigned int timeout = 0);
 
-	static void on_mark_set_static(GtkTextBuffer* buffer,
-	                               GtkTextIter* location,
-	                               GtkTextMark* mark,
-	                               gpointer user_data)
-	{
-		static_cast<StatusBar*>(user_data)->on_mark_set(mark);
-	}
-
-	static void on_changed_static(GtkTextBuffer* buffer,
-	                              gpointer user_data)
-	{
-		static_cast<StatusBar*>(user_data)->on_changed();
-	}
-
-	static void on_toggled_overwrite_static(GtkTextView* buffer,
-	                                        GParamSpec* pspec,
-	                                        gpointer user_data)
-	{
-		static_cast<StatusBar*>(user_data)->on_toggled_overwrite();
-	}
-
 	void on_message_clicked(GdkEventButton* button,
 	                        const MessageHandle& handle);
 
@@ -101,9 +80,8 @@ protected:
 	void on_document_changed(SessionView* view);
 	void on_view_changed();
 
-	void on_mark_set(GtkTextMark* mark);
-	void on_toggled_overwrite();
-	void on_changed();
+	void on_changes(unsigned int changes,
+	                const TextChangeDispatcher::AuthorList& authors);
 
 	void update_pos_display();
 
@@ -114,9 +92,7 @@ protected:
 
 	Gtk::Label m_lbl_position;
 	TextSessionView* m_current_view;
-	gulong m_mark_set_handler;
-	gulong m_changed_handler;
-	gulong m_toverwrite_handler;
+	sigc::connection m_changes_connection;
 };
 
 }
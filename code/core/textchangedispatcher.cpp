@@ -0,0 +1,146 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "core/textchangedispatcher.hpp"
+
+#include <glibmm/main.h>
+
+#include <algorithm>
+
+Gobby::TextChangeDispatcher::TextChangeDispatcher(GtkTextView* view,
+                                                  InfTextSession* session,
+                                                  InfTextGtkBuffer* buffer):
+	m_view(view), m_session(INF_SESSION(session)),
+	m_buffer(INF_TEXT_BUFFER(buffer)),
+	m_changes(0), m_tick_id(0)
+{
+	m_text_buffer = inf_text_gtk_buffer_get_text_buffer(buffer);
+
+	g_object_ref(m_view);
+	g_object_ref(m_session);
+	g_object_ref(m_buffer);
+	g_object_ref(m_text_buffer);
+
+	m_changed_handle = g_signal_connect_after(
+		G_OBJECT(m_text_buffer), "changed",
+		G_CALLBACK(on_changed_static), this);
+	m_mark_set_handle = g_signal_connect_after(
+		G_OBJECT(m_text_buffer), "mark-set",
+		G_CALLBACK(on_mark_set_static), this);
+	m_modified_changed_handle = g_signal_connect_after(
+		G_OBJECT(m_text_buffer), "modified-changed",
+		G_CALLBACK(on_modified_changed_static), this);
+	m_overwrite_handle = g_signal_connect_after(
+		G_OBJECT(m_view), "notify::overwrite",
+		G_CALLBACK(on_notify_overwrite_static), this);
+
+	m_text_inserted_handle = g_signal_connect_after(
+		G_OBJECT(m_buffer), "text-inserted",
+		G_CALLBACK(on_text_inserted_static), this);
+	m_text_erased_handle = g_signal_connect_after(
+		G_OBJECT(m_buffer), "text-erased",
+		G_CALLBACK(on_text_erased_static), this);
+}
+
+Gobby::TextChangeDispatcher::~TextChangeDispatcher()
+{
+	g_signal_handler_disconnect(m_text_buffer, m_changed_handle);
+	g_signal_handler_disconnect(m_text_buffer, m_mark_set_handle);
+	g_signal_handler_disconnect(m_text_buffer, m_modified_changed_handle);
+	g_signal_handler_disconnect(m_view, m_overwrite_handle);
+	g_signal_handler_disconnect(m_buffer, m_text_inserted_handle);
+	g_signal_handler_disconnect(m_buffer, m_text_erased_handle);
+
+	if(m_tick_id != 0)
+		gtk_widget_remove_tick_callback(GTK_WIDGET(m_view), m_tick_id);
+	m_idle_connection.disconnect();
+
+	g_object_unref(m_text_buffer);
+	g_object_unref(m_buffer);
+	g_object_unref(m_session);
+	g_object_unref(m_view);
+}
+
+void Gobby::TextChangeDispatcher::flush()
+{
+	if(m_tick_id != 0)
+	{
+		gtk_widget_remove_tick_callback(GTK_WIDGET(m_view), m_tick_id);
+		m_tick_id = 0;
+	}
+
+	m_idle_connection.disconnect();
+
+	if(m_changes == 0) return;
+
+	// Reset before emission, so that changes made by subscribers are
+	// dispatched with the next frame.
+	const unsigned int changes = m_changes;
+	AuthorList authors;
+	authors.swap(m_authors);
+	m_changes = 0;
+
+	m_signal_changed.emit(changes, authors);
+}
+
+void Gobby::TextChangeDispatcher::on_mark_set(GtkTextMark* mark)
+{
+	if(mark == gtk_text_buffer_get_insert(m_text_buffer))
+		add(CHANGE_CURSOR);
+	else if(mark == gtk_text_buffer_get_selection_bound(m_text_buffer))
+		add(CHANGE_SELECTION);
+}
+
+void Gobby::TextChangeDispatcher::on_text_changed(InfUser* user)
+{
+	if(user != NULL &&
+	   inf_session_get_status(m_session) == INF_SESSION_RUNNING)
+	{
+		InfTextUser* author = INF_TEXT_USER(user);
+		if(std::find(m_authors.begin(), m_authors.end(), author) ==
+		   m_authors.end())
+		{
+			m_authors.push_back(author);
+		}
+	}
+
+	add(CHANGE_TEXT);
+}
+
+bool Gobby::TextChangeDispatcher::on_idle()
+{
+	flush();
+	return false;
+}
+
+void Gobby::TextChangeDispatcher::add(unsigned int changes)
+{
+	m_changes |= changes;
+	if(is_pending()) return;
+
+	// Dispatch with the next frame of the view. If the view is not
+	// realized it has no frame clock, so use an idle handler instead.
+	if(gtk_widget_get_realized(GTK_WIDGET(m_view)))
+	{
+		m_tick_id = gtk_widget_add_tick_callback(
+			GTK_WIDGET(m_view), on_tick_static, this, NULL);
+	}
+	else
+	{
+		m_idle_connection = Glib::signal_idle().connect(
+			sigc::mem_fun(*this, &TextChangeDispatcher::on_idle));
+	}
+}
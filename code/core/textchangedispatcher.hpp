@@ -0,0 +1,176 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_TEXTCHANGEDISPATCHER_HPP_
+#define _GOBBY_TEXTCHANGEDISPATCHER_HPP_
+
+#include <libinftextgtk/inf-text-gtk-buffer.h>
+#include <libinftext/inf-text-session.h>
+#include <libinftext/inf-text-buffer.h>
+#include <libinftext/inf-text-chunk.h>
+#include <libinftext/inf-text-user.h>
+
+#include <gtk/gtk.h>
+
+#include <sigc++/signal.h>
+#include <sigc++/connection.h>
+
+#include <vector>
+
+namespace Gobby
+{
+
+// Collects changes to a document's text buffer and view, and notifies
+// subscribers once per frame with the set of things that changed since the
+// last notification. This way a burst of edits, either from typing or from
+// other users, causes only one update of the status bar, action sensitivity
+// and so on, instead of one per edit.
+class TextChangeDispatcher
+{
+public:
+	enum Change {
+		// The buffer contents changed
+		CHANGE_TEXT = 1 << 0,
+		// The insertion cursor moved
+		CHANGE_CURSOR = 1 << 1,
+		// The selection bound moved
+		CHANGE_SELECTION = 1 << 2,
+		// The buffer's modified flag changed
+		CHANGE_MODIFIED = 1 << 3,
+		// The view's overwrite mode was toggled
+		CHANGE_OVERWRITE = 1 << 4
+	};
+
+	typedef std::vector<InfTextUser*> AuthorList;
+
+	// The first argument is a bitmask of Change values, the second
+	// contains the users who inserted or erased text, each at most once.
+	// Text that arrives while the session is synchronizing counts as a
+	// change, but its authors are not reported.
+	typedef sigc::signal<void, unsigned int, const AuthorList&>
+		SignalChanged;
+
+	// buffer holds the text of session. It is not taken from the view
+	// because the view does not always show it.
+	TextChangeDispatcher(GtkTextView* view, InfTextSession* session,
+	                     InfTextGtkBuffer* buffer);
+	~TextChangeDispatcher();
+
+	// Returns whether there are changes that have not yet been
+	// dispatched.
+	bool is_pending() const
+	{
+		return m_tick_id != 0 || m_idle_connection.connected();
+	}
+
+	// Dispatches pending changes right away.
+	void flush();
+
+	SignalChanged signal_changed() const { return m_signal_changed; }
+
+protected:
+	static void on_changed_static(GtkTextBuffer* buffer,
+	                              gpointer user_data)
+	{
+		static_cast<TextChangeDispatcher*>(user_data)->
+			add(CHANGE_TEXT);
+	}
+
+	static void on_mark_set_static(GtkTextBuffer* buffer,
+	                               GtkTextIter* location,
+	                               GtkTextMark* mark,
+	                               gpointer user_data)
+	{
+		static_cast<TextChangeDispatcher*>(user_data)->
+			on_mark_set(mark);
+	}
+
+	static void on_modified_changed_static(GtkTextBuffer* buffer,
+	                                       gpointer user_data)
+	{
+		static_cast<TextChangeDispatcher*>(user_data)->
+			add(CHANGE_MODIFIED);
+	}
+
+	static void on_notify_overwrite_static(GtkTextView* view,
+	                                       GParamSpec* pspec,
+	                                       gpointer user_data)
+	{
+		static_cast<TextChangeDispatcher*>(user_data)->
+			add(CHANGE_OVERWRITE);
+	}
+
+	static void on_text_inserted_static(InfTextBuffer* buffer,
+	                                    guint position,
+	                                    InfTextChunk* chunk,
+	                                    InfUser* user,
+	                                    gpointer user_data)
+	{
+		static_cast<TextChangeDispatcher*>(user_data)->
+			on_text_changed(user);
+	}
+
+	static void on_text_erased_static(InfTextBuffer* buffer,
+	                                  guint position,
+	                                  InfTextChunk* chunk,
+	                                  InfUser* user,
+	                                  gpointer user_data)
+	{
+		static_cast<TextChangeDispatcher*>(user_data)->
+			on_text_changed(user);
+	}
+
+	static gboolean on_tick_static(GtkWidget* widget,
+	                               GdkFrameClock* clock,
+	                               gpointer user_data)
+	{
+		TextChangeDispatcher* dispatcher =
+			static_cast<TextChangeDispatcher*>(user_data);
+		dispatcher->m_tick_id = 0;
+		dispatcher->flush();
+		return G_SOURCE_REMOVE;
+	}
+
+	void on_mark_set(GtkTextMark* mark);
+	void on_text_changed(InfUser* user);
+	bool on_idle();
+
+	void add(unsigned int changes);
+
+	GtkTextView* m_view;
+	InfSession* m_session;
+	GtkTextBuffer* m_text_buffer;
+	InfTextBuffer* m_buffer;
+
+	unsigned int m_changes;
+	AuthorList m_authors;
+
+	guint m_tick_id;
+	sigc::connection m_idle_connection;
+
+	gulong m_changed_handle;
+	gulong m_mark_set_handle;
+	gulong m_modified_changed_handle;
+	gulong m_overwrite_handle;
+	gulong m_text_inserted_handle;
+	gulong m_text_erased_handle;
+
+	SignalChanged m_signal_changed;
+};
+
+}
+
+#endif // _GOBBY_TEXTCHANGEDISPATCHER_HPP_
@@ -15,6 +15,9 @@
  */
 
 #include "core/textsessionuserview.hpp"
+#include "util/i18n.hpp"
+
+#include <glibmm/markup.h>
 
 Gobby::TextSessionUserView::
 	TextSessionUserView(TextSessionView& view,
@@ -26,6 +29,9 @@ Gobby::TextSessionUserView::
 	m_userlist.signal_user_activated().connect(
 		sigc::mem_fun(
 			*this, &TextSessionUserView::on_user_activated));
+	m_userlist.set_user_tooltip_func(
+		sigc::mem_fun(
+			*this, &TextSessionUserView::get_user_tooltip));
 }
 
 void Gobby::TextSessionUserView::on_user_activated(InfUser* user)
@@ -51,3 +57,18 @@ void Gobby::TextSessionUserView::on_user_activated(InfUser* user)
 		GTK_TEXT_VIEW(view), mark, 0.0, TRUE, 0.5, 0.5);
 	gtk_text_buffer_delete_mark(GTK_TEXT_BUFFER(buffer), mark);
 }
+
+Glib::ustring Gobby::TextSessionUserView::get_user_tooltip(InfUser* user)
+{
+	const AuthorshipIndex& authorship =
+		get_session_view().get_authorship();
+	const unsigned int chars =
+		authorship.get_char_count(inf_user_get_id(user));
+
+	return Glib::ustring::compose(
+		ngettext("<b>%1</b> wrote %2 character of this document",
+		         "<b>%1</b> wrote %2 characters of this document",
+		         chars),
+		Glib::Markup::escape_text(inf_user_get_name(user)),
+		chars);
+}
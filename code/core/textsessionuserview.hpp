@@ -48,6 +48,7 @@ public:
 
 protected:
 	void on_user_activated(InfUser* user);
+	Glib::ustring get_user_tooltip(InfUser* user);
 };
 
 }
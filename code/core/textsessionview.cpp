@@ -15,6 +15,7 @@
  */
 
 #include "core/gobject/gobby-undo-manager.h"
+#include "core/gobject/gobby-text-buffer.h"
 #include "core/textsessionview.hpp"
 #include "util/i18n.hpp"
 
@@ -91,11 +92,8 @@ namespace
 
 	bool tags_priority_idle_func(Gobby::TextSessionView& view)
 	{
-		InfTextGtkBuffer* buffer = INF_TEXT_GTK_BUFFER(
-			inf_session_get_buffer(
-				INF_SESSION(view.get_session())));
-
-		inf_text_gtk_buffer_ensure_author_tags_priority(buffer);
+		inf_text_gtk_buffer_ensure_author_tags_priority(
+			view.get_inf_buffer());
 
 		// I don't know why it does not redraw automatically, perhaps
 		// this is a bug.
@@ -127,19 +125,42 @@ Gobby::TextSessionView::TextSessionView(InfTextSession* session,
                                         GtkSourceLanguageManager* manager):
 	SessionView(INF_SESSION(session), title, path, hostname),
 	m_info_storage_key(info_storage_key), m_preferences(preferences),
-	m_view(GTK_SOURCE_VIEW(gtk_source_view_new()))
+	m_view(GTK_SOURCE_VIEW(gtk_source_view_new())),
+	m_buffer_attached(true), m_highlight_syntax(true),
+	m_scroll_pending(false), m_scroll_margin(0.0),
+	m_authorship(INF_TEXT_BUFFER(
+		inf_session_get_buffer(INF_SESSION(session))))
 {
 	InfBuffer* buffer = inf_session_get_buffer(INF_SESSION(session));
 	InfUserTable* user_table =
 		inf_session_get_user_table(INF_SESSION(session));
-	m_buffer = GTK_SOURCE_BUFFER(inf_text_gtk_buffer_get_text_buffer(
-		INF_TEXT_GTK_BUFFER(buffer)));
+
+	// Sessions of the local directory only have a GtkTextBuffer while
+	// they are shown.
+	if(GOBBY_IS_TEXT_BUFFER(buffer))
+	{
+		m_infbuffer = gobby_text_buffer_acquire_gtk_buffer(
+			GOBBY_TEXT_BUFFER(buffer));
+	}
+	else
+	{
+		m_infbuffer = INF_TEXT_GTK_BUFFER(buffer);
+	}
+
+	m_buffer = GTK_SOURCE_BUFFER(
+		inf_text_gtk_buffer_get_text_buffer(m_infbuffer));
 
 	m_infview = inf_text_gtk_view_new(
 		inf_adopted_session_get_io(INF_ADOPTED_SESSION(session)),
 		GTK_TEXT_VIEW(m_view),
 		user_table);
 
+	m_change_dispatcher.reset(
+		new TextChangeDispatcher(GTK_TEXT_VIEW(m_view), session,
+		                         m_infbuffer));
+	m_change_dispatcher->signal_changed().connect(
+		sigc::mem_fun(*this, &TextSessionView::on_changes));
+
 	g_signal_connect_after(
 		G_OBJECT(m_view),
 		"style-updated",
@@ -244,8 +265,7 @@ Gobby::TextSessionView::TextSessionView(InfTextSession* session,
 		m_infview,
 		m_preferences.user.show_remote_current_lines
 	);
-	inf_text_gtk_buffer_set_fade(
-		INF_TEXT_GTK_BUFFER(buffer), m_preferences.user.alpha);
+	inf_text_gtk_buffer_set_fade(m_infbuffer, m_preferences.user.alpha);
 
 	gtk_source_view_set_tab_width(m_view, m_preferences.editor.tab_width);
 	gtk_source_view_set_insert_spaces_instead_of_tabs(
@@ -297,6 +317,13 @@ Gobby::TextSessionView::~TextSessionView()
 {
 	g_object_unref(m_infview);
 	g_object_unref(m_infviewport);
+
+	InfBuffer* buffer = inf_session_get_buffer(m_session);
+	if(GOBBY_IS_TEXT_BUFFER(buffer))
+	{
+		gobby_text_buffer_release_gtk_buffer(
+			GOBBY_TEXT_BUFFER(buffer));
+	}
 }
 
 void Gobby::TextSessionView::get_cursor_position(unsigned int& row,
@@ -336,8 +363,7 @@ void Gobby::TextSessionView::get_cursor_position(unsigned int& row,
 void Gobby::TextSessionView::set_selection(const GtkTextIter* begin,
                                            const GtkTextIter* end)
 {
-	gtk_text_buffer_select_range(
-		gtk_text_view_get_buffer(GTK_TEXT_VIEW(m_view)), begin, end);
+	gtk_text_buffer_select_range(GTK_TEXT_BUFFER(m_buffer), begin, end);
 
 	scroll_to_cursor_position(0.1);
 }
@@ -346,27 +372,73 @@ Glib::ustring Gobby::TextSessionView::get_selected_text() const
 {
 	GtkTextIter start, end;
 	gtk_text_buffer_get_selection_bounds(
-		gtk_text_view_get_buffer(GTK_TEXT_VIEW(m_view)),
-		&start, &end);
+		GTK_TEXT_BUFFER(m_buffer), &start, &end);
 
 	Gtk::TextIter start_cpp(&start), end_cpp(&end);
 	return start_cpp.get_slice(end_cpp);
 }
 
+void Gobby::TextSessionView::set_buffer_attached(bool attached)
+{
+	if(attached == m_buffer_attached) return;
+	m_buffer_attached = attached;
+
+	if(attached)
+	{
+		gtk_source_buffer_set_highlight_syntax(
+			m_buffer, m_highlight_syntax);
+		gtk_text_view_set_buffer(GTK_TEXT_VIEW(m_view),
+		                         GTK_TEXT_BUFFER(m_buffer));
+
+		if(m_scroll_pending)
+		{
+			m_scroll_pending = false;
+			scroll_to_cursor_position(m_scroll_margin);
+		}
+	}
+	else
+	{
+		// The view makes itself a new, empty buffer
+		gtk_text_view_set_buffer(GTK_TEXT_VIEW(m_view), NULL);
+
+		m_highlight_syntax =
+			gtk_source_buffer_get_highlight_syntax(m_buffer);
+		gtk_source_buffer_set_highlight_syntax(m_buffer, FALSE);
+	}
+}
+
 void Gobby::TextSessionView::scroll_to_cursor_position(double within_margin)
 {
+	// The view can only scroll to marks of the buffer it shows
+	if(!m_buffer_attached)
+	{
+		m_scroll_pending = true;
+		m_scroll_margin = within_margin;
+		return;
+	}
+
 	gtk_text_view_scroll_to_mark(
 		GTK_TEXT_VIEW(m_view),
-		gtk_text_buffer_get_insert(gtk_text_view_get_buffer(
-			GTK_TEXT_VIEW(m_view))),
+		gtk_text_buffer_get_insert(GTK_TEXT_BUFFER(m_buffer)),
 		within_margin, FALSE, 0.0, 0.0);
 }
 
+InfTextUser*
+Gobby::TextSessionView::get_author(unsigned int author_id) const
+{
+	if(author_id == 0) return NULL;
+
+	InfUser* user = inf_user_table_lookup_user_by_id(
+		inf_session_get_user_table(INF_SESSION(m_session)),
+		author_id);
+	if(user == NULL) return NULL;
+
+	return INF_TEXT_USER(user);
+}
+
 InfUser* Gobby::TextSessionView::get_active_user() const
 {
-	InfTextGtkBuffer* buffer = INF_TEXT_GTK_BUFFER(
-		inf_session_get_buffer(INF_SESSION(m_session)));
-	return INF_USER(inf_text_gtk_buffer_get_active_user(buffer));
+	return INF_USER(inf_text_gtk_buffer_get_active_user(m_infbuffer));
 }
 
 void Gobby::TextSessionView::set_active_user(InfTextUser* user)
@@ -378,10 +450,7 @@ void Gobby::TextSessionView::set_active_user(InfTextUser* user)
 			inf_user_get_id(INF_USER(user)))
 		== INF_USER(user));
 
-	inf_text_gtk_buffer_set_active_user(
-		INF_TEXT_GTK_BUFFER(
-			inf_session_get_buffer(INF_SESSION(m_session))),
-		user);
+	inf_text_gtk_buffer_set_active_user(m_infbuffer, user);
 	inf_text_gtk_view_set_active_user(m_infview, user);
 	inf_text_gtk_viewport_set_active_user(m_infviewport, user);
 
@@ -443,11 +512,7 @@ void Gobby::TextSessionView::on_user_color_changed()
 
 void Gobby::TextSessionView::on_alpha_changed()
 {
-	InfTextGtkBuffer* buffer = INF_TEXT_GTK_BUFFER(
-		inf_session_get_buffer(INF_SESSION(m_session)));
-
-	inf_text_gtk_buffer_set_fade(
-		buffer, m_preferences.user.alpha);
+	inf_text_gtk_buffer_set_fade(m_infbuffer, m_preferences.user.alpha);
 }
 
 void Gobby::TextSessionView::on_show_remote_cursors_changed()
@@ -629,10 +694,8 @@ bool Gobby::TextSessionView::
 		return false;
 	}
 
-	InfTextGtkBuffer* buffer = INF_TEXT_GTK_BUFFER(
-		inf_session_get_buffer(INF_SESSION(m_session)));
-
-	InfTextUser* author = inf_text_gtk_buffer_get_author(buffer, &iter);
+	InfTextUser* author = get_author(
+		m_authorship.get_author_at(gtk_text_iter_get_offset(&iter)));
 	if(author != NULL)
 	{
 		tooltip->set_markup(Glib::ustring::compose(
@@ -671,8 +734,24 @@ void Gobby::TextSessionView::on_view_style_updated()
 	s = s * 0.5 + 0.3;
 	v = (std::pow(v + 1, 3) - 1) / 7 * 0.6 + 0.4;
 
-	InfTextGtkBuffer* buffer = INF_TEXT_GTK_BUFFER(
-		inf_session_get_buffer(INF_SESSION(m_session)));
+	inf_text_gtk_buffer_set_saturation_value(m_infbuffer, s, v);
+}
+
+void Gobby::TextSessionView::on_changes(
+	unsigned int changes,
+	const TextChangeDispatcher::AuthorList& authors)
+{
+	TextChangeDispatcher::AuthorList remote_authors;
+	InfUser* active_user = get_active_user();
+
+	for(TextChangeDispatcher::AuthorList::const_iterator iter =
+		authors.begin();
+	    iter != authors.end(); ++iter)
+	{
+		if(INF_USER(*iter) != active_user)
+			remote_authors.push_back(*iter);
+	}
 
-	inf_text_gtk_buffer_set_saturation_value(buffer, s, v);
+	if(!remote_authors.empty())
+		m_signal_remote_edits_flushed.emit(remote_authors);
 }
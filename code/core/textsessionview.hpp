@@ -19,6 +19,8 @@
 
 #include "core/sessionview.hpp"
 #include "core/textundogrouping.hpp"
+#include "core/authorshipindex.hpp"
+#include "core/textchangedispatcher.hpp"
 #include "core/preferences.hpp"
 
 #include <gtkmm/tooltip.h>
@@ -26,6 +28,7 @@
 
 #include <gtksourceview/gtksource.h>
 
+#include <libinftextgtk/inf-text-gtk-buffer.h>
 #include <libinftextgtk/inf-text-gtk-view.h>
 #include <libinftextgtk/inf-text-gtk-viewport.h>
 #include <libinftext/inf-text-session.h>
@@ -38,6 +41,8 @@ class TextSessionView: public SessionView
 {
 public:
 	typedef sigc::signal<void, GtkSourceLanguage*> SignalLanguageChanged;
+	typedef sigc::signal<void, const TextChangeDispatcher::AuthorList&>
+		SignalRemoteEditsFlushed;
 
 	TextSessionView(InfTextSession* session, const Glib::ustring& title,
 	                const Glib::ustring& path,
@@ -60,6 +65,12 @@ public:
 	Glib::ustring get_selected_text() const;
 	void scroll_to_cursor_position(double within_margin);
 
+	// While detached, the view shows an empty buffer, and the text
+	// buffer is not highlighted, so that large amounts of text can be
+	// inserted without relayouting the view every time. Scrolling to the
+	// cursor position is done once the buffer is attached again.
+	void set_buffer_attached(bool attached);
+
 	GtkSourceLanguage* get_language() const;
 	void set_language(GtkSourceLanguage* language);
 
@@ -73,12 +84,34 @@ public:
 
 	GtkSourceView* get_text_view() { return m_view; }
 	GtkSourceBuffer* get_text_buffer() { return m_buffer; }
+	InfTextGtkBuffer* get_inf_buffer() { return m_infbuffer; }
+
+	const AuthorshipIndex& get_authorship() const { return m_authorship; }
+
+	// Notifies once per frame about changes to the buffer, the cursor
+	// and the selection. UI that reflects the document state should
+	// use this rather than connecting to the buffer's signals.
+	TextChangeDispatcher& get_change_dispatcher()
+	{
+		return *m_change_dispatcher;
+	}
+
+	// Returns the user with the given ID, or NULL for unowned text
+	InfTextUser* get_author(unsigned int author_id) const;
 
 	SignalLanguageChanged signal_language_changed() const
 	{
 		return m_signal_language_changed;
 	}
 
+	// Edits by other users are batched by the change dispatcher. Once
+	// per frame in which there were some, this is emitted with the
+	// users who made them.
+	SignalRemoteEditsFlushed signal_remote_edits_flushed() const
+	{
+		return m_signal_remote_edits_flushed;
+	}
+
 protected:
 	void on_user_color_changed();
 	void on_alpha_changed();
@@ -106,6 +139,9 @@ protected:
 
 	void on_view_style_updated();
 
+	void on_changes(unsigned int changes,
+	                const TextChangeDispatcher::AuthorList& authors);
+
 	bool on_query_tooltip(int x, int y, bool keyboard_mode,
 	                      const Glib::RefPtr<Gtk::Tooltip>& tooltip);
 
@@ -131,12 +167,20 @@ protected:
 	Glib::RefPtr<Gtk::CssProvider> m_font_provider;
 
 	GtkSourceView* m_view;
+	bool m_buffer_attached;
+	bool m_highlight_syntax;
+	bool m_scroll_pending;
+	double m_scroll_margin;
+	InfTextGtkBuffer* m_infbuffer;
 	GtkSourceBuffer* m_buffer;
+	AuthorshipIndex m_authorship;
 	std::unique_ptr<TextUndoGrouping> m_undo_grouping;
 	InfTextGtkView* m_infview;
 	InfTextGtkViewport* m_infviewport;
+	std::unique_ptr<TextChangeDispatcher> m_change_dispatcher;
 
 	SignalLanguageChanged m_signal_language_changed;
+	SignalRemoteEditsFlushed m_signal_remote_edits_flushed;
 };
 
 }
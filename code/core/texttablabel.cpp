@@ -64,20 +64,12 @@ void Gobby::TextTabLabel::UserWatcher::on_notify_hue(GObject* user_object,
 Gobby::TextTabLabel::TextTabLabel(Folder& folder, TextSessionView& view):
 	TabLabel(folder, view, "text-x-generic"), m_dot_char(0)
 {
-	m_modified_changed_handle = g_signal_connect_after(
-		G_OBJECT(view.get_text_buffer()), "modified-changed",
-		G_CALLBACK(on_modified_changed_static), this);
-
-	InfTextBuffer* buffer = 
-		INF_TEXT_BUFFER(
-			inf_session_get_buffer(
-				INF_SESSION(view.get_session())));
-	m_insert_text_handle = g_signal_connect_after(
-		G_OBJECT(buffer), "text-inserted",
-		G_CALLBACK(on_text_inserted_static), this);
-	m_erase_text_handle = g_signal_connect_after(
-		G_OBJECT(buffer), "text-erased",
-		G_CALLBACK(on_text_erased_static), this);
+	m_changes_connection =
+		view.get_change_dispatcher().signal_changed().connect(
+			sigc::mem_fun(*this, &TextTabLabel::on_changes));
+	m_remote_edits_connection =
+		view.signal_remote_edits_flushed().connect(
+			sigc::mem_fun(*this, &TextTabLabel::on_remote_edits));
 
 	insert_next_to(m_title, Gtk::POS_RIGHT);
 	attach_next_to(m_dots, m_title, Gtk::POS_RIGHT, 1, 1);
@@ -88,17 +80,8 @@ Gobby::TextTabLabel::TextTabLabel(Folder& folder, TextSessionView& view):
 
 Gobby::TextTabLabel::~TextTabLabel()
 {
-	TextSessionView& text_view = dynamic_cast<TextSessionView&>(m_view);
-
-	g_signal_handler_disconnect(text_view.get_text_buffer(),
-	                            m_modified_changed_handle);
-	InfTextBuffer* buffer = 
-		INF_TEXT_BUFFER(
-			inf_session_get_buffer(
-				INF_SESSION(m_view.get_session())));
-
-	g_signal_handler_disconnect(buffer, m_erase_text_handle);
-	g_signal_handler_disconnect(buffer, m_insert_text_handle);
+	m_changes_connection.disconnect();
+	m_remote_edits_connection.disconnect();
 }
 
 void Gobby::TextTabLabel::on_style_updated()
@@ -121,9 +104,23 @@ void Gobby::TextTabLabel::on_activate()
 	update_dots();
 }
 
-void Gobby::TextTabLabel::on_modified_changed()
+void Gobby::TextTabLabel::on_changes(
+	unsigned int changes,
+	const TextChangeDispatcher::AuthorList& authors)
 {
-	update_modified();
+	if(changes & TextChangeDispatcher::CHANGE_MODIFIED)
+		update_modified();
+}
+
+void Gobby::TextTabLabel::on_remote_edits(
+	const TextChangeDispatcher::AuthorList& authors)
+{
+	for(TextChangeDispatcher::AuthorList::const_iterator iter =
+		authors.begin();
+	    iter != authors.end(); ++iter)
+	{
+		on_changed(*iter);
+	}
 }
 
 void Gobby::TextTabLabel::on_changed(InfTextUser* author)
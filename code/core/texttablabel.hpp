@@ -30,36 +30,14 @@ public:
 	~TextTabLabel();
 
 protected:
-	static void on_modified_changed_static(GtkTextBuffer* buffer,
-	                                       gpointer user_data)
-	{
-		static_cast<TextTabLabel*>(user_data)->on_modified_changed();
-	}
-
-	static void on_text_erased_static(InfTextBuffer* buffer,
-	                                  guint position,
-	                                  InfTextChunk* chunk,
-	                                  InfTextUser* author,
-	                                  gpointer user_data)
-	{
-		static_cast<TextTabLabel*>(user_data)->on_changed(author);
-	}
-
-	static void on_text_inserted_static(InfTextBuffer* buffer,
-	                                    guint position,
-	                                    InfTextChunk* text,
-	                                    InfTextUser* author,
-	                                    gpointer user_data)
-	{
-		static_cast<TextTabLabel*>(user_data)->on_changed(author);
-	}
-
 	virtual void on_style_updated();
 
 	virtual void on_notify_status(); // override
 	virtual void on_activate();
 
-	void on_modified_changed();
+	void on_changes(unsigned int changes,
+	                const TextChangeDispatcher::AuthorList& authors);
+	void on_remote_edits(const TextChangeDispatcher::AuthorList& authors);
 	void on_changed(InfTextUser* author);
 
 	Gtk::Label m_dots;
@@ -71,9 +49,8 @@ private:
 
 	gunichar m_dot_char;
 
-	gulong m_modified_changed_handle;
-	gulong m_erase_text_handle;
-	gulong m_insert_text_handle;
+	sigc::connection m_changes_connection;
+	sigc::connection m_remote_edits_connection;
 
 	class UserWatcher
 	{
@@ -188,6 +188,18 @@ void Gobby::UserList::set_show_disconnected(bool show_disconnected)
 	}
 }
 
+void Gobby::UserList::set_user_tooltip_func(const SlotUserTooltip& slot)
+{
+	m_user_tooltip_func = slot;
+
+	if(!m_view.get_has_tooltip())
+	{
+		m_view.set_has_tooltip(true);
+		m_view.signal_query_tooltip().connect(
+			sigc::mem_fun(*this, &UserList::on_query_tooltip));
+	}
+}
+
 bool Gobby::UserList::visible_func(const Gtk::TreeIter& iter)
 {
 	InfUser* user = (*iter)[m_columns.user];
@@ -379,6 +391,27 @@ void Gobby::UserList::on_row_activated(const Gtk::TreePath& path,
 		m_signal_user_activated.emit(user);
 }
 
+bool Gobby::UserList::on_query_tooltip(int x, int y, bool keyboard_mode,
+                                       const Glib::RefPtr<Gtk::Tooltip>& tip)
+{
+	if(!m_user_tooltip_func) return false;
+
+	Gtk::TreeModel::iterator iter;
+	if(!m_view.get_tooltip_context_iter(x, y, keyboard_mode, iter))
+		return false;
+
+	// The columns are the same in the filter model and the store
+	InfUser* user = (*iter)[m_columns.user];
+	if(user == NULL) return false;
+
+	const Glib::ustring markup = m_user_tooltip_func(user);
+	if(markup.empty()) return false;
+
+	tip->set_markup(markup);
+	m_view.set_tooltip_row(tip, m_view.get_model()->get_path(iter));
+	return true;
+}
+
 void Gobby::UserList::on_style_updated()
 {
 	// Re-render all user color pixbufs, since the icon might have changed
@@ -31,12 +31,17 @@ namespace Gobby
 	{
 	public:
 		typedef sigc::signal<void, InfUser*> SignalUserActivated;
+		typedef sigc::slot<Glib::ustring, InfUser*> SlotUserTooltip;
 
 		UserList(InfUserTable* table);
 		~UserList();
 
 		void set_show_disconnected(bool show_disconnected);
 
+		// The slot returns the tooltip markup to show for a user,
+		// or an empty string to show no tooltip.
+		void set_user_tooltip_func(const SlotUserTooltip& slot);
+
 		SignalUserActivated signal_user_activated() const
 		{
 			return m_signal_user_activated;
@@ -103,6 +108,8 @@ namespace Gobby
 		//void on_select_func(const Gtk::TreeIter& iter);
 		void on_row_activated(const Gtk::TreePath& path,
 		                      Gtk::TreeViewColumn* column);
+		bool on_query_tooltip(int x, int y, bool keyboard_mode,
+		                      const Glib::RefPtr<Gtk::Tooltip>& tooltip);
 
 		virtual void on_style_updated();
 
@@ -115,6 +122,7 @@ namespace Gobby
 
 		gulong m_add_user_handle;
 
+		SlotUserTooltip m_user_tooltip_func;
 		SignalUserActivated m_signal_user_activated;
 	};
 }
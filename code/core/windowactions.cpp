@@ -21,10 +21,12 @@ Gobby::WindowActions::WindowActions(Gio::ActionMap& map,
 	new_document(map.add_action("new")),
 	open(map.add_action("open")),
 	open_location(map.add_action("open-location")),
+	quick_open(map.add_action("quick-open")),
 	save(map.add_action("save")),
 	save_as(map.add_action("save-as")),
 	save_all(map.add_action("save-all")),
 	export_html(map.add_action("export-html")),
+	record_session(map.add_action_bool("record-session", false)),
 	connect(map.add_action("connect")),
 	close(map.add_action("close")),
 
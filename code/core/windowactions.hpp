@@ -32,10 +32,12 @@ public:
 	const Glib::RefPtr<Gio::SimpleAction> new_document;
 	const Glib::RefPtr<Gio::SimpleAction> open;
 	const Glib::RefPtr<Gio::SimpleAction> open_location;
+	const Glib::RefPtr<Gio::SimpleAction> quick_open;
 	const Glib::RefPtr<Gio::SimpleAction> save;
 	const Glib::RefPtr<Gio::SimpleAction> save_as;
 	const Glib::RefPtr<Gio::SimpleAction> save_all;
 	const Glib::RefPtr<Gio::SimpleAction> export_html;
+	const Glib::RefPtr<Gio::SimpleAction> record_session;
 	const Glib::RefPtr<Gio::SimpleAction> connect;
 	const Glib::RefPtr<Gio::SimpleAction> close;
 
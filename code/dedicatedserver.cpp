@@ -0,0 +1,188 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "dedicatedserver.hpp"
+
+#include "util/file.hpp"
+#include "util/i18n.hpp"
+#include "util/password.hpp"
+
+#include <libinfinity/common/inf-error.h>
+
+#ifndef G_OS_WIN32
+# include <glib-unix.h>
+# include <signal.h>
+#endif
+
+#include <stdexcept>
+
+Gobby::DedicatedServer::DedicatedServer():
+	m_config(config_filename("config.xml")),
+	m_preferences(m_config),
+	m_cert_manager(m_preferences),
+	m_connection_manager(m_cert_manager, m_preferences),
+	m_sasl_context(NULL),
+	m_main_loop(Glib::MainLoop::create())
+{
+	GError* error = NULL;
+	m_sasl_context = inf_sasl_context_new(&error);
+
+	if(!m_sasl_context)
+	{
+		std::string error_message =
+			std::string("SASL initialization error: ") +
+			error->message;
+		g_error_free(error);
+		throw std::runtime_error(error_message);
+	}
+
+	inf_sasl_context_set_callback(
+		m_sasl_context, &DedicatedServer::sasl_callback_static,
+		this, NULL);
+
+	m_self_hoster.reset(new SelfHoster(
+		m_connection_manager.get_io(),
+		m_connection_manager.get_communication_manager(),
+		m_connection_manager.get_publisher(),
+		m_sasl_context, m_cert_manager, m_preferences));
+
+	m_self_hoster->signal_info_changed().connect(
+		sigc::mem_fun(*this, &DedicatedServer::on_info_changed));
+	m_self_hoster->signal_error().connect(
+		sigc::mem_fun(*this, &DedicatedServer::on_error));
+}
+
+Gobby::DedicatedServer::~DedicatedServer()
+{
+	// Saves and closes the hosted sessions
+	m_self_hoster.reset(NULL);
+	inf_sasl_context_unref(m_sasl_context);
+}
+
+void Gobby::DedicatedServer::run()
+{
+	if(!m_preferences.user.allow_remote_access)
+	{
+		g_warning("%s", _("Remote access is disabled in the "
+		                  "preferences, so no documents are shared "
+		                  "until it is enabled"));
+	}
+
+	if(m_preferences.user.keep_local_documents)
+	{
+		const std::string directory =
+			m_preferences.user.host_directory;
+		g_message(_("Hosting documents in \"%s\""),
+		          directory.c_str());
+	}
+	else
+	{
+		g_warning("%s", _("Documents are not stored on disk, since "
+		                  "keeping local documents is disabled in "
+		                  "the preferences"));
+	}
+
+#ifndef G_OS_WIN32
+	const guint int_source = g_unix_signal_add(
+		SIGINT, on_quit_signal_static, this);
+	const guint term_source = g_unix_signal_add(
+		SIGTERM, on_quit_signal_static, this);
+#endif
+
+	m_main_loop->run();
+
+#ifndef G_OS_WIN32
+	g_source_remove(int_source);
+	g_source_remove(term_source);
+#endif
+}
+
+void Gobby::DedicatedServer::sasl_callback(InfSaslContextSession* session,
+                                           InfXmppConnection* xmpp,
+                                           Gsasl_property prop)
+{
+	const std::string correct_password = m_preferences.user.password;
+	const char* password;
+
+	// We only ever act as the server side of the authentication
+	switch(prop)
+	{
+	case GSASL_VALIDATE_ANONYMOUS:
+		if(m_preferences.user.require_password)
+		{
+			inf_sasl_context_session_continue(
+				session,
+				GSASL_AUTHENTICATION_ERROR
+			);
+
+			set_sasl_error(xmpp, _("Password required"));
+		}
+		else
+		{
+			inf_sasl_context_session_continue(session, GSASL_OK);
+		}
+
+		break;
+	case GSASL_VALIDATE_SIMPLE:
+		password = inf_sasl_context_session_get_property(
+			session, GSASL_PASSWORD);
+
+		if(!check_password(correct_password, password))
+		{
+			inf_sasl_context_session_continue(
+				session,
+				GSASL_AUTHENTICATION_ERROR
+			);
+
+			set_sasl_error(xmpp, _("Incorrect password"));
+		}
+		else
+		{
+			inf_sasl_context_session_continue(session, GSASL_OK);
+		}
+
+		break;
+	default:
+		inf_sasl_context_session_continue(session, GSASL_NO_CALLBACK);
+		break;
+	}
+}
+
+void Gobby::DedicatedServer::set_sasl_error(InfXmppConnection* connection,
+                                            const gchar* message)
+{
+	GError* error = g_error_new_literal(
+		inf_authentication_detail_error_quark(),
+		INF_AUTHENTICATION_DETAIL_ERROR_AUTHENTICATION_FAILED,
+		message
+	);
+
+	inf_xmpp_connection_set_sasl_error(connection, error);
+	g_error_free(error);
+}
+
+void Gobby::DedicatedServer::on_info_changed()
+{
+	const Glib::ustring& info = m_self_hoster->get_info();
+	if(!info.empty())
+		g_message("%s", info.c_str());
+}
+
+void Gobby::DedicatedServer::on_error(const Glib::ustring& brief_desc,
+                                      const Glib::ustring& detailed_desc)
+{
+	g_warning("%s: %s", brief_desc.c_str(), detailed_desc.c_str());
+}
@@ -0,0 +1,90 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_DEDICATEDSERVER_HPP_
+#define _GOBBY_DEDICATEDSERVER_HPP_
+
+#include "core/selfhoster.hpp"
+#include "core/connectionmanager.hpp"
+#include "core/certificatemanager.hpp"
+#include "core/preferences.hpp"
+
+#include "util/config.hpp"
+
+#include <libinfinity/common/inf-sasl-context.h>
+#include <libinfinity/common/inf-xmpp-connection.h>
+
+#include <glibmm/main.h>
+#include <sigc++/trackable.h>
+
+#include <memory>
+
+namespace Gobby
+{
+
+// Hosts the local documents without any user interface, for gobby --serve.
+// It uses the same preferences and document directory as the regular
+// application, but does not create any GTK+ widgets, and hosted text
+// documents are kept in plain text buffers instead of GtkSourceBuffers.
+class DedicatedServer: public sigc::trackable
+{
+public:
+	DedicatedServer();
+	~DedicatedServer();
+
+	// Serves the documents until SIGINT or SIGTERM is received.
+	void run();
+
+protected:
+	static void sasl_callback_static(InfSaslContextSession* session,
+	                                 Gsasl_property prop,
+	                                 gpointer session_data,
+	                                 gpointer user_data)
+	{
+		static_cast<DedicatedServer*>(user_data)->sasl_callback(
+			session, INF_XMPP_CONNECTION(session_data), prop);
+	}
+
+	static gboolean on_quit_signal_static(gpointer user_data)
+	{
+		static_cast<DedicatedServer*>(user_data)->m_main_loop->quit();
+		return TRUE;
+	}
+
+	void sasl_callback(InfSaslContextSession* session,
+	                   InfXmppConnection* xmpp,
+	                   Gsasl_property prop);
+	void set_sasl_error(InfXmppConnection* connection,
+	                    const gchar* message);
+
+	void on_info_changed();
+	void on_error(const Glib::ustring& brief_desc,
+	              const Glib::ustring& detailed_desc);
+
+	Config m_config;
+	Preferences m_preferences;
+	CertificateManager m_cert_manager;
+	ConnectionManager m_connection_manager;
+
+	InfSaslContext* m_sasl_context;
+	std::unique_ptr<SelfHoster> m_self_hoster;
+
+	Glib::RefPtr<Glib::MainLoop> m_main_loop;
+};
+
+}
+
+#endif // _GOBBY_DEDICATEDSERVER_HPP_
@@ -18,12 +18,37 @@
 
 #include "util/i18n.hpp"
 
+#include <gtkmm/clipboard.h>
+#include <glibmm/main.h>
+
+#include <iomanip>
+
 #include <libinfinity/client/infc-browser.h>
 
+namespace
+{
+	Glib::ustring format_size(guint64 bytes)
+	{
+		gchar* str = g_format_size(bytes);
+		Glib::ustring result(str);
+		g_free(str);
+		return result;
+	}
+
+	Glib::ustring format_milliseconds(gint64 usecs)
+	{
+		return Glib::ustring::compose(
+			_("%1 ms"),
+			Glib::ustring::format(std::fixed, std::setprecision(1),
+			                      usecs / 1000.0));
+	}
+}
+
 Gobby::ConnectionInfoDialog::ConnectionInfoDialog(
 	GtkDialog* cobject, const Glib::RefPtr<Gtk::Builder>& builder)
 :
-	Gtk::Dialog(cobject), m_browser(NULL),
+	Gtk::Dialog(cobject), m_browser(NULL), m_connection_manager(NULL),
+	m_connection(NULL),
 	m_connection_store(Gtk::ListStore::create(m_columns)),
 	m_connection_added_handler(0),
 	m_connection_removed_handler(0),
@@ -32,6 +57,9 @@ Gobby::ConnectionInfoDialog::ConnectionInfoDialog(
 	builder->get_widget("image", m_image);
 	builder->get_widget("treeview", m_connection_tree_view);
 	builder->get_widget("scrolled-window", m_connection_scroll);
+	builder->get_widget("statistics-box", m_statistics_box);
+	builder->get_widget("statistics", m_statistics_label);
+	builder->get_widget("copy-statistics", m_copy_statistics_button);
 
 	m_connection_view = INF_GTK_CONNECTION_VIEW(
 		gtk_builder_get_object(builder->gobj(), "connection-info"));
@@ -65,15 +93,26 @@ Gobby::ConnectionInfoDialog::ConnectionInfoDialog(
 	selection->signal_changed().connect(
 		sigc::mem_fun(*this,
 			&ConnectionInfoDialog::on_selection_changed));
+
+	m_copy_statistics_button->signal_clicked().connect(
+		sigc::mem_fun(*this,
+			&ConnectionInfoDialog::on_copy_statistics));
+
+	// Keep the statistics up to date while the dialog is open
+	m_update_connection = Glib::signal_timeout().connect_seconds(
+		sigc::mem_fun(*this,
+			&ConnectionInfoDialog::on_update_timeout), 1);
 }
 
 Gobby::ConnectionInfoDialog::~ConnectionInfoDialog()
 {
+	m_update_connection.disconnect();
 	set_browser(NULL);
 }
 
 std::unique_ptr<Gobby::ConnectionInfoDialog>
-Gobby::ConnectionInfoDialog::create(Gtk::Window& parent, InfBrowser* browser)
+Gobby::ConnectionInfoDialog::create(Gtk::Window& parent, InfBrowser* browser,
+                                    const ConnectionManager& connection_manager)
 {
 	// Make sure the GType for InfGtkConnectionView is registered,
 	// since the UI definition contains a widget of this kind, and
@@ -91,6 +130,7 @@ Gobby::ConnectionInfoDialog::create(Gtk::Window& parent, InfBrowser* browser)
 	builder->get_widget_derived("ConnectionInfoDialog", dialog_ptr);
 	std::unique_ptr<ConnectionInfoDialog> dialog(dialog_ptr);
 	dialog->set_transient_for(parent);
+	dialog->m_connection_manager = &connection_manager;
 	dialog->set_browser(browser);
 	return dialog;
 }
@@ -127,11 +167,7 @@ void Gobby::ConnectionInfoDialog::set_browser(InfBrowser* browser)
 		InfXmlConnection* conn = infc_browser_get_connection(
 			INFC_BROWSER(browser));
 		if(INF_IS_XMPP_CONNECTION(conn))
-		{
-			inf_gtk_connection_view_set_connection(
-				m_connection_view,
-				INF_XMPP_CONNECTION(conn));
-		}
+			set_connection(INF_XMPP_CONNECTION(conn));
 
 		/* TODO: Show this corresponding to connection status, or
 		 * network-server if we are a server. */
@@ -180,9 +216,15 @@ void Gobby::ConnectionInfoDialog::set_browser(InfBrowser* browser)
 	}
 
 	if(!m_empty)
+	{
 		gtk_widget_show(GTK_WIDGET(m_connection_view));
+		m_statistics_box->show();
+	}
 	else
+	{
 		gtk_widget_hide(GTK_WIDGET(m_connection_view));
+		m_statistics_box->hide();
+	}
 }
 
 void Gobby::ConnectionInfoDialog::foreach_connection_func(
@@ -202,6 +244,7 @@ void Gobby::ConnectionInfoDialog::foreach_connection_func(
 		if(m_empty)
 		{
 			gtk_widget_show(GTK_WIDGET(m_connection_view));
+			m_statistics_box->show();
 			m_connection_tree_view->get_selection()->
 				set_mode(Gtk::SELECTION_BROWSE);
 			m_connection_tree_view->get_selection()->select(iter);
@@ -227,6 +270,7 @@ void Gobby::ConnectionInfoDialog::on_connection_added(
 		if(m_empty)
 		{
 			gtk_widget_show(GTK_WIDGET(m_connection_view));
+			m_statistics_box->show();
 			m_connection_tree_view->get_selection()->
 				set_mode(Gtk::SELECTION_BROWSE);
 			m_connection_tree_view->get_selection()->select(iter);
@@ -245,6 +289,9 @@ void Gobby::ConnectionInfoDialog::on_connection_removed(
 		g_assert(iter != m_connection_store->children().end());
 		m_connection_store->erase(iter);
 
+		if(INF_XMPP_CONNECTION(conn) == m_connection)
+			set_connection(NULL);
+
 		g_assert(!m_empty);
 		if(m_connection_store->children().empty())
 		{
@@ -252,6 +299,7 @@ void Gobby::ConnectionInfoDialog::on_connection_removed(
 			(*iter)[m_columns.connection] = NULL;
 
 			gtk_widget_hide(GTK_WIDGET(m_connection_view));
+			m_statistics_box->hide();
 			m_connection_tree_view->get_selection()->
 				set_mode(Gtk::SELECTION_NONE);
 			m_empty = true;
@@ -266,16 +314,26 @@ void Gobby::ConnectionInfoDialog::on_selection_changed()
 		Gtk::TreeIter iter =
 			m_connection_tree_view->get_selection()->
 				get_selected();
-		inf_gtk_connection_view_set_connection(
-			m_connection_view, (*iter)[m_columns.connection]);
+		set_connection((*iter)[m_columns.connection]);
 	}
 	else
 	{
-		inf_gtk_connection_view_set_connection(
-			m_connection_view, NULL);
+		set_connection(NULL);
 	}
 }
 
+void Gobby::ConnectionInfoDialog::on_copy_statistics()
+{
+	Gtk::Clipboard::get()->set_text(
+		m_connection_manager->dump_metrics_json());
+}
+
+bool Gobby::ConnectionInfoDialog::on_update_timeout()
+{
+	update_statistics();
+	return true;
+}
+
 void Gobby::ConnectionInfoDialog::icon_cell_data_func(
 	Gtk::CellRenderer* renderer, const Gtk::TreeIter& iter)
 {
@@ -331,3 +389,78 @@ Gtk::TreeIter Gobby::ConnectionInfoDialog::find_connection(
 
 	return children.end();
 }
+
+void Gobby::ConnectionInfoDialog::set_connection(InfXmppConnection* conn)
+{
+	inf_gtk_connection_view_set_connection(m_connection_view, conn);
+	m_connection = conn;
+	update_statistics();
+}
+
+void Gobby::ConnectionInfoDialog::update_statistics()
+{
+	const ConnectionMetrics* metrics = NULL;
+	if(m_connection != NULL && m_connection_manager != NULL)
+		metrics = m_connection_manager->get_metrics(m_connection);
+
+	if(metrics == NULL)
+	{
+		m_statistics_label->set_text(
+			_("No statistics are available for this connection."));
+		return;
+	}
+
+	const guint64 messages_sent = metrics->get_messages_sent();
+	const guint64 messages_received = metrics->get_messages_received();
+
+	Glib::ustring text = Glib::ustring::compose(
+		ngettext("Sent: %1 in %2 message",
+		         "Sent: %1 in %2 messages", messages_sent),
+		format_size(metrics->get_bytes_sent()), messages_sent);
+	text += "\n";
+	text += Glib::ustring::compose(
+		ngettext("Received: %1 in %2 message",
+		         "Received: %1 in %2 messages", messages_received),
+		format_size(metrics->get_bytes_received()),
+		messages_received);
+	text += "\n";
+
+	if(metrics->get_rtt_samples() == 0)
+	{
+		text += _("Round-trip time: unknown");
+		m_statistics_label->set_text(text);
+		return;
+	}
+
+	text += Glib::ustring::compose(
+		_("Round-trip time: %1 (minimum %2)"),
+		format_milliseconds(metrics->get_rtt_smoothed()),
+		format_milliseconds(metrics->get_rtt_min()));
+	text += "\n";
+	text += _("Reply latency:");
+
+	for(unsigned int i = 0; i < ConnectionMetrics::N_BUCKETS; ++i)
+	{
+		const guint64 count = metrics->get_bucket_count(i);
+		if(count == 0) continue;
+
+		const unsigned int limit =
+			ConnectionMetrics::get_bucket_limit(i);
+
+		text += "\n\t";
+		if(limit != 0)
+		{
+			text += Glib::ustring::compose(
+				_("below %1 ms: %2"), limit, count);
+		}
+		else
+		{
+			text += Glib::ustring::compose(
+				_("%1 ms or more: %2"),
+				ConnectionMetrics::get_bucket_limit(i - 1),
+				count);
+		}
+	}
+
+	m_statistics_label->set_text(text);
+}
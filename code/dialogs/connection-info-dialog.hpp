@@ -17,7 +17,12 @@
 #ifndef _GOBBY_CONNECTIONINFODIALOG_HPP_
 #define _GOBBY_CONNECTIONINFODIALOG_HPP_
 
+#include "core/connectionmanager.hpp"
+
 #include <gtkmm/dialog.h>
+#include <gtkmm/label.h>
+#include <gtkmm/button.h>
+#include <gtkmm/box.h>
 #include <gtkmm/treeview.h>
 #include <gtkmm/liststore.h>
 #include <gtkmm/scrolledwindow.h>
@@ -40,7 +45,8 @@ public:
 	~ConnectionInfoDialog();
 
 	static std::unique_ptr<ConnectionInfoDialog> create(
-		Gtk::Window& parent, InfBrowser* browser);
+		Gtk::Window& parent, InfBrowser* browser,
+		const ConnectionManager& connection_manager);
 
 	void set_browser(InfBrowser* browser);
 private:
@@ -72,6 +78,8 @@ private:
 	void on_connection_removed(InfXmlConnection* conn);
 
 	void on_selection_changed();
+	void on_copy_statistics();
+	bool on_update_timeout();
 
 	void icon_cell_data_func(Gtk::CellRenderer* renderer,
 	                         const Gtk::TreeIter& iter);
@@ -81,6 +89,9 @@ private:
 protected:
 	Gtk::TreeIter find_connection(InfXmppConnection* conn);
 
+	void set_connection(InfXmppConnection* conn);
+	void update_statistics();
+
 	class Columns: public Gtk::TreeModelColumnRecord
 	{
 	public:
@@ -93,6 +104,8 @@ protected:
 	};
 
 	InfBrowser* m_browser;
+	const ConnectionManager* m_connection_manager;
+	InfXmppConnection* m_connection;
 
 	Columns m_columns;
 	Glib::RefPtr<Gtk::ListStore> m_connection_store;
@@ -100,12 +113,17 @@ protected:
 	Gtk::Image* m_image;
 	Gtk::TreeView* m_connection_tree_view;
 	Gtk::ScrolledWindow* m_connection_scroll;
+	Gtk::Box* m_statistics_box;
+	Gtk::Label* m_statistics_label;
+	Gtk::Button* m_copy_statistics_button;
 
 	InfGtkConnectionView* m_connection_view;
 
 	gulong m_connection_added_handler;
 	gulong m_connection_removed_handler;
 
+	sigc::connection m_update_connection;
+
 	bool m_empty;
 };
 
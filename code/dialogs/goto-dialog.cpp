@@ -101,31 +101,29 @@ void Gobby::GotoDialog::on_response(int id)
 
 void Gobby::GotoDialog::on_document_changed(SessionView* view)
 {
-	if(m_current_view != NULL)
-	{
-		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
-			m_current_view->get_text_buffer());
-		g_signal_handler_disconnect(buffer, m_changed_handler);
-	}
-
+	m_changes_connection.disconnect();
 	m_current_view = dynamic_cast<TextSessionView*>(view);
 	set_response_sensitive(Gtk::RESPONSE_ACCEPT, m_current_view != NULL);
 	m_entry_line->set_sensitive(m_current_view != NULL);
 
 	if(m_current_view != NULL)
 	{
-		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
-			m_current_view->get_text_buffer());
-
-		m_changed_handler = g_signal_connect_after(
-			G_OBJECT(buffer), "changed",
-			G_CALLBACK(on_changed_static), this);
+		m_changes_connection = m_current_view->
+			get_change_dispatcher().signal_changed().connect(
+				sigc::mem_fun(*this, &GotoDialog::on_changes));
 
-		on_changed();
+		update_range();
 	}
 }
 
-void Gobby::GotoDialog::on_changed()
+void Gobby::GotoDialog::on_changes(unsigned int changes,
+                                   const TextChangeDispatcher::AuthorList&)
+{
+	if(changes & TextChangeDispatcher::CHANGE_TEXT)
+		update_range();
+}
+
+void Gobby::GotoDialog::update_range()
 {
 	g_assert(m_current_view != NULL);
 	GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
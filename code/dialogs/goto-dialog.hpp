@@ -41,24 +41,20 @@ public:
 	                                        const Folder& folder);
 
 protected:
-	static void on_changed_static(GtkTextBuffer* buffer,
-	                              gpointer user_data)
-	{
-		static_cast<GotoDialog*>(user_data)->on_changed();
-	}
-
 	virtual void on_show();
 	virtual void on_response(int id);
 
 	void on_document_changed(SessionView* view);
-	void on_changed();
+	void on_changes(unsigned int changes,
+	                const TextChangeDispatcher::AuthorList& authors);
+	void update_range();
 
 	const Folder* m_folder;
 
 	Gtk::SpinButton* m_entry_line;
 
 	TextSessionView* m_current_view;
-	gulong m_changed_handler;
+	sigc::connection m_changes_connection;
 };
 
 }
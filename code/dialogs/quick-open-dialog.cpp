@@ -0,0 +1,156 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "dialogs/quick-open-dialog.hpp"
+#include "util/i18n.hpp"
+
+#include <gdk/gdkkeysyms.h>
+
+namespace
+{
+	// Nobody is going to look through more than that
+	const unsigned int MAX_MATCHES = 50;
+}
+
+Gobby::QuickOpenDialog::QuickOpenDialog(
+	GtkDialog* cobject, const Glib::RefPtr<Gtk::Builder>& builder)
+:
+	Gtk::Dialog(cobject), m_index(NULL),
+	m_store(Gtk::ListStore::create(m_columns))
+{
+	builder->get_widget("query-entry", m_entry_query);
+	builder->get_widget("results-view", m_view_results);
+
+	m_view_results->set_model(m_store);
+	m_view_results->append_column(_("Document"), m_columns.path);
+	m_view_results->append_column(_("Server"), m_columns.server);
+	m_view_results->get_column(0)->set_expand(true);
+
+	m_entry_query->set_activates_default(true);
+	m_entry_query->signal_changed().connect(
+		sigc::mem_fun(*this, &QuickOpenDialog::on_query_changed));
+	// Before the entry's own handler, which would move the focus
+	m_entry_query->signal_key_press_event().connect(
+		sigc::mem_fun(*this, &QuickOpenDialog::on_query_key_press),
+		false);
+
+	m_view_results->signal_row_activated().connect(
+		sigc::mem_fun(*this, &QuickOpenDialog::on_row_activated));
+	m_view_results->get_selection()->signal_changed().connect(
+		sigc::mem_fun(*this, &QuickOpenDialog::on_selection_changed));
+
+	add_button(_("_Close"), Gtk::RESPONSE_CLOSE);
+	add_button(_("_Open"), Gtk::RESPONSE_ACCEPT);
+	set_default_response(Gtk::RESPONSE_ACCEPT);
+}
+
+std::unique_ptr<Gobby::QuickOpenDialog>
+Gobby::QuickOpenDialog::create(Gtk::Window& parent, const NodeIndex& index)
+{
+	Glib::RefPtr<Gtk::Builder> builder =
+		Gtk::Builder::create_from_resource(
+			"/de/0x539/gobby/ui/quick-open-dialog.ui");
+
+	QuickOpenDialog* dialog;
+	builder->get_widget_derived("QuickOpenDialog", dialog);
+	dialog->set_transient_for(parent);
+	dialog->m_index = &index;
+	return std::unique_ptr<QuickOpenDialog>(dialog);
+}
+
+const Gobby::NodeIndex::Match* Gobby::QuickOpenDialog::get_selected() const
+{
+	Gtk::TreeModel::iterator iter =
+		m_view_results->get_selection()->get_selected();
+	if(!iter) return NULL;
+
+	const unsigned int index = (*iter)[m_columns.index];
+	return &m_matches[index];
+}
+
+void Gobby::QuickOpenDialog::on_show()
+{
+	Gtk::Dialog::on_show();
+
+	// The index might have changed since the dialog was shown last
+	on_query_changed();
+
+	m_entry_query->select_region(0, m_entry_query->get_text_length());
+	m_entry_query->grab_focus();
+}
+
+void Gobby::QuickOpenDialog::on_query_changed()
+{
+	m_matches = m_index->search(m_entry_query->get_text(), MAX_MATCHES);
+
+	m_store->clear();
+	for(NodeIndex::MatchList::size_type i = 0; i < m_matches.size(); ++i)
+	{
+		const NodeIndex::Match& match = m_matches[i];
+
+		Gtk::TreeModel::Row row = *m_store->append();
+		row[m_columns.path] = match.path;
+		row[m_columns.server] =
+			m_index->get_browser_name(match.browser);
+		row[m_columns.index] = i;
+	}
+
+	if(!m_matches.empty())
+	{
+		m_view_results->set_cursor(
+			m_store->get_path(m_store->children().begin()));
+	}
+
+	on_selection_changed();
+}
+
+bool Gobby::QuickOpenDialog::on_query_key_press(GdkEventKey* event)
+{
+	// Let the cursor keys move through the results while the focus
+	// stays in the entry.
+	int offset;
+	switch(event->keyval)
+	{
+	case GDK_KEY_Up: case GDK_KEY_KP_Up: offset = -1; break;
+	case GDK_KEY_Down: case GDK_KEY_KP_Down: offset = 1; break;
+	default: return false;
+	}
+
+	if(m_matches.empty()) return true;
+
+	Gtk::TreeModel::Path path;
+	Gtk::TreeViewColumn* column;
+	m_view_results->get_cursor(path, column);
+
+	int row = path.empty() ? 0 : path[0] + offset;
+	if(row < 0) row = 0;
+	if(row >= static_cast<int>(m_matches.size()))
+		row = m_matches.size() - 1;
+
+	m_view_results->set_cursor(Gtk::TreeModel::Path(1, row));
+	return true;
+}
+
+void Gobby::QuickOpenDialog::on_row_activated(
+	const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column)
+{
+	response(Gtk::RESPONSE_ACCEPT);
+}
+
+void Gobby::QuickOpenDialog::on_selection_changed()
+{
+	set_response_sensitive(Gtk::RESPONSE_ACCEPT, get_selected() != NULL);
+}
@@ -0,0 +1,79 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_QUICKOPENDIALOG_HPP_
+#define _GOBBY_QUICKOPENDIALOG_HPP_
+
+#include "core/nodeindex.hpp"
+
+#include <gtkmm/dialog.h>
+#include <gtkmm/builder.h>
+#include <gtkmm/searchentry.h>
+#include <gtkmm/treeview.h>
+#include <gtkmm/liststore.h>
+
+namespace Gobby
+{
+
+// Lets the user pick one of the explored documents of all connected
+// servers by typing parts of its path.
+class QuickOpenDialog: public Gtk::Dialog
+{
+private:
+	friend class Gtk::Builder;
+	QuickOpenDialog(GtkDialog* cobject,
+	                const Glib::RefPtr<Gtk::Builder>& builder);
+
+public:
+	static std::unique_ptr<QuickOpenDialog> create(Gtk::Window& parent,
+	                                             const NodeIndex& index);
+
+	// Returns the selected document, or NULL if there is none.
+	const NodeIndex::Match* get_selected() const;
+
+protected:
+	class Columns: public Gtk::TreeModelColumnRecord
+	{
+	public:
+		Gtk::TreeModelColumn<Glib::ustring> path;
+		Gtk::TreeModelColumn<Glib::ustring> server;
+		Gtk::TreeModelColumn<unsigned int> index;
+
+		Columns() { add(path); add(server); add(index); }
+	};
+
+	virtual void on_show();
+
+	void on_query_changed();
+	bool on_query_key_press(GdkEventKey* event);
+	void on_row_activated(const Gtk::TreeModel::Path& path,
+	                      Gtk::TreeViewColumn* column);
+	void on_selection_changed();
+
+	const NodeIndex* m_index;
+
+	Gtk::SearchEntry* m_entry_query;
+	Gtk::TreeView* m_view_results;
+
+	Columns m_columns;
+	Glib::RefPtr<Gtk::ListStore> m_store;
+
+	NodeIndex::MatchList m_matches;
+};
+
+}
+
+#endif // _GOBBY_QUICKOPENDIALOG_HPP_
@@ -0,0 +1,589 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "importer.hpp"
+
+#include "core/noteplugin.hpp"
+
+#include "util/file.hpp"
+#include "util/i18n.hpp"
+#include "util/uri.hpp"
+
+#include <libinfinity/client/infc-browser.h>
+#include <libinftext/inf-text-session.h>
+#include <libinftext/inf-text-default-buffer.h>
+
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+#include <glibmm/convert.h>
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <map>
+
+namespace
+{
+	// Number of requests to keep in flight. Each one keeps one file in
+	// memory until the server has received it.
+	const unsigned int MAX_REQUESTS = 16;
+
+	std::string format_size(guint64 bytes)
+	{
+		gchar* str = g_format_size(bytes);
+		std::string result = str;
+		g_free(str);
+		return result;
+	}
+}
+
+Gobby::Importer::Importer(const std::string& directory,
+                          const std::string& target):
+	m_directory(directory),
+	m_target(target),
+	m_config(config_filename("config.xml")),
+	m_preferences(m_config),
+	m_cert_manager(m_preferences),
+	m_connection_manager(m_cert_manager, m_preferences),
+	m_certificate_verify(inf_certificate_verify_new(
+		m_connection_manager.get_xmpp_manager(),
+		config_filename("known_hosts").c_str())),
+	m_browser(NULL),
+	m_notify_status_handler(0),
+	m_error_handler(0),
+	m_connected(false),
+	m_path_index(0),
+	m_n_requests(0),
+	m_start_time(0),
+	m_n_documents(0),
+	m_n_directories(0),
+	m_n_skipped(0),
+	m_n_failed(0),
+	m_bytes(0),
+	m_result(true),
+	m_main_loop(Glib::MainLoop::create())
+{
+	// There is nobody to ask whether to trust a certificate, so only
+	// connect to hosts whose certificate is signed by a trusted CA or
+	// has been accepted in gobby before.
+	g_signal_connect(
+		G_OBJECT(m_certificate_verify), "check-certificate",
+		G_CALLBACK(on_check_certificate_static), this);
+}
+
+Gobby::Importer::~Importer()
+{
+	for(std::deque<Job*>::iterator iter = m_jobs.begin();
+	    iter != m_jobs.end(); ++iter)
+	{
+		delete *iter;
+	}
+
+	if(m_browser != NULL)
+	{
+		g_signal_handler_disconnect(m_browser,
+		                            m_notify_status_handler);
+		g_signal_handler_disconnect(m_browser, m_error_handler);
+		g_object_unref(m_browser);
+	}
+
+	g_signal_handlers_disconnect_by_func(
+		G_OBJECT(m_certificate_verify),
+		(gpointer)G_CALLBACK(on_check_certificate_static), this);
+	g_object_unref(m_certificate_verify);
+}
+
+bool Gobby::Importer::run()
+{
+	if(!Glib::file_test(m_directory, Glib::FILE_TEST_IS_DIR))
+	{
+		std::cerr << Glib::ustring::compose(
+			_("\"%1\" is not a directory"),
+			Glib::filename_display_name(m_directory))
+			<< std::endl;
+		return false;
+	}
+
+	std::string scheme, netloc, path;
+	parse_uri(m_target, scheme, netloc, path);
+	if(scheme != "infinote")
+	{
+		throw std::runtime_error(
+			Glib::ustring::compose(
+				_("URI scheme \"%1\" not supported"),
+				scheme));
+	}
+
+	m_path = split_path(path);
+
+	std::string hostname, service;
+	unsigned int device_index;
+	parse_netloc(netloc, hostname, service, device_index);
+
+	// The certificates need to be available for the TLS handshake
+	m_cert_manager.wait();
+
+	InfXmppConnection* xmpp = m_connection_manager.make_connection(
+		hostname, service, device_index, true);
+
+	m_browser = INF_BROWSER(infc_browser_new(
+		m_connection_manager.get_io(),
+		m_connection_manager.get_communication_manager(),
+		INF_XML_CONNECTION(xmpp)));
+	infc_browser_add_plugin(INFC_BROWSER(m_browser), Plugins::C_TEXT);
+
+	m_notify_status_handler = g_signal_connect(
+		G_OBJECT(m_browser), "notify::status",
+		G_CALLBACK(on_notify_status_static), this);
+	m_error_handler = g_signal_connect(
+		G_OBJECT(m_browser), "error",
+		G_CALLBACK(on_error_static), this);
+
+	std::cout << Glib::ustring::compose(
+		_("Connecting to \"%1\"..."), m_target) << std::endl;
+
+	on_notify_status();
+
+	sigc::connection report_connection =
+		Glib::signal_timeout().connect_seconds(
+			sigc::mem_fun(*this, &Importer::on_report), 1);
+
+	m_main_loop->run();
+
+	report_connection.disconnect();
+	return m_result;
+}
+
+void Gobby::Importer::on_notify_status()
+{
+	InfBrowserStatus status;
+	g_object_get(G_OBJECT(m_browser), "status", &status, NULL);
+
+	if(status == INF_BROWSER_OPEN)
+	{
+		if(!m_connected)
+		{
+			m_connected = true;
+			inf_browser_get_root(m_browser, &m_path_iter);
+			m_path_index = 0;
+			explore_target();
+		}
+	}
+	else if(status == INF_BROWSER_CLOSED)
+	{
+		std::cerr << Glib::ustring::compose(
+			_("Connection to \"%1\" closed"), m_target)
+			<< std::endl;
+
+		m_result = false;
+		m_main_loop->quit();
+	}
+}
+
+void Gobby::Importer::on_error(const GError* error)
+{
+	std::cerr << error->message << std::endl;
+}
+
+void Gobby::Importer::on_check_certificate(InfXmppConnection* connection,
+                                           InfCertificateVerifyFlags flags)
+{
+	std::cerr << _("The server certificate cannot be verified. Connect "
+	               "to the server with Gobby once to accept it.")
+	          << std::endl;
+
+	inf_certificate_verify_checked(
+		m_certificate_verify, connection, FALSE);
+}
+
+void Gobby::Importer::explore_target()
+{
+	if(!inf_browser_is_subdirectory(m_browser, &m_path_iter))
+	{
+		std::cerr << Glib::ustring::compose(
+			_("\"%1\" is not a directory"), m_target)
+			<< std::endl;
+
+		m_result = false;
+		m_main_loop->quit();
+		return;
+	}
+
+	if(!inf_browser_get_explored(m_browser, &m_path_iter))
+	{
+		inf_browser_explore(
+			m_browser, &m_path_iter,
+			on_explore_target_finished_static, this);
+		return;
+	}
+
+	if(m_path_index == m_path.size())
+	{
+		// Arrived at the target directory
+		std::cout << Glib::ustring::compose(
+			_("Importing \"%1\" into \"%2\"..."),
+			Glib::filename_display_name(m_directory), m_target)
+			<< std::endl;
+
+		m_start_time = g_get_monotonic_time();
+		add_children(&m_path_iter, m_directory);
+		start_jobs();
+		return;
+	}
+
+	if(inf_browser_get_child(m_browser, &m_path_iter))
+	{
+		do
+		{
+			const char* name = inf_browser_get_node_name(
+				m_browser, &m_path_iter);
+			if(m_path[m_path_index] == name)
+			{
+				++m_path_index;
+				explore_target();
+				return;
+			}
+		} while(inf_browser_get_next(m_browser, &m_path_iter));
+	}
+
+	std::cerr << Glib::ustring::compose(
+		_("Path \"%1\" does not exist"), m_target) << std::endl;
+
+	m_result = false;
+	m_main_loop->quit();
+}
+
+void Gobby::Importer::on_explore_target_finished(const GError* error)
+{
+	if(error != NULL)
+	{
+		std::cerr << error->message << std::endl;
+		m_result = false;
+		m_main_loop->quit();
+	}
+	else
+	{
+		explore_target();
+	}
+}
+
+void Gobby::Importer::add_children(const InfBrowserIter* parent,
+                                   const std::string& local_path)
+{
+	// Entries which exist on the server already
+	std::map<std::string, InfBrowserIter> existing;
+
+	InfBrowserIter iter = *parent;
+	if(inf_browser_get_child(m_browser, &iter))
+	{
+		do
+		{
+			existing[inf_browser_get_node_name(m_browser, &iter)] =
+				iter;
+		} while(inf_browser_get_next(m_browser, &iter));
+	}
+
+	try
+	{
+		Glib::Dir dir(local_path);
+		for(Glib::DirIterator dir_iter = dir.begin();
+		    dir_iter != dir.end(); ++dir_iter)
+		{
+			const std::string name = *dir_iter;
+
+			// Skip hidden files, such as version control
+			// metadata
+			if(name.empty() || name[0] == '.') continue;
+
+			std::unique_ptr<Job> job(new Job);
+			job->importer = this;
+			job->parent = *parent;
+			job->local_path =
+				Glib::build_filename(local_path, name);
+			job->merge = false;
+			job->bytes = 0;
+
+			try
+			{
+				job->name = Glib::filename_to_utf8(name);
+			}
+			catch(const Glib::ConvertError& ex)
+			{
+				std::cerr << Glib::ustring::compose(
+					_("Skipping %1: %2"),
+					Glib::filename_display_name(
+						job->local_path),
+					ex.what()) << std::endl;
+				++m_n_skipped;
+				continue;
+			}
+
+			if(Glib::file_test(job->local_path,
+			                   Glib::FILE_TEST_IS_DIR))
+			{
+				job->directory = true;
+			}
+			else if(Glib::file_test(job->local_path,
+			                        Glib::FILE_TEST_IS_REGULAR))
+			{
+				job->directory = false;
+			}
+			else
+			{
+				continue;
+			}
+
+			std::map<std::string, InfBrowserIter>::const_iterator
+				existing_iter = existing.find(job->name);
+			if(existing_iter == existing.end())
+			{
+				m_jobs.push_back(job.release());
+			}
+			else if(job->directory &&
+			        inf_browser_is_subdirectory(
+					m_browser, &existing_iter->second))
+			{
+				// Merge into the existing directory
+				job->parent = existing_iter->second;
+				job->merge = true;
+				m_jobs.push_back(job.release());
+			}
+			else
+			{
+				++m_n_skipped;
+			}
+		}
+	}
+	catch(const Glib::Exception& ex)
+	{
+		fail(local_path, ex.what());
+	}
+}
+
+// Called with a job whose parent is a directory on the server that
+// corresponds to job->local_path.
+void Gobby::Importer::explore(Job* job)
+{
+	if(inf_browser_get_explored(m_browser, &job->parent))
+	{
+		add_children(&job->parent, job->local_path);
+		delete job;
+	}
+	else
+	{
+		++m_n_requests;
+		inf_browser_explore(
+			m_browser, &job->parent,
+			on_explore_finished_static, job);
+	}
+}
+
+void Gobby::Importer::on_explore_finished(Job* job, const GError* error)
+{
+	--m_n_requests;
+
+	if(error != NULL)
+	{
+		fail(job->local_path, error->message);
+		delete job;
+	}
+	else
+	{
+		explore(job);
+	}
+
+	start_jobs();
+}
+
+void Gobby::Importer::start_job(Job* job)
+{
+	if(job->merge)
+	{
+		explore(job);
+		return;
+	}
+
+	++m_n_requests;
+
+	if(job->directory)
+	{
+		inf_browser_add_subdirectory(
+			m_browser, &job->parent, job->name.c_str(), NULL,
+			on_add_finished_static, job);
+	}
+	else
+	{
+		InfSession* session = create_session(job);
+		if(session == NULL)
+		{
+			--m_n_requests;
+			delete job;
+			return;
+		}
+
+		inf_browser_add_note(
+			m_browser, &job->parent, job->name.c_str(),
+			"InfText", NULL, session, FALSE,
+			on_add_finished_static, job);
+		g_object_unref(session);
+	}
+}
+
+void Gobby::Importer::start_jobs()
+{
+	while(m_n_requests < MAX_REQUESTS && !m_jobs.empty())
+	{
+		Job* job = m_jobs.front();
+		m_jobs.pop_front();
+		start_job(job);
+	}
+
+	if(m_n_requests == 0 && m_jobs.empty() && m_start_time != 0)
+	{
+		report(_("Finished:"));
+		if(m_n_failed > 0) m_result = false;
+		m_main_loop->quit();
+	}
+}
+
+void Gobby::Importer::on_add_finished(Job* job,
+                                      const InfBrowserIter* iter,
+                                      const GError* error)
+{
+	--m_n_requests;
+
+	if(error != NULL)
+	{
+		fail(job->local_path, error->message);
+		delete job;
+	}
+	else if(job->directory)
+	{
+		++m_n_directories;
+		job->parent = *iter;
+		explore(job);
+	}
+	else
+	{
+		++m_n_documents;
+		m_bytes += job->bytes;
+		delete job;
+	}
+
+	start_jobs();
+}
+
+InfSession* Gobby::Importer::create_session(Job* job)
+{
+	std::string content;
+	try
+	{
+		content = Glib::file_get_contents(job->local_path);
+	}
+	catch(const Glib::Exception& ex)
+	{
+		fail(job->local_path, ex.what());
+		return NULL;
+	}
+
+	// Text files do not contain NUL bytes
+	if(content.find('\0') != std::string::npos)
+	{
+		++m_n_skipped;
+		return NULL;
+	}
+
+	if(!g_utf8_validate(content.data(), content.length(), NULL))
+	{
+		try
+		{
+			content = Glib::locale_to_utf8(content);
+		}
+		catch(const Glib::ConvertError&)
+		{
+			content = Glib::convert(
+				content, "UTF-8", "ISO-8859-1");
+		}
+	}
+
+	job->bytes = content.length();
+
+	InfTextDefaultBuffer* buffer = inf_text_default_buffer_new("UTF-8");
+	inf_text_buffer_insert_text(
+		INF_TEXT_BUFFER(buffer), 0, content.data(), content.length(),
+		g_utf8_strlen(content.data(), content.length()), NULL);
+
+	InfTextSession* session = inf_text_session_new(
+		m_connection_manager.get_communication_manager(),
+		INF_TEXT_BUFFER(buffer), m_connection_manager.get_io(),
+		INF_SESSION_RUNNING, NULL, NULL);
+	g_object_unref(buffer);
+
+	return INF_SESSION(session);
+}
+
+bool Gobby::Importer::on_report()
+{
+	if(m_start_time != 0)
+		report("");
+	return true;
+}
+
+void Gobby::Importer::report(const char* prefix)
+{
+	const double seconds =
+		(g_get_monotonic_time() - m_start_time) / 1e6;
+
+	std::string line = Glib::ustring::compose(
+		_("%1 documents and %2 directories (%3) in %4 s"),
+		m_n_documents, m_n_directories, format_size(m_bytes),
+		Glib::ustring::format(std::fixed, std::setprecision(1),
+		                      seconds));
+
+	if(seconds > 0)
+	{
+		line += ", " + Glib::ustring::compose(
+			_("%1 documents/s, %2/s"),
+			Glib::ustring::format(std::fixed,
+			                      std::setprecision(1),
+			                      m_n_documents / seconds),
+			format_size(static_cast<guint64>(m_bytes / seconds)));
+	}
+
+	if(m_n_skipped > 0)
+	{
+		line += ", " + Glib::ustring::compose(
+			_("%1 skipped"), m_n_skipped);
+	}
+
+	if(m_n_failed > 0)
+	{
+		line += ", " + Glib::ustring::compose(
+			_("%1 failed"), m_n_failed);
+	}
+
+	if(*prefix != '\0')
+		std::cout << prefix << " ";
+	std::cout << line << std::endl;
+}
+
+void Gobby::Importer::fail(const std::string& path,
+                           const std::string& message)
+{
+	++m_n_failed;
+	std::cerr << Glib::filename_display_name(path) << ": " << message
+	          << std::endl;
+}
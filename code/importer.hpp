@@ -0,0 +1,191 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_IMPORTER_HPP_
+#define _GOBBY_IMPORTER_HPP_
+
+#include "core/connectionmanager.hpp"
+#include "core/certificatemanager.hpp"
+#include "core/preferences.hpp"
+
+#include "util/config.hpp"
+
+#include <libinfinity/common/inf-browser.h>
+#include <libinfinity/common/inf-certificate-verify.h>
+#include <libinfinity/common/inf-request-result.h>
+
+#include <glibmm/main.h>
+#include <sigc++/trackable.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace Gobby
+{
+
+// Copies a local directory tree into a directory on an infinote server,
+// for gobby --import. Like the dedicated server, this does not initialize
+// GTK+. Subdirectories are created as needed, and several files are
+// uploaded at the same time, so that the latency of the connection does
+// not limit the import rate. Entries that exist on the server already are
+// skipped, so an interrupted import can simply be run again.
+class Importer: public sigc::trackable
+{
+public:
+	Importer(const std::string& directory, const std::string& target);
+	~Importer();
+
+	// Returns false if an error occurred, or if a file could not be
+	// imported.
+	bool run();
+
+private:
+	struct Job
+	{
+		Importer* importer;
+		InfBrowserIter parent;
+		std::string local_path;
+		std::string name;
+		bool directory;
+		// Whether parent is an existing directory on the server that
+		// corresponds to local_path, whose contents only need to be
+		// added to it.
+		bool merge;
+		gsize bytes;
+	};
+
+	static void on_notify_status_static(GObject* object,
+	                                    GParamSpec* pspec,
+	                                    gpointer user_data)
+	{
+		static_cast<Importer*>(user_data)->on_notify_status();
+	}
+
+	static void on_error_static(InfBrowser* browser,
+	                            const GError* error,
+	                            gpointer user_data)
+	{
+		static_cast<Importer*>(user_data)->on_error(error);
+	}
+
+	static void on_check_certificate_static(InfCertificateVerify* verify,
+	                                        InfXmppConnection* connection,
+	                                        InfCertificateChain* chain,
+	                                        gnutls_x509_crt_t pinned,
+	                                        InfCertificateVerifyFlags flags,
+	                                        gpointer user_data)
+	{
+		static_cast<Importer*>(user_data)->on_check_certificate(
+			connection, flags);
+	}
+
+	static void on_explore_target_finished_static(
+		InfRequest* request,
+		const InfRequestResult* result,
+		const GError* error,
+		gpointer user_data)
+	{
+		static_cast<Importer*>(user_data)->
+			on_explore_target_finished(error);
+	}
+
+	static void on_explore_finished_static(InfRequest* request,
+	                                       const InfRequestResult* result,
+	                                       const GError* error,
+	                                       gpointer user_data)
+	{
+		Job* job = static_cast<Job*>(user_data);
+		job->importer->on_explore_finished(job, error);
+	}
+
+	static void on_add_finished_static(InfRequest* request,
+	                                   const InfRequestResult* result,
+	                                   const GError* error,
+	                                   gpointer user_data)
+	{
+		const InfBrowserIter* iter = NULL;
+		if(error == NULL)
+		{
+			inf_request_result_get_add_node(
+				result, NULL, NULL, &iter);
+		}
+
+		Job* job = static_cast<Job*>(user_data);
+		job->importer->on_add_finished(job, iter, error);
+	}
+
+	void on_notify_status();
+	void on_error(const GError* error);
+	void on_check_certificate(InfXmppConnection* connection,
+	                          InfCertificateVerifyFlags flags);
+
+	void explore_target();
+	void on_explore_target_finished(const GError* error);
+
+	void on_explore_finished(Job* job, const GError* error);
+	void on_add_finished(Job* job, const InfBrowserIter* iter,
+	                     const GError* error);
+
+	// Queues the contents of local_path for import into parent, which
+	// needs to be explored.
+	void add_children(const InfBrowserIter* parent,
+	                  const std::string& local_path);
+	void explore(Job* job);
+	void start_job(Job* job);
+	void start_jobs();
+
+	InfSession* create_session(Job* job);
+
+	bool on_report();
+	void report(const char* prefix);
+	void fail(const std::string& path, const std::string& message);
+
+	const std::string m_directory;
+	const std::string m_target;
+
+	Config m_config;
+	Preferences m_preferences;
+	CertificateManager m_cert_manager;
+	ConnectionManager m_connection_manager;
+	InfCertificateVerify* m_certificate_verify;
+
+	InfBrowser* m_browser;
+	gulong m_notify_status_handler;
+	gulong m_error_handler;
+	bool m_connected;
+
+	std::vector<std::string> m_path;
+	std::vector<std::string>::size_type m_path_index;
+	InfBrowserIter m_path_iter;
+
+	std::deque<Job*> m_jobs;
+	unsigned int m_n_requests;
+
+	gint64 m_start_time;
+	unsigned int m_n_documents;
+	unsigned int m_n_directories;
+	unsigned int m_n_skipped;
+	unsigned int m_n_failed;
+	guint64 m_bytes;
+
+	bool m_result;
+	Glib::RefPtr<Glib::MainLoop> m_main_loop;
+};
+
+}
+
+#endif // _GOBBY_IMPORTER_HPP_
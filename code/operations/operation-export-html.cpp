@@ -28,6 +28,7 @@
 #include <libinftextgtk/inf-text-gtk-buffer.h>
 
 #include <iomanip>
+#include <vector>
 #include <ctime>
 #include <cstring>
 #include <cmath>
@@ -107,6 +108,27 @@ namespace
 		return classes;
 	}
 
+	struct AuthorRun
+	{
+		unsigned int begin;
+		unsigned int end;
+		unsigned int author;
+	};
+
+	typedef std::vector<AuthorRun> author_run_list;
+
+	void add_author_run(unsigned int offset,
+	                    unsigned int length,
+	                    unsigned int author,
+	                    author_run_list& runs)
+	{
+		AuthorRun run;
+		run.begin = offset;
+		run.end = offset + length;
+		run.author = author;
+		runs.push_back(run);
+	}
+
 	// write the Gtk::TextBuffer from document into content, inserting
 	// <span/>s for line breaks and authorship of chunks of text, also
 	// save all users and tags encountered and the total number of
@@ -128,10 +150,15 @@ namespace
 
 		GtkTextBuffer* buffer = GTK_TEXT_BUFFER(
 			view.get_text_buffer());
-		InfTextGtkBuffer* inf_buffer
-			= INF_TEXT_GTK_BUFFER(
-				inf_session_get_buffer(
-					INF_SESSION(view.get_session())));
+
+		// the spans are written in order, so walk through the runs
+		// of equal authorship alongside them
+		author_run_list runs;
+		view.get_authorship().foreach_run(
+			0, gtk_text_buffer_get_char_count(buffer),
+			sigc::bind(sigc::ptr_fun(&add_author_run),
+			           sigc::ref(runs)));
+		author_run_list::const_iterator run = runs.begin();
 
 		GtkTextIter begin;
 		gtk_text_buffer_get_start_iter(buffer, &begin);
@@ -159,10 +186,14 @@ namespace
 				// add mouseover "written by" popup
 				// this only needs to happen when there are tags,
 				// because the presence of an author implies a tag
-				InfTextUser* user
-					= inf_text_gtk_buffer_get_author(
-						inf_buffer,
-						&begin);
+				const unsigned int offset =
+					gtk_text_iter_get_offset(&begin);
+				while(run != runs.end() && run->end <= offset)
+					++run;
+
+				InfTextUser* user = NULL;
+				if(run != runs.end() && run->begin <= offset)
+					user = view.get_author(run->author);
 				if(user)
 				{
 					char const* user_name =
@@ -0,0 +1,348 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "operations/operation-subscribe-directory.hpp"
+#include "util/i18n.hpp"
+
+namespace
+{
+	// Maximum number of explore and subscribe requests that are
+	// pending at the same time
+	const unsigned int MAX_RUNNING_REQUESTS = 4;
+
+	std::string get_path(InfBrowser* browser, const InfBrowserIter* iter)
+	{
+		gchar* path = inf_browser_get_path(browser, iter);
+		const std::string result = path;
+		g_free(path);
+		return result;
+	}
+
+	bool is_below(const std::string& path, const std::string& directory)
+	{
+		if(path == directory) return true;
+
+		// The root directory is "/", all others do not end in '/'
+		const std::string prefix =
+			directory == "/" ? directory : directory + "/";
+		return path.compare(0, prefix.length(), prefix) == 0;
+	}
+}
+
+Gobby::OperationSubscribeDirectory::OperationSubscribeDirectory(
+	Operations& operations, InfBrowser* browser,
+	const InfBrowserIter* iter):
+	Operation(operations), m_browser(browser), m_iter(*iter),
+	m_name(inf_browser_get_node_name(browser, iter)),
+	m_n_running(0), m_processing(false),
+	m_n_subscribed(0), m_n_failed(0),
+	m_message_handle(get_status_bar().invalid_handle())
+{
+	g_object_ref(m_browser);
+
+	m_node_removed_handler = g_signal_connect(
+		G_OBJECT(m_browser), "node-removed",
+		G_CALLBACK(on_node_removed_static), this);
+	m_notify_status_handler = g_signal_connect(
+		G_OBJECT(m_browser), "notify::status",
+		G_CALLBACK(on_notify_status_static), this);
+}
+
+Gobby::OperationSubscribeDirectory::~OperationSubscribeDirectory()
+{
+	for(RequestSet::iterator iter = m_requests.begin();
+	    iter != m_requests.end(); ++iter)
+	{
+		g_signal_handlers_disconnect_by_func(
+			G_OBJECT(*iter),
+			(gpointer)G_CALLBACK(on_explore_finished_static),
+			this);
+		g_signal_handlers_disconnect_by_func(
+			G_OBJECT(*iter),
+			(gpointer)G_CALLBACK(on_subscribe_finished_static),
+			this);
+		g_object_unref(*iter);
+	}
+
+	g_signal_handler_disconnect(m_browser, m_node_removed_handler);
+	g_signal_handler_disconnect(m_browser, m_notify_status_handler);
+
+	if(m_message_handle != get_status_bar().invalid_handle())
+		get_status_bar().remove_message(m_message_handle);
+
+	g_object_unref(m_browser);
+}
+
+void Gobby::OperationSubscribeDirectory::start()
+{
+	m_message_handle = get_status_bar().add_info_message(
+		Glib::ustring::compose(
+			_("Subscribing to all documents in \"%1\"..."),
+			m_name));
+
+	Node node;
+	node.iter = m_iter;
+	node.path = get_path(m_browser, &m_iter);
+	m_directories.push_back(node);
+
+	process();
+}
+
+void Gobby::OperationSubscribeDirectory::on_explore_finished(
+	InfRequest* request, const InfBrowserIter* iter, const GError* error)
+{
+	if(iter != NULL)
+		enqueue_children(iter);
+
+	request_finished(request, error);
+}
+
+void Gobby::OperationSubscribeDirectory::on_subscribe_finished(
+	InfRequest* request, const InfBrowserIter* iter, const GError* error)
+{
+	if(iter != NULL)
+	{
+		InfSessionProxy* proxy = inf_browser_get_session(
+			m_browser, iter);
+		g_assert(proxy != NULL);
+
+		show_document(iter, proxy);
+	}
+
+	request_finished(request, error);
+}
+
+void Gobby::OperationSubscribeDirectory::on_node_removed(
+	const InfBrowserIter* iter)
+{
+	// Forget about queued nodes that are no longer there
+	const std::string path = get_path(m_browser, iter);
+
+	for(NodeList::iterator node_iter = m_directories.begin();
+	    node_iter != m_directories.end(); )
+	{
+		if(is_below(node_iter->path, path))
+			node_iter = m_directories.erase(node_iter);
+		else
+			++node_iter;
+	}
+
+	for(NodeList::iterator node_iter = m_documents.begin();
+	    node_iter != m_documents.end(); )
+	{
+		if(is_below(node_iter->path, path))
+			node_iter = m_documents.erase(node_iter);
+		else
+			++node_iter;
+	}
+}
+
+void Gobby::OperationSubscribeDirectory::on_notify_status()
+{
+	InfBrowserStatus status;
+	g_object_get(G_OBJECT(m_browser), "status", &status, NULL);
+
+	// Don't set an error message, the user will already be
+	// notified by the closed browser.
+	if(status == INF_BROWSER_CLOSED)
+		fail();
+}
+
+void Gobby::OperationSubscribeDirectory::enqueue_children(
+	const InfBrowserIter* iter)
+{
+	InfBrowserIter child = *iter;
+	if(!inf_browser_get_child(m_browser, &child)) return;
+
+	do
+	{
+		Node node;
+		node.iter = child;
+		node.path = get_path(m_browser, &child);
+
+		if(inf_browser_is_subdirectory(m_browser, &child))
+			m_directories.push_back(node);
+		else
+			m_documents.push_back(node);
+	} while(inf_browser_get_next(m_browser, &child));
+}
+
+void Gobby::OperationSubscribeDirectory::explore(const Node& node)
+{
+	if(inf_browser_get_explored(m_browser, &node.iter))
+	{
+		enqueue_children(&node.iter);
+		return;
+	}
+
+	++m_n_running;
+
+	InfRequest* request = inf_browser_get_pending_request(
+		m_browser, &node.iter, "explore-node");
+
+	if(request == NULL)
+	{
+		request = inf_browser_explore(
+			m_browser, &node.iter,
+			on_explore_finished_static, this);
+	}
+	else
+	{
+		g_signal_connect(
+			G_OBJECT(request), "finished",
+			G_CALLBACK(on_explore_finished_static), this);
+	}
+
+	if(request != NULL)
+	{
+		g_object_ref(request);
+		m_requests.insert(request);
+	}
+}
+
+void Gobby::OperationSubscribeDirectory::subscribe(const Node& node)
+{
+	InfSessionProxy* proxy = inf_browser_get_session(
+		m_browser, &node.iter);
+
+	if(proxy != NULL)
+	{
+		// Subscribed already, so just make sure that the document
+		// is shown.
+		show_document(&node.iter, proxy);
+		return;
+	}
+
+	++m_n_running;
+
+	InfRequest* request = inf_browser_get_pending_request(
+		m_browser, &node.iter, "subscribe-session");
+
+	if(request == NULL)
+	{
+		request = inf_browser_subscribe(
+			m_browser, &node.iter,
+			on_subscribe_finished_static, this);
+	}
+	else
+	{
+		g_signal_connect(
+			G_OBJECT(request), "finished",
+			G_CALLBACK(on_subscribe_finished_static), this);
+	}
+
+	if(request != NULL)
+	{
+		g_object_ref(request);
+		m_requests.insert(request);
+	}
+}
+
+void Gobby::OperationSubscribeDirectory::show_document(
+	const InfBrowserIter* iter, InfSessionProxy* proxy)
+{
+	InfSession* session;
+	g_object_get(G_OBJECT(proxy), "session", &session, NULL);
+
+	// If somebody else made the request, then they might have shown
+	// the document already.
+	if(get_folder_manager().lookup_document(session) == NULL)
+	{
+		get_folder_manager().add_background_document(
+			m_browser, iter, proxy);
+	}
+
+	// Only count documents that actually made it into a folder
+	if(get_folder_manager().lookup_document(session) != NULL)
+		++m_n_subscribed;
+
+	g_object_unref(session);
+}
+
+void Gobby::OperationSubscribeDirectory::request_finished(
+	InfRequest* request, const GError* error)
+{
+	if(error != NULL)
+	{
+		++m_n_failed;
+		m_last_error = error->message;
+	}
+
+	RequestSet::iterator iter = m_requests.find(request);
+	if(iter != m_requests.end())
+	{
+		g_signal_handlers_disconnect_by_func(
+			G_OBJECT(request),
+			(gpointer)G_CALLBACK(on_explore_finished_static),
+			this);
+		g_signal_handlers_disconnect_by_func(
+			G_OBJECT(request),
+			(gpointer)G_CALLBACK(on_subscribe_finished_static),
+			this);
+		g_object_unref(request);
+		m_requests.erase(iter);
+	}
+
+	g_assert(m_n_running > 0);
+	--m_n_running;
+
+	// Requests on local directories finish right away, in which case
+	// the loop in process() goes on by itself.
+	if(!m_processing)
+		process();
+}
+
+void Gobby::OperationSubscribeDirectory::process()
+{
+	m_processing = true;
+
+	// Subscribe to the documents that we know of before exploring
+	// further, so that the first documents show up early.
+	while(m_n_running < MAX_RUNNING_REQUESTS &&
+	      (!m_documents.empty() || !m_directories.empty()))
+	{
+		if(!m_documents.empty())
+		{
+			const Node node = m_documents.front();
+			m_documents.pop_front();
+			subscribe(node);
+		}
+		else
+		{
+			const Node node = m_directories.front();
+			m_directories.pop_front();
+			explore(node);
+		}
+	}
+
+	m_processing = false;
+
+	if(m_n_running > 0) return;
+
+	if(m_n_failed > 0)
+	{
+		get_status_bar().add_error_message(
+			Glib::ustring::compose(
+				_("Could not subscribe to all documents "
+				  "in \"%1\""), m_name),
+			m_last_error);
+	}
+
+	if(m_n_subscribed > 0 || m_n_failed == 0)
+		finish();
+	else
+		fail();
+}
@@ -0,0 +1,148 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_OPERATIONS_OPERATIONSUBSCRIBEDIRECTORY_HPP_
+#define _GOBBY_OPERATIONS_OPERATIONSUBSCRIBEDIRECTORY_HPP_
+
+#include "operations/operations.hpp"
+
+#include <libinfinity/common/inf-request-result.h>
+
+#include <list>
+#include <set>
+#include <string>
+
+namespace Gobby
+{
+
+// Explores a directory recursively and subscribes to all documents in it.
+// The documents are opened in the background, without switching to them.
+// Only a few requests are made at a time, so that large trees do not flood
+// the server.
+class OperationSubscribeDirectory: public Operations::Operation
+{
+public:
+	OperationSubscribeDirectory(Operations& operations,
+	                            InfBrowser* browser,
+	                            const InfBrowserIter* iter);
+
+	virtual ~OperationSubscribeDirectory();
+
+	virtual void start();
+
+protected:
+	static void on_explore_finished_static(InfRequest* request,
+	                                       const InfRequestResult* result,
+	                                       const GError* error,
+	                                       gpointer user_data)
+	{
+		const InfBrowserIter* iter = NULL;
+		if(error == NULL)
+		{
+			inf_request_result_get_explore_node(
+				result, NULL, &iter);
+		}
+
+		static_cast<OperationSubscribeDirectory*>(user_data)->
+			on_explore_finished(request, iter, error);
+	}
+
+	static void on_subscribe_finished_static(InfRequest* request,
+	                                         const InfRequestResult* res,
+	                                         const GError* error,
+	                                         gpointer user_data)
+	{
+		const InfBrowserIter* iter = NULL;
+		if(error == NULL)
+		{
+			inf_request_result_get_subscribe_session(
+				res, NULL, &iter, NULL);
+		}
+
+		static_cast<OperationSubscribeDirectory*>(user_data)->
+			on_subscribe_finished(request, iter, error);
+	}
+
+	static void on_node_removed_static(InfBrowser* browser,
+	                                   InfBrowserIter* iter,
+	                                   InfRequest* request,
+	                                   gpointer user_data)
+	{
+		static_cast<OperationSubscribeDirectory*>(user_data)->
+			on_node_removed(iter);
+	}
+
+	static void on_notify_status_static(GObject* object,
+	                                    GParamSpec* pspec,
+	                                    gpointer user_data)
+	{
+		static_cast<OperationSubscribeDirectory*>(user_data)->
+			on_notify_status();
+	}
+
+	void on_explore_finished(InfRequest* request,
+	                         const InfBrowserIter* iter,
+	                         const GError* error);
+	void on_subscribe_finished(InfRequest* request,
+	                           const InfBrowserIter* iter,
+	                           const GError* error);
+	void on_node_removed(const InfBrowserIter* iter);
+	void on_notify_status();
+
+private:
+	struct Node
+	{
+		InfBrowserIter iter;
+		std::string path;
+	};
+
+	typedef std::list<Node> NodeList;
+
+	void enqueue_children(const InfBrowserIter* iter);
+	void explore(const Node& node);
+	void subscribe(const Node& node);
+	void show_document(const InfBrowserIter* iter,
+	                   InfSessionProxy* proxy);
+	void request_finished(InfRequest* request, const GError* error);
+	void process();
+
+	InfBrowser* m_browser;
+	const InfBrowserIter m_iter;
+	const Glib::ustring m_name;
+
+	NodeList m_directories;
+	NodeList m_documents;
+
+	// Pending requests. Requests on local directories can finish
+	// before they are returned, so they are counted separately.
+	typedef std::set<InfRequest*> RequestSet;
+	RequestSet m_requests;
+	unsigned int m_n_running;
+	bool m_processing;
+
+	// Number of documents shown, and of requests that failed
+	unsigned int m_n_subscribed;
+	unsigned int m_n_failed;
+	std::string m_last_error;
+
+	gulong m_node_removed_handler;
+	gulong m_notify_status_handler;
+	StatusBar::MessageHandle m_message_handle;
+};
+
+}
+
+#endif // _GOBBY_OPERATIONS_OPERATIONSUBSCRIBEDIRECTORY_HPP_
@@ -20,45 +20,6 @@
 
 namespace
 {
-	std::vector<std::string> split_path(const std::string& path)
-	{
-		std::vector<std::string> result;
-		if(path.empty())
-			return result;
-
-		if(path[0] != '/')
-		{
-			throw std::runtime_error(
-				Glib::ustring::compose(
-					Gobby::_("Invalid path: \"%1\""),
-					path));
-		}
-
-		std::string::size_type prev = 1, pos;
-		while( (pos = path.find('/', prev)) != std::string::npos)
-		{
-			std::string component = path.substr(prev, pos - prev);
-			if(component.empty())
-			{
-				throw std::runtime_error(
-					Glib::ustring::compose(
-						Gobby::_("Invalid path "
-						         "component: \"%1\""),
-						component));
-			}
-
-			result.push_back(component);
-			prev = pos + 1;
-		}
-
-		// Trailing '/' is allowed
-		std::string component = path.substr(prev);
-		if(!component.empty())
-			result.push_back(component);
-
-		return result;
-	}
-
 	std::string make_path_string(const std::vector<std::string>& path)
 	{
 		std::string result;
@@ -78,7 +39,7 @@ namespace
 Gobby::OperationSubscribePath::OperationSubscribePath(Operations& operations,
                                                       const std::string& uri):
 	Operation(operations), m_browser(NULL), m_target(uri),
-	m_request(NULL), m_notify_status_id(0),
+	m_request(NULL), m_notify_status_id(0), m_node_added_id(0),
 	m_message_handle(get_status_bar().invalid_handle())
 {
 }
@@ -87,7 +48,7 @@ Gobby::OperationSubscribePath::OperationSubscribePath(Operations& operations,
                                                       InfBrowser* inf_browser,
                                                       const std::string& p):
 	Operation(operations), m_browser(inf_browser), m_target(p),
-	m_request(NULL), m_notify_status_id(0),
+	m_request(NULL), m_notify_status_id(0), m_node_added_id(0),
 	m_message_handle(get_status_bar().invalid_handle())
 {
 	g_object_weak_ref(G_OBJECT(m_browser),
@@ -111,6 +72,8 @@ Gobby::OperationSubscribePath::~OperationSubscribePath()
 
 	if(m_notify_status_id != 0)
 		g_signal_handler_disconnect(m_browser, m_notify_status_id);
+	if(m_node_added_id != 0)
+		g_signal_handler_disconnect(m_browser, m_node_added_id);
 
 	if(m_message_handle != get_status_bar().invalid_handle())
 		get_status_bar().remove_message(m_message_handle);
@@ -364,42 +327,64 @@ void Gobby::OperationSubscribePath::make_explore_request()
 {
 	g_assert(m_request == NULL);
 
-	m_request = inf_browser_get_pending_request(
+	InfRequest* request = inf_browser_get_pending_request(
 		m_browser, &m_path_iter, "explore-node");
 
-	if(m_request == NULL)
+	if(request == NULL)
 	{
-		m_request = inf_browser_explore(
+		request = inf_browser_explore(
 			m_browser, &m_path_iter,
 			on_explore_finished_static, this);
+
+		// Local directories are explored synchronously. In that
+		// case on_explore_finished() has run already, and it might
+		// have finished the operation, so we must not touch this
+		// anymore.
+		if(request == NULL) return;
 	}
 	else
 	{
 		g_signal_connect(
-			G_OBJECT(m_request), "finished",
+			G_OBJECT(request), "finished",
 			G_CALLBACK(on_explore_finished_static), this);
 	}
+
+	m_request = request;
+
+	// The server sends the children one by one, so we can go on as soon
+	// as the one we are looking for shows up, instead of waiting for the
+	// whole directory.
+	m_node_added_id = g_signal_connect(
+		G_OBJECT(m_browser), "node-added",
+		G_CALLBACK(on_node_added_static), this);
 }
 
 void Gobby::OperationSubscribePath::make_subscribe_request()
 {
 	g_assert(m_request == NULL);
 
-	m_request = inf_browser_get_pending_request(
+	InfRequest* request = inf_browser_get_pending_request(
 		m_browser, &m_path_iter, "subscribe-session");
 
-	if(m_request == NULL)
+	if(request == NULL)
 	{
-		m_request = inf_browser_subscribe(
+		request = inf_browser_subscribe(
 			m_browser, &m_path_iter,
 			on_subscribe_finished_static, this);
+
+		// Documents of the local directory are subscribed to
+		// synchronously, in which case on_subscribe_finished() has
+		// finished the operation already.
+		if(request == NULL) return;
 	}
 	else
 	{
 		g_signal_connect(
-			G_OBJECT(m_request), "finished",
+			G_OBJECT(request), "finished",
 			G_CALLBACK(on_subscribe_finished_static), this);
 	}
+
+	m_request = request;
 }
 
 void Gobby::OperationSubscribePath::on_notify_status()
@@ -435,16 +420,47 @@ void Gobby::OperationSubscribePath::on_browser_deleted()
 {
 	m_browser = NULL;
 	m_notify_status_id = 0;
+	m_node_added_id = 0;
 
 	// Don't set an error message, the user will already be
 	// notified by the closed browser.
 	fail();
 }
 
+void Gobby::OperationSubscribePath::on_node_added(const InfBrowserIter* iter)
+{
+	InfBrowserIter parent = *iter;
+	if(!inf_browser_get_parent(m_browser, &parent)) return;
+	if(parent.node_id != m_path_iter.node_id) return;
+
+	if(m_path[m_path_index] != inf_browser_get_node_name(m_browser, iter))
+		return;
+
+	// Stop waiting for the rest of the directory. The request goes on
+	// without us.
+	g_signal_handler_disconnect(m_browser, m_node_added_id);
+	m_node_added_id = 0;
+
+	g_signal_handlers_disconnect_by_func(
+		G_OBJECT(m_request),
+		(gpointer)G_CALLBACK(on_explore_finished_static), this);
+	m_request = NULL;
+
+	m_path_iter = *iter;
+	++m_path_index;
+	explore();
+}
+
 void Gobby::OperationSubscribePath::on_explore_finished(const GError* error)
 {
 	m_request = NULL;
 
+	if(m_node_added_id != 0)
+	{
+		g_signal_handler_disconnect(m_browser, m_node_added_id);
+		m_node_added_id = 0;
+	}
+
 	if(error != NULL)
 	{
 		get_status_bar().add_error_message(
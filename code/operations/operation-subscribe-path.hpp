@@ -63,6 +63,15 @@ private:
 			on_browser_deleted();
 	}
 
+	static void on_node_added_static(InfBrowser* browser,
+	                                 InfBrowserIter* iter,
+	                                 InfRequest* request,
+	                                 gpointer user_data)
+	{
+		static_cast<OperationSubscribePath*>(user_data)->
+			on_node_added(iter);
+	}
+
 	static void on_explore_finished_static(InfRequest* request,
 	                                       const InfRequestResult* result,
 	                                       const GError* error,
@@ -91,6 +100,7 @@ private:
 
 	void on_notify_status();
 	void on_browser_deleted();
+	void on_node_added(const InfBrowserIter* iter);
 	void on_explore_finished(const GError* error);
 	void on_subscribe_finished(const InfBrowserIter* iter,
 	                           const GError* error);
@@ -104,6 +114,7 @@ private:
 
 	InfRequest* m_request;
 	gulong m_notify_status_id;
+	gulong m_node_added_id;
 
 	StatusBar::MessageHandle m_message_handle;
 };
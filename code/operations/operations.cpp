@@ -20,6 +20,7 @@
 #include "operations/operation-save.hpp"
 #include "operations/operation-delete.hpp"
 #include "operations/operation-subscribe-path.hpp"
+#include "operations/operation-subscribe-directory.hpp"
 #include "operations/operation-export-html.hpp"
 
 #include "operations/operations.hpp"
@@ -153,6 +154,17 @@ Gobby::Operations::subscribe_path(InfBrowser* browser,
 	return check_operation(op);
 }
 
+Gobby::OperationSubscribeDirectory*
+Gobby::Operations::subscribe_directory(InfBrowser* browser,
+                                       const InfBrowserIter* iter)
+{
+	OperationSubscribeDirectory* op =
+		new OperationSubscribeDirectory(*this, browser, iter);
+	m_operations.insert(op);
+	op->start();
+	return check_operation(op);
+}
+
 Gobby::OperationExportHtml*
 Gobby::Operations::export_html(TextSessionView& view,
                                const Glib::RefPtr<Gio::File>& file)
@@ -39,6 +39,7 @@ class OperationOpenMultiple;
 class OperationSave;
 class OperationDelete;
 class OperationSubscribePath;
+class OperationSubscribeDirectory;
 class OperationExportHtml;
 
 class Operations: public sigc::trackable
@@ -139,6 +140,10 @@ public:
 	OperationSubscribePath* subscribe_path(InfBrowser* browser,
 	                                       const std::string& path);
 
+	// Subscribes to all documents below iter, in the background
+	OperationSubscribeDirectory* subscribe_directory(
+		InfBrowser* browser, const InfBrowserIter* iter);
+
 	OperationExportHtml* export_html(TextSessionView& view,
 	                                 const Glib::RefPtr<Gio::File>& file);
 
@@ -1,3 +1,4 @@
+N_("New _Window");
 N_("_Preferences");
 N_("Help");
 N_("About");
@@ -6,10 +7,12 @@ N_("_File");
 N_("_New...");
 N_("_Open...");
 N_("Open _Location...");
+N_("_Quick Open...");
 N_("_Save");
 N_("Save _As...");
 N_("Save All");
 N_("Export As _HTML...");
+N_("_Record Session");
 N_("Connect _To Server...");
 N_("_Close");
 N_("_Edit");
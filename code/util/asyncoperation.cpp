@@ -16,10 +16,10 @@
 
 #include "util/asyncoperation.hpp"
 
-#include <glibmm/main.h>
+#include <sigc++/adaptors/bind.h>
+#include <sigc++/functors/ptr_fun.h>
 
 #include <cassert>
-#include <cstdio>
 
 Gobby::AsyncOperation::Handle::Handle(AsyncOperation& operation):
 	m_operation(&operation)
@@ -43,10 +43,11 @@ void Gobby::AsyncOperation::Handle::cancel()
 	assert(m_operation->m_finished == false);
 
 	m_operation->m_finished = true;
+	m_operation->m_token->cancel();
 }
 
 Gobby::AsyncOperation::AsyncOperation():
-	m_thread(NULL), m_handle(NULL), m_finished(false)
+	m_handle(NULL), m_finished(false)
 {
 }
 
@@ -56,46 +57,35 @@ Gobby::AsyncOperation::~AsyncOperation()
 		m_handle->m_operation = NULL;
 }
 
-std::unique_ptr<Gobby::AsyncOperation::Handle> 
-Gobby::AsyncOperation::start(std::unique_ptr<AsyncOperation> operation)
+std::unique_ptr<Gobby::AsyncOperation::Handle>
+Gobby::AsyncOperation::start(std::unique_ptr<AsyncOperation> operation,
+                             WorkerPool::Priority priority)
 {
-	assert(operation->m_thread == NULL);
 	assert(operation->m_handle == NULL);
+	assert(operation->m_token.get() == NULL);
 	assert(operation->m_finished == false);
 
-	AsyncOperation* op = operation.release();
+	// The worker pool owns the operation from now on, and releases it
+	// in the main thread after it has completed or was cancelled.
+	std::shared_ptr<AsyncOperation> op(operation.release());
 
 	std::unique_ptr<Handle> handle(new Handle(*op));
 	op->m_handle = handle.get();
 
-	op->m_thread = Glib::Thread::create(
-		sigc::mem_fun(*op, &AsyncOperation::thread_run), true);
+	op->m_token = WorkerPool::get_default().push(
+		sigc::bind(sigc::ptr_fun(&AsyncOperation::run_static), op),
+		sigc::bind(sigc::ptr_fun(&AsyncOperation::done_static), op),
+		priority);
 
 	return handle;
 }
 
-void Gobby::AsyncOperation::thread_run()
+void Gobby::AsyncOperation::done()
 {
-	run();
+	// m_handle DTOR cancels the operation
+	g_assert(!m_finished);
+	g_assert(m_handle != NULL);
 
-	Glib::signal_idle().connect(
-		sigc::mem_fun(*this, &AsyncOperation::done));
-}
-
-bool Gobby::AsyncOperation::done()
-{
-	if(!m_finished)
-	{
-		// m_handle DTOR cancels the operation
-		g_assert(m_handle != NULL);
-
-		m_finished = true;
-		finish();
-	}
-
-	if(m_handle)
-		m_handle->m_operation = NULL;
-	delete this;
-
-	return false;
+	m_finished = true;
+	finish();
 }
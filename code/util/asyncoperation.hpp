@@ -17,13 +17,16 @@
 #ifndef _GOBBY_ASYNC_OPERATION_HPP_
 #define _GOBBY_ASYNC_OPERATION_HPP_
 
-#include <glibmm/thread.h>
+#include "util/workerpool.hpp"
 
 #include <memory>
 
 namespace Gobby
 {
 
+// An operation which runs in the default worker pool. run() is called on a
+// worker thread, and finish() in the main thread afterwards, unless the
+// operation has been cancelled by then.
 class AsyncOperation
 {
 public:
@@ -43,7 +46,8 @@ public:
 	virtual ~AsyncOperation();
 
 	static std::unique_ptr<Handle>
-	start(std::unique_ptr<AsyncOperation> operation);
+	start(std::unique_ptr<AsyncOperation> operation,
+	      WorkerPool::Priority priority = WorkerPool::PRIORITY_DEFAULT);
 
 protected:
 	virtual void run() = 0;
@@ -52,14 +56,24 @@ protected:
 	const Handle* get_handle() const { return m_handle; }
 
 private:
-	void thread_run();
-	bool done();
+	static void run_static(const WorkerPool::Token& token,
+	                       std::shared_ptr<AsyncOperation> operation)
+	{
+		operation->run();
+	}
+
+	static void done_static(std::shared_ptr<AsyncOperation> operation)
+	{
+		operation->done();
+	}
+
+	void done();
 
-	Glib::Thread* m_thread;
 	Handle* m_handle;
+	WorkerPool::TokenPtr m_token;
 	bool m_finished;
 };
 
 }
-	
+
 #endif // _GOBBY_ASYNC_OPERATION_HPP_
@@ -19,6 +19,8 @@
 #include <giomm/file.h>
 #include <giomm/asyncresult.h>
 
+#include <glib/gstdio.h>
+
 namespace
 {
 	Glib::ustring strip(const Glib::ustring& string)
@@ -76,6 +78,14 @@ Gobby::History::Loader::Loader(History& history):
 
 void Gobby::History::Loader::close()
 {
+	// Move the history into the state store, if we have one
+	if(m_history.m_store != NULL)
+	{
+		m_history.save();
+		g_unlink(m_history.m_history_file.c_str());
+		m_history.m_history_file.clear();
+	}
+
 	m_history.m_loader.reset(NULL);
 }
 
@@ -180,19 +190,53 @@ Gobby::History::History(const std::string& history_file, unsigned int length):
 	m_history(Gtk::ListStore::create(m_history_columns)),
 	m_current(m_history->children().end()),
 	m_history_file(history_file),
+	m_store(NULL),
 	m_loader(new Loader(*this))
 {
 }
 
+Gobby::History::History(StateStore& store, const std::string& section,
+                        const std::string& legacy_file, unsigned int length):
+	m_length(length),
+	m_history(Gtk::ListStore::create(m_history_columns)),
+	m_current(m_history->children().end()),
+	m_store(&store),
+	m_store_section(section)
+{
+	if(m_store->has_section(m_store_section))
+	{
+		const StateStore::Section& entries =
+			m_store->get_section(m_store_section);
+		for(StateStore::Section::const_iterator iter =
+			entries.begin();
+		    iter != entries.end() &&
+		    m_history->children().size() < m_length;
+		    ++ iter)
+		{
+			Gtk::TreeIter tree_iter = m_history->append();
+			(*tree_iter)[m_history_columns.text] = iter->second;
+		}
+	}
+	else
+	{
+		m_history_file = legacy_file;
+		m_loader.reset(new Loader(*this));
+	}
+}
+
 Gobby::History::History(unsigned int length):
 	m_length(length),
 	m_history(Gtk::ListStore::create(m_history_columns)),
-	m_current(m_history->children().end())
+	m_current(m_history->children().end()),
+	m_store(NULL)
 {
 }
 
 Gobby::History::~History()
 {
+	// The state store is always up to date
+	if(m_store != NULL) return;
+
 	try
 	{
 		if(!m_history_file.empty())
@@ -324,6 +368,29 @@ void Gobby::History::commit_noscroll(const Glib::ustring& str)
 
 		m_history->erase(iter);
 	}
+
+	save();
+}
+
+// Writes the history into the state store. The entries are stored with
+// their position as key, so that they are read back in the same order.
+void Gobby::History::save()
+{
+	if(m_store == NULL) return;
+
+	m_store->clear(m_store_section);
+
+	unsigned int index = 0;
+	const Gtk::TreeNodeChildren& children = m_history->children();
+	for(Gtk::TreeIter iter = children.begin();
+	    iter != children.end(); ++ iter)
+	{
+		gchar key[16];
+		g_snprintf(key, sizeof(key), "%03u", index++);
+
+		const Glib::ustring& str = (*iter)[m_history_columns.text];
+		m_store->set(m_store_section, key, str);
+	}
 }
 
 Gobby::HistoryEntry::HistoryEntry(const std::string& history_file,
@@ -397,6 +464,21 @@ Gobby::HistoryComboBox::HistoryComboBox(const std::string& history_file,
 		false);
 }
 
+Gobby::HistoryComboBox::HistoryComboBox(StateStore& store,
+                                        const std::string& section,
+                                        const std::string& legacy_file,
+                                        unsigned int length):
+	Gtk::ComboBox(true), m_history(store, section, legacy_file, length)
+{
+	set_model(m_history.get_store());
+	set_entry_text_column(m_history.get_columns().text);
+
+	get_entry()->signal_key_press_event().connect(
+		sigc::mem_fun(
+			*this, &HistoryComboBox::on_entry_key_press_event),
+		false);
+}
+
 Gobby::HistoryComboBox::HistoryComboBox(unsigned int length):
 	Gtk::ComboBox(true), m_history(length)
 {
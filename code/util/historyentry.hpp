@@ -17,6 +17,8 @@
 #ifndef _GOBBY_HISTORYENTRY_HPP_
 #define _GOBBY_HISTORYENTRY_HPP_
 
+#include "util/statestore.hpp"
+
 #include <gtkmm/entry.h>
 #include <gtkmm/treemodel.h>
 #include <gtkmm/liststore.h>
@@ -39,6 +41,10 @@ public:
   };
 
   History(const std::string& history_file, unsigned int length);
+  // Keeps the history in the given section of the state store. If the
+  // section does not exist yet, the history is imported from legacy_file.
+  History(StateStore& store, const std::string& section,
+          const std::string& legacy_file, unsigned int length);
   History(unsigned int length);
   ~History();
 
@@ -51,6 +57,7 @@ public:
 
 protected:
   void commit_noscroll(const Glib::ustring& str);
+  void save();
 
   const unsigned int m_length;
 
@@ -59,6 +66,9 @@ protected:
   Gtk::TreeIter m_current;
   std::string m_history_file;
 
+  StateStore* m_store;
+  std::string m_store_section;
+
 private:
   class Loader;
   std::unique_ptr<Loader> m_loader;
@@ -83,6 +93,7 @@ class HistoryComboBox: public Gtk::ComboBox
 public:
   HistoryComboBox(const Glib::RefPtr<Gtk::Builder>& builder, const char* id, const std::string& history_file, unsigned int length);
   HistoryComboBox(const std::string& history_file, unsigned int length);
+  HistoryComboBox(StateStore& store, const std::string& section, const std::string& legacy_file, unsigned int length);
   HistoryComboBox(unsigned int length);
 
   void commit();
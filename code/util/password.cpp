@@ -0,0 +1,39 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "util/password.hpp"
+
+#include <cstring>
+
+bool Gobby::check_password(const std::string& correct_password,
+                           const char* password)
+{
+	/* length-independent string compare */
+	char cmp = 0;
+	const std::string::size_type password_len = std::strlen(password);
+	for(std::string::size_type i = 0; i < correct_password.size(); ++i)
+	{
+		if(i < password_len)
+			cmp |= (password[i] ^ correct_password[i]);
+		else
+			cmp |= (0x00 ^ correct_password[i]);
+	}
+
+	if(password_len != correct_password.size())
+		cmp = 0xFF;
+
+	return cmp == 0;
+}
@@ -0,0 +1,503 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "util/recordwriter.hpp"
+#include "util/file.hpp"
+
+#include <giomm/file.h>
+#include <giomm/converteroutputstream.h>
+#include <giomm/zlibcompressor.h>
+#include <glibmm/datetime.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/main.h>
+#include <glibmm/miscutils.h>
+
+#include <glib/gstdio.h>
+
+#include <libxml/xmlIO.h>
+#include <libxml/parser.h>
+
+#include <algorithm>
+#include <iostream> // For std::cerr
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstring>
+
+namespace
+{
+	const char URI_PREFIX[] = "gobby-record:";
+	const char RECORD_SUFFIX[] = ".record.xml.gz";
+
+	// Wake up the writer thread once this much data is buffered...
+	const std::string::size_type FLUSH_THRESHOLD = 64 * 1024;
+	// ...or after this many seconds, whichever comes first.
+	const unsigned int FLUSH_INTERVAL = 2;
+
+	// URIs handed out by RecordWriter::open() that libxml2 has not
+	// opened yet. Only accessed from the main thread.
+	typedef std::map<std::string, Gobby::RecordWriter*> PendingMap;
+	PendingMap pending_uris;
+	unsigned int next_uri_id = 0;
+
+	struct RecordFile
+	{
+		std::string path;
+		time_t mtime;
+
+		bool operator<(const RecordFile& other) const
+		{
+			return mtime < other.mtime;
+		}
+	};
+}
+
+class Gobby::RecordWriter::Sink
+{
+public:
+	Sink(RecordWriter& writer, const std::string& uri,
+	     const std::string& filename):
+		writer(writer), uri(uri), filename(filename),
+		closed(false), discard(false), file_size(0),
+		full(false), failed(false) {}
+
+	RecordWriter& writer;
+	const std::string uri;
+	const std::string filename;
+
+	// Protected by the writer's mutex
+	std::string buffer;
+	bool closed;
+	bool discard;
+	goffset file_size;
+
+	// Only accessed by the main thread
+	bool full;
+
+	// Only accessed by the writer thread
+	bool failed;
+	Glib::RefPtr<Gio::FileOutputStream> file_stream;
+	Glib::RefPtr<Gio::OutputStream> stream;
+};
+
+Gobby::RecordWriter::RecordWriter(const std::string& directory):
+	m_directory(directory), m_thread(NULL), m_pending(0),
+	m_close_pending(false), m_quit(false),
+	m_max_size(16 * 1024 * 1024), m_max_files(64)
+{
+	static bool callbacks_registered = false;
+	if(!callbacks_registered)
+	{
+		// Make sure the default handlers are registered first,
+		// otherwise they would take precedence over ours since
+		// libxml2 tries the handlers in reverse order.
+		xmlInitParser();
+		xmlRegisterDefaultOutputCallbacks();
+		xmlRegisterOutputCallbacks(on_xml_match, on_xml_open,
+		                           on_xml_write, on_xml_close);
+		callbacks_registered = true;
+	}
+}
+
+Gobby::RecordWriter::~RecordWriter()
+{
+	if(m_thread != NULL)
+	{
+		{
+			Glib::Threads::Mutex::Lock lock(m_mutex);
+			m_quit = true;
+			m_cond.signal();
+		}
+
+		// Writes out whatever is still buffered
+		m_thread->join();
+	}
+
+	m_full_idle_connection.disconnect();
+
+	for(PendingMap::iterator iter = pending_uris.begin();
+	    iter != pending_uris.end(); )
+	{
+		if(iter->second == this)
+			pending_uris.erase(iter++);
+		else
+			++iter;
+	}
+}
+
+void Gobby::RecordWriter::set_max_size(unsigned int max_size)
+{
+	Glib::Threads::Mutex::Lock lock(m_mutex);
+	m_max_size = max_size;
+}
+
+void Gobby::RecordWriter::set_max_files(unsigned int max_files)
+{
+	Glib::Threads::Mutex::Lock lock(m_mutex);
+	m_max_files = max_files;
+}
+
+std::string Gobby::RecordWriter::open(const std::string& basename)
+{
+	std::stringstream uri_stream;
+	uri_stream << URI_PREFIX << (next_uri_id++) << "/" << basename;
+	const std::string uri = uri_stream.str();
+
+	pending_uris[uri] = this;
+	return uri;
+}
+
+void Gobby::RecordWriter::forget(const std::string& uri)
+{
+	pending_uris.erase(uri);
+}
+
+int Gobby::RecordWriter::on_xml_match(const char* uri)
+{
+	return pending_uris.find(uri) != pending_uris.end();
+}
+
+void* Gobby::RecordWriter::on_xml_open(const char* uri)
+{
+	PendingMap::iterator iter = pending_uris.find(uri);
+	if(iter == pending_uris.end()) return NULL;
+
+	RecordWriter& writer = *iter->second;
+	pending_uris.erase(iter);
+
+	const char* basename = std::strchr(uri + sizeof(URI_PREFIX) - 1, '/');
+	g_assert(basename != NULL);
+
+	const std::string timestamp =
+		Glib::DateTime::create_now_local().format("%Y%m%d-%H%M%S");
+
+	std::string filename = Glib::build_filename(
+		writer.m_directory,
+		std::string(basename + 1) + "-" + timestamp + RECORD_SUFFIX);
+
+	Glib::Threads::Mutex::Lock lock(writer.m_mutex);
+
+	// Don't clash with a record of the same document that was started
+	// within the same second.
+	for(unsigned int n = 2; ; ++n)
+	{
+		bool in_use = false;
+		for(SinkList::const_iterator sink_iter =
+			writer.m_sinks.begin();
+		    sink_iter != writer.m_sinks.end(); ++sink_iter)
+		{
+			if((*sink_iter)->filename == filename)
+				in_use = true;
+		}
+
+		if(!in_use) break;
+
+		std::stringstream stream;
+		stream << basename + 1 << "-" << timestamp << "-" << n
+		       << RECORD_SUFFIX;
+		filename = Glib::build_filename(
+			writer.m_directory, stream.str());
+	}
+
+	Sink* sink = new Sink(writer, uri, filename);
+	writer.m_sinks.push_back(sink);
+
+	// The writer thread does not wake up by itself while there are no
+	// sinks, so let it know that there is one now.
+	if(writer.m_thread == NULL)
+	{
+		writer.m_thread = Glib::Threads::Thread::create(
+			sigc::mem_fun(writer, &RecordWriter::thread_run));
+	}
+	else
+	{
+		writer.m_cond.signal();
+	}
+
+	return sink;
+}
+
+int Gobby::RecordWriter::on_xml_write(void* context, const char* buffer,
+                                      int len)
+{
+	Sink* sink = static_cast<Sink*>(context);
+	RecordWriter& writer = sink->writer;
+
+	Glib::Threads::Mutex::Lock lock(writer.m_mutex);
+	if(!sink->discard)
+	{
+		sink->buffer.append(buffer, len);
+		writer.m_pending += len;
+
+		if(writer.m_pending >= FLUSH_THRESHOLD)
+			writer.m_cond.signal();
+	}
+
+	// The file size lags behind by what is still buffered, which is
+	// fine for a limit. The record is written through libxml2 at this
+	// point, so let its owner finish it later.
+	if(!sink->full &&
+	   sink->file_size >= static_cast<goffset>(writer.m_max_size))
+	{
+		sink->full = true;
+		writer.m_full_uris.push_back(sink->uri);
+
+		if(!writer.m_full_idle_connection.connected())
+		{
+			writer.m_full_idle_connection =
+				Glib::signal_idle().connect(sigc::mem_fun(
+					writer, &RecordWriter::on_full_idle));
+		}
+	}
+
+	return len;
+}
+
+int Gobby::RecordWriter::on_xml_close(void* context)
+{
+	Sink* sink = static_cast<Sink*>(context);
+	RecordWriter& writer = sink->writer;
+
+	Glib::Threads::Mutex::Lock lock(writer.m_mutex);
+	sink->closed = true;
+	writer.m_close_pending = true;
+	writer.m_cond.signal();
+
+	return 0;
+}
+
+bool Gobby::RecordWriter::on_full_idle()
+{
+	std::vector<std::string> uris;
+	uris.swap(m_full_uris);
+
+	for(std::vector<std::string>::const_iterator iter = uris.begin();
+	    iter != uris.end(); ++iter)
+	{
+		m_signal_record_full.emit(*iter);
+	}
+
+	return false;
+}
+
+void Gobby::RecordWriter::thread_run()
+{
+	struct Work
+	{
+		Sink* sink;
+		std::string data;
+		bool close;
+		bool remove;
+	};
+
+	Glib::Threads::Mutex::Lock lock(m_mutex);
+	for(;;)
+	{
+		const gint64 end_time = g_get_monotonic_time() +
+			FLUSH_INTERVAL * G_TIME_SPAN_SECOND;
+
+		while(!m_quit && !m_close_pending &&
+		      m_pending < FLUSH_THRESHOLD)
+		{
+			// Nothing is buffered without a sink, so sleep until
+			// the next record is opened.
+			if(m_sinks.empty())
+				m_cond.wait(m_mutex);
+			else if(!m_cond.wait_until(m_mutex, end_time))
+				break;
+		}
+
+		// Take over the buffered data, and then write it without
+		// holding the lock, so that the main thread never waits
+		// for the disk.
+		std::vector<Work> work;
+		for(SinkList::iterator iter = m_sinks.begin();
+		    iter != m_sinks.end(); ++iter)
+		{
+			Sink* sink = *iter;
+			if(!sink->buffer.empty() || sink->closed || m_quit)
+			{
+				Work item;
+				item.sink = sink;
+				item.data.swap(sink->buffer);
+				item.close = sink->closed || m_quit;
+				item.remove = sink->closed;
+				work.push_back(item);
+			}
+		}
+
+		const unsigned int max_files = m_max_files;
+		const bool quit = m_quit;
+
+		m_pending = 0;
+		m_close_pending = false;
+
+		lock.release();
+
+		for(std::vector<Work>::iterator iter = work.begin();
+		    iter != work.end(); ++iter)
+		{
+			write_sink(*iter->sink, iter->data, iter->close,
+			           max_files);
+		}
+
+		lock.acquire();
+
+		for(std::vector<Work>::iterator iter = work.begin();
+		    iter != work.end(); ++iter)
+		{
+			if(iter->sink->failed)
+				iter->sink->discard = true;
+			else if(iter->sink->file_stream)
+				iter->sink->file_size =
+					iter->sink->file_stream->tell();
+
+			// libxml2 has released closed sinks, so they are
+			// no longer referenced by anyone but us.
+			if(iter->remove)
+			{
+				m_sinks.remove(iter->sink);
+				delete iter->sink;
+			}
+		}
+
+		if(quit) break;
+	}
+}
+
+void Gobby::RecordWriter::write_sink(Sink& sink, const std::string& data,
+                                     bool close, unsigned int max_files)
+{
+	if(sink.failed) return;
+
+	try
+	{
+		if(!sink.stream && !data.empty())
+			open_sink(sink, max_files);
+
+		// No flush here: On the compressing stream, that would end
+		// the current deflate block every time.
+		if(sink.stream && !data.empty())
+		{
+			gsize bytes_written;
+			sink.stream->write_all(data, bytes_written);
+		}
+
+		if(close && sink.stream)
+		{
+			sink.stream->close();
+			sink.stream.reset();
+			sink.file_stream.reset();
+		}
+	}
+	catch(const Glib::Error& ex)
+	{
+		std::cerr << "Failed to write record '" << sink.filename
+		          << "': " << ex.what() << std::endl;
+
+		sink.stream.reset();
+		sink.file_stream.reset();
+		sink.failed = true;
+	}
+	catch(const std::exception& ex)
+	{
+		std::cerr << "Failed to create record '" << sink.filename
+		          << "': " << ex.what() << std::endl;
+
+		sink.stream.reset();
+		sink.file_stream.reset();
+		sink.failed = true;
+	}
+}
+
+void Gobby::RecordWriter::open_sink(Sink& sink, unsigned int max_files)
+{
+	create_directory_with_parents(m_directory, 0700);
+
+	// The new file is already in m_sinks, so this makes room for it
+	prune(max_files);
+
+	Glib::RefPtr<Gio::File> file =
+		Gio::File::create_for_path(sink.filename);
+
+	sink.file_stream = file->replace(
+		std::string(), false, Gio::FILE_CREATE_PRIVATE);
+	sink.stream = Gio::ConverterOutputStream::create(
+		sink.file_stream,
+		Gio::ZlibCompressor::create(
+			Gio::ZLIB_COMPRESSOR_FORMAT_GZIP, -1));
+}
+
+void Gobby::RecordWriter::prune(unsigned int max_files)
+{
+	std::set<std::string> active;
+	{
+		Glib::Threads::Mutex::Lock lock(m_mutex);
+		for(SinkList::const_iterator iter = m_sinks.begin();
+		    iter != m_sinks.end(); ++iter)
+		{
+			active.insert((*iter)->filename);
+		}
+	}
+
+	std::vector<RecordFile> files;
+
+	try
+	{
+		Glib::Dir dir(m_directory);
+		for(Glib::DirIterator iter = dir.begin();
+		    iter != dir.end(); ++iter)
+		{
+			const std::string name = *iter;
+			// This includes uncompressed records written by
+			// older versions of Gobby.
+			if(name.find(".record.xml") == std::string::npos)
+				continue;
+
+			RecordFile file;
+			file.path = Glib::build_filename(m_directory, name);
+			if(active.find(file.path) != active.end())
+				continue;
+
+			GStatBuf buf;
+			if(g_stat(file.path.c_str(), &buf) != 0)
+				continue;
+
+			file.mtime = buf.st_mtime;
+			files.push_back(file);
+		}
+	}
+	catch(const Glib::FileError& ex)
+	{
+		std::cerr << "Failed to clean up records in '"
+		          << m_directory << "': " << ex.what() << std::endl;
+		return;
+	}
+
+	if(files.size() + active.size() <= max_files)
+		return;
+
+	std::sort(files.begin(), files.end());
+
+	std::vector<RecordFile>::size_type n_remove =
+		files.size() + active.size() - max_files;
+	n_remove = std::min(n_remove, files.size());
+
+	for(std::vector<RecordFile>::size_type i = 0; i < n_remove; ++i)
+		g_unlink(files[i].path.c_str());
+}
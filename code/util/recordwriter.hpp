@@ -0,0 +1,109 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_RECORDWRITER_HPP_
+#define _GOBBY_RECORDWRITER_HPP_
+
+#include <glibmm/threads.h>
+
+#include <sigc++/signal.h>
+#include <sigc++/connection.h>
+
+#include <string>
+#include <list>
+#include <vector>
+
+namespace Gobby
+{
+
+// Writes session records into a directory. InfAdoptedSessionRecord can only
+// write to a filename via libxml2, so the writer registers itself as a
+// libxml2 output handler for URIs returned by open(). Everything written to
+// such a URI is buffered in memory and written gzip-compressed on a
+// background thread, so the main loop never blocks on disk I/O. Every
+// record goes into a new file; the oldest files are removed when there are
+// more than the configured number. When a file reaches the size limit,
+// signal_record_full() asks the owner of the record to finish it and to
+// continue with a new one. The background thread is only started once the
+// first record is opened.
+class RecordWriter
+{
+public:
+	typedef sigc::signal<void, const std::string&> SignalRecordFull;
+
+	RecordWriter(const std::string& directory);
+	// All URIs returned by open() must have been closed by libxml2
+	// before the writer is destroyed.
+	~RecordWriter();
+
+	void set_max_size(unsigned int max_size);
+	void set_max_files(unsigned int max_files);
+
+	// Returns a URI to be passed to libxml2 which writes into a new
+	// record file whose name starts with basename.
+	std::string open(const std::string& basename);
+	// Forgets a URI returned by open() that libxml2 did not open, for
+	// example because the record could not be started.
+	void forget(const std::string& uri);
+
+	// Emitted with the URI of a record whose file has reached the size
+	// limit. The record should be finished, and a new one be started
+	// with a new URI, so that every file contains a complete record.
+	SignalRecordFull signal_record_full() const
+	{
+		return m_signal_record_full;
+	}
+
+private:
+	class Sink;
+
+	static int on_xml_match(const char* uri);
+	static void* on_xml_open(const char* uri);
+	static int on_xml_write(void* context, const char* buffer, int len);
+	static int on_xml_close(void* context);
+
+	bool on_full_idle();
+
+	void thread_run();
+	void write_sink(Sink& sink, const std::string& data, bool close,
+	                unsigned int max_files);
+	void open_sink(Sink& sink, unsigned int max_files);
+	void prune(unsigned int max_files);
+
+	const std::string m_directory;
+
+	Glib::Threads::Thread* m_thread;
+	Glib::Threads::Mutex m_mutex;
+	Glib::Threads::Cond m_cond;
+
+	// Protected by m_mutex:
+	typedef std::list<Sink*> SinkList;
+	SinkList m_sinks;
+	std::string::size_type m_pending;
+	bool m_close_pending;
+	bool m_quit;
+	unsigned int m_max_size;
+	unsigned int m_max_files;
+
+	// Only accessed from the main thread:
+	std::vector<std::string> m_full_uris;
+	sigc::connection m_full_idle_connection;
+	SignalRecordFull m_signal_record_full;
+};
+
+}
+
+#endif // _GOBBY_RECORDWRITER_HPP_
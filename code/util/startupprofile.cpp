@@ -0,0 +1,75 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "util/startupprofile.hpp"
+
+#include <glib.h>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Phase
+	{
+		std::string name;
+		gint64 time;
+	};
+
+	bool profile_enabled = false;
+	gint64 profile_start;
+	std::vector<Phase> profile_phases;
+}
+
+void Gobby::startup_profile_enable()
+{
+	profile_enabled = true;
+	profile_start = g_get_monotonic_time();
+}
+
+void Gobby::startup_profile_mark(const char* phase)
+{
+	if(!profile_enabled) return;
+
+	Phase entry;
+	entry.name = phase;
+	entry.time = g_get_monotonic_time();
+	profile_phases.push_back(entry);
+}
+
+void Gobby::startup_profile_report()
+{
+	if(!profile_enabled) return;
+	profile_enabled = false;
+
+	std::cerr << "Startup profile (ms, total / phase):" << std::endl;
+	std::cerr << std::fixed << std::setprecision(1);
+
+	gint64 prev = profile_start;
+	for(std::vector<Phase>::const_iterator iter = profile_phases.begin();
+	    iter != profile_phases.end(); ++iter)
+	{
+		std::cerr << std::setw(9)
+		          << (iter->time - profile_start) / 1000.0
+		          << std::setw(9) << (iter->time - prev) / 1000.0
+		          << "  " << iter->name << std::endl;
+		prev = iter->time;
+	}
+
+	profile_phases.clear();
+}
@@ -0,0 +1,33 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_STARTUPPROFILE_HPP_
+#define _GOBBY_STARTUPPROFILE_HPP_
+
+namespace Gobby
+{
+	// Startup tracing, enabled with the --profile-startup command line
+	// option. Each call to startup_profile_mark() records the time at
+	// which the given phase has finished, and startup_profile_report()
+	// prints all phases with their durations to stderr. Marks are
+	// ignored when profiling is disabled or after the report has been
+	// printed, so they can stay in the code unconditionally.
+	void startup_profile_enable();
+	void startup_profile_mark(const char* phase);
+	void startup_profile_report();
+}
+
+#endif // _GOBBY_STARTUPPROFILE_HPP_
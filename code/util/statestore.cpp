@@ -0,0 +1,329 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "util/statestore.hpp"
+#include "util/file.hpp"
+
+#include <giomm/file.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/main.h>
+#include <glibmm/miscutils.h>
+#include <glibmm/exception.h>
+
+#include <vector>
+
+namespace
+{
+	// Seconds after a change until it is written to disk
+	const unsigned int FLUSH_DELAY = 3;
+	// The file is rewritten once it has more than this many records,
+	// and more than twice as many records as there are keys.
+	const unsigned int COMPACT_MIN_RECORDS = 256;
+
+	// Records are lines of tab-separated fields, so tabs, newlines and
+	// backslashes within fields are escaped.
+	std::string escape(const std::string& field)
+	{
+		std::string result;
+		for(std::string::size_type i = 0; i < field.length(); ++i)
+		{
+			switch(field[i])
+			{
+			case '\\': result += "\\\\"; break;
+			case '\t': result += "\\t"; break;
+			case '\n': result += "\\n"; break;
+			default: result += field[i]; break;
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<std::string> split_record(const std::string& line)
+	{
+		std::vector<std::string> fields(1);
+		for(std::string::size_type i = 0; i < line.length(); ++i)
+		{
+			if(line[i] == '\t')
+			{
+				fields.push_back(std::string());
+			}
+			else if(line[i] == '\\' && i + 1 < line.length())
+			{
+				++i;
+				switch(line[i])
+				{
+				case 't': fields.back() += '\t'; break;
+				case 'n': fields.back() += '\n'; break;
+				default: fields.back() += line[i]; break;
+				}
+			}
+			else
+			{
+				fields.back() += line[i];
+			}
+		}
+
+		return fields;
+	}
+
+	std::string set_record(const std::string& section,
+	                       const std::string& key,
+	                       const std::string& value)
+	{
+		return "set\t" + escape(section) + "\t" + escape(key) + "\t" +
+			escape(value) + "\n";
+	}
+
+	std::string clear_record(const std::string& section)
+	{
+		return "clear\t" + escape(section) + "\n";
+	}
+}
+
+Gobby::StateStore::StateStore(const std::string& filename):
+	m_filename(filename), m_n_records(0)
+{
+	try
+	{
+		const std::string data = Glib::file_get_contents(m_filename);
+		m_n_records = replay(data);
+
+		// New records would be appended right after a truncated last
+		// record, and be lost together with it the next time the
+		// file is read. Rewrite the file without it.
+		if(!data.empty() && data[data.length() - 1] != '\n')
+			compact();
+	}
+	catch(Glib::FileError& e)
+	{
+		// No state yet
+	}
+}
+
+Gobby::StateStore::~StateStore()
+{
+	m_flush_connection.disconnect();
+	flush();
+}
+
+bool Gobby::StateStore::has_section(const std::string& section) const
+{
+	return m_sections.find(section) != m_sections.end();
+}
+
+const Gobby::StateStore::Section&
+Gobby::StateStore::get_section(const std::string& section) const
+{
+	static const Section empty_section;
+
+	SectionMap::const_iterator iter = m_sections.find(section);
+	if(iter == m_sections.end()) return empty_section;
+	return iter->second;
+}
+
+const std::string* Gobby::StateStore::get(const std::string& section,
+                                          const std::string& key) const
+{
+	SectionMap::const_iterator iter = m_sections.find(section);
+	if(iter == m_sections.end()) return NULL;
+
+	Section::const_iterator key_iter = iter->second.find(key);
+	if(key_iter == iter->second.end()) return NULL;
+	return &key_iter->second;
+}
+
+void Gobby::StateStore::set(const std::string& section,
+                            const std::string& key,
+                            const std::string& value)
+{
+	Section& values = m_sections[section];
+
+	Section::iterator iter = values.find(key);
+	if(iter != values.end() && iter->second == value) return;
+
+	values[key] = value;
+	append(set_record(section, key, value));
+}
+
+void Gobby::StateStore::remove(const std::string& section,
+                               const std::string& key)
+{
+	SectionMap::iterator iter = m_sections.find(section);
+	if(iter == m_sections.end()) return;
+	if(iter->second.erase(key) == 0) return;
+
+	append("remove\t" + escape(section) + "\t" + escape(key) + "\n");
+}
+
+void Gobby::StateStore::clear(const std::string& section)
+{
+	SectionMap::iterator iter = m_sections.find(section);
+	if(iter != m_sections.end() && iter->second.empty()) return;
+
+	m_sections[section].clear();
+	append(clear_record(section));
+}
+
+void Gobby::StateStore::flush()
+{
+	if(m_pending.empty()) return;
+
+	try
+	{
+		create_directory_with_parents(
+			Glib::path_get_dirname(m_filename), 0700);
+
+		Glib::RefPtr<Gio::FileOutputStream> stream =
+			Gio::File::create_for_path(m_filename)->
+				append_to(Gio::FILE_CREATE_PRIVATE);
+
+		gsize bytes_written;
+		stream->write_all(m_pending, bytes_written);
+		stream->close();
+
+		m_pending.clear();
+	}
+	catch(Glib::Exception& e)
+	{
+		// Keep the records, and try again with the next change
+		g_warning("Could not write state file: %s",
+		          e.what().c_str());
+	}
+	catch(std::exception& e)
+	{
+		g_warning("Could not write state file: %s", e.what());
+	}
+}
+
+unsigned int Gobby::StateStore::replay(const std::string& data)
+{
+	unsigned int n_records = 0;
+
+	std::string::size_type pos = 0;
+	while(pos < data.length())
+	{
+		std::string::size_type end = data.find('\n', pos);
+		// Ignore a truncated last record, for example if we
+		// crashed while writing it.
+		if(end == std::string::npos) break;
+
+		const std::vector<std::string> fields =
+			split_record(data.substr(pos, end - pos));
+		pos = end + 1;
+
+		if(fields[0] == "set" && fields.size() == 4)
+			m_sections[fields[1]][fields[2]] = fields[3];
+		else if(fields[0] == "remove" && fields.size() == 3)
+			m_sections[fields[1]].erase(fields[2]);
+		else if(fields[0] == "clear" && fields.size() == 2)
+			m_sections[fields[1]].clear();
+		else
+			continue;
+
+		++n_records;
+	}
+
+	return n_records;
+}
+
+void Gobby::StateStore::append(const std::string& record)
+{
+	m_pending += record;
+	++m_n_records;
+
+	if(!m_flush_connection.connected())
+	{
+		m_flush_connection = Glib::signal_timeout().connect_seconds(
+			sigc::mem_fun(*this, &StateStore::on_flush_timeout),
+			FLUSH_DELAY);
+	}
+}
+
+bool Gobby::StateStore::on_flush_timeout()
+{
+	unsigned int n_keys = 0;
+	for(SectionMap::const_iterator iter = m_sections.begin();
+	    iter != m_sections.end(); ++iter)
+	{
+		n_keys += iter->second.size();
+	}
+
+	if(m_n_records > COMPACT_MIN_RECORDS && m_n_records > 2 * n_keys)
+		compact();
+	else
+		flush();
+
+	return false;
+}
+
+// Rewrites the file with only the current values. The new file replaces
+// the old one atomically.
+void Gobby::StateStore::compact()
+{
+	std::string data;
+	unsigned int n_records = 0;
+
+	for(SectionMap::const_iterator iter = m_sections.begin();
+	    iter != m_sections.end(); ++iter)
+	{
+		// Keeps empty sections around
+		data += clear_record(iter->first);
+		++n_records;
+
+		for(Section::const_iterator key_iter = iter->second.begin();
+		    key_iter != iter->second.end(); ++key_iter)
+		{
+			data += set_record(iter->first, key_iter->first,
+			                   key_iter->second);
+			++n_records;
+		}
+	}
+
+	try
+	{
+		create_directory_with_parents(
+			Glib::path_get_dirname(m_filename), 0700);
+
+		// The file is written to a temporary file first, which is
+		// then renamed. Like the file itself, it is created private,
+		// since it contains host names and document locations.
+		Glib::RefPtr<Gio::FileOutputStream> stream =
+			Gio::File::create_for_path(m_filename)->replace(
+				std::string(), false,
+				Gio::FILE_CREATE_PRIVATE |
+				Gio::FILE_CREATE_REPLACE_DESTINATION);
+
+		gsize bytes_written;
+		stream->write_all(data, bytes_written);
+		stream->close();
+
+		m_pending.clear();
+		m_n_records = n_records;
+	}
+	catch(Glib::Exception& e)
+	{
+		g_warning("Could not write state file: %s",
+		          e.what().c_str());
+
+		// Fall back to appending the pending records
+		flush();
+	}
+	catch(std::exception& e)
+	{
+		g_warning("Could not write state file: %s", e.what());
+		flush();
+	}
+}
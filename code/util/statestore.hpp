@@ -0,0 +1,87 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef _GOBBY_STATESTORE_HPP_
+#define _GOBBY_STATESTORE_HPP_
+
+#include <sigc++/trackable.h>
+#include <sigc++/connection.h>
+
+#include <map>
+#include <string>
+
+namespace Gobby
+{
+
+// Small key-value store for state that Gobby keeps between runs, such as
+// known hosts, recently used host names and document infos. Keys are
+// grouped into sections. Everything lives in a single file which is read
+// once on construction. Changes are appended to the file as records a few
+// seconds after they have been made, and the file is rewritten with only
+// the current values once it contains too many outdated records. Appending
+// never touches existing records and the rewrite replaces the file
+// atomically, so a crash loses at most the changes of the last few seconds.
+class StateStore: public sigc::trackable
+{
+public:
+	typedef std::map<std::string, std::string> Section;
+
+	StateStore(const std::string& filename);
+	~StateStore();
+
+	// Whether the section has ever been written to. This allows to
+	// tell an empty section apart from one that needs to be migrated
+	// from an older file format.
+	bool has_section(const std::string& section) const;
+
+	// Returns an empty section if it does not exist
+	const Section& get_section(const std::string& section) const;
+
+	// Returns NULL if the key is not set
+	const std::string* get(const std::string& section,
+	                       const std::string& key) const;
+
+	void set(const std::string& section, const std::string& key,
+	         const std::string& value);
+	void remove(const std::string& section, const std::string& key);
+
+	// Removes all keys from the section, but keeps the section itself.
+	void clear(const std::string& section);
+
+	// Writes all pending changes to disk immediately.
+	void flush();
+
+protected:
+	unsigned int replay(const std::string& data);
+
+	void append(const std::string& record);
+	bool on_flush_timeout();
+	void compact();
+
+	const std::string m_filename;
+
+	typedef std::map<std::string, Section> SectionMap;
+	SectionMap m_sections;
+
+	// Records not written to disk yet, and the number of records in
+	// the file including those.
+	std::string m_pending;
+	unsigned int m_n_records;
+	sigc::connection m_flush_connection;
+};
+
+}
+
+#endif // _GOBBY_STATESTORE_HPP_
@@ -116,4 +116,41 @@ void parse_netloc(const std::string& netloc,
 	}
 }
 
+std::vector<std::string> split_path(const std::string& path)
+{
+	std::vector<std::string> result;
+	if(path.empty())
+		return result;
+
+	if(path[0] != '/')
+	{
+		throw std::runtime_error(
+			Glib::ustring::compose(
+				_("Invalid path: \"%1\""), path));
+	}
+
+	std::string::size_type prev = 1, pos;
+	while( (pos = path.find('/', prev)) != std::string::npos)
+	{
+		std::string component = path.substr(prev, pos - prev);
+		if(component.empty())
+		{
+			throw std::runtime_error(
+				Glib::ustring::compose(
+					_("Invalid path component: \"%1\""),
+					component));
+		}
+
+		result.push_back(component);
+		prev = pos + 1;
+	}
+
+	// Trailing '/' is allowed
+	std::string component = path.substr(prev);
+	if(!component.empty())
+		result.push_back(component);
+
+	return result;
+}
+
 } // namespace Gobby
@@ -19,6 +19,9 @@
 
 #include <gdkmm/color.h>
 
+#include <string>
+#include <vector>
+
 namespace Gobby
 {
 	void parse_uri(const std::string& uri,
@@ -30,6 +33,10 @@ namespace Gobby
 	                  std::string& hostname,
 	                  std::string& service,
 	                  unsigned int& device_index);
+
+	// Splits an absolute path into its components. Throws if the
+	// path is not absolute or has empty components.
+	std::vector<std::string> split_path(const std::string& path);
 }
 
 #endif // _GOBBY_URI_HPP_
@@ -0,0 +1,159 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "util/workerpool.hpp"
+
+#include <algorithm>
+
+Gobby::WorkerPool::WorkerPool(unsigned int max_threads):
+	m_max_threads(std::max(max_threads, 1u)), m_n_idle(0), m_idle_id(0),
+	m_quit(false)
+{
+}
+
+Gobby::WorkerPool::~WorkerPool()
+{
+	{
+		Glib::Threads::Mutex::Lock lock(m_mutex);
+		m_quit = true;
+		m_cond.broadcast();
+	}
+
+	for(std::vector<Glib::Threads::Thread*>::iterator iter =
+		m_threads.begin();
+	    iter != m_threads.end(); ++iter)
+	{
+		(*iter)->join();
+	}
+
+	if(m_idle_id != 0)
+		g_source_remove(m_idle_id);
+
+	for(unsigned int i = 0; i <= PRIORITY_HIGH; ++i)
+	{
+		for(std::deque<Job*>::iterator iter = m_queue[i].begin();
+		    iter != m_queue[i].end(); ++iter)
+		{
+			delete *iter;
+		}
+	}
+
+	for(std::deque<Job*>::iterator iter = m_completed.begin();
+	    iter != m_completed.end(); ++iter)
+	{
+		delete *iter;
+	}
+}
+
+Gobby::WorkerPool& Gobby::WorkerPool::get_default()
+{
+	// Keep at least two threads, so that a long-running job such as
+	// the generation of DH parameters does not hold up everything else.
+	static WorkerPool* pool = new WorkerPool(
+		std::max(g_get_num_processors(), 2u));
+	return *pool;
+}
+
+Gobby::WorkerPool::TokenPtr
+Gobby::WorkerPool::push(const SlotWork& work, const SlotDone& done,
+                        Priority priority)
+{
+	Job* job = new Job;
+	job->work = work;
+	job->done = done;
+	job->token.reset(new Token);
+
+	TokenPtr token = job->token;
+
+	Glib::Threads::Mutex::Lock lock(m_mutex);
+	m_queue[priority].push_back(job);
+
+	std::deque<Job*>::size_type n_queued = 0;
+	for(unsigned int i = 0; i <= PRIORITY_HIGH; ++i)
+		n_queued += m_queue[i].size();
+
+	if(m_n_idle > 0)
+		m_cond.signal();
+
+	if(n_queued > m_n_idle && m_threads.size() < m_max_threads)
+	{
+		m_threads.push_back(Glib::Threads::Thread::create(
+			sigc::mem_fun(*this, &WorkerPool::thread_run)));
+	}
+
+	return token;
+}
+
+void Gobby::WorkerPool::thread_run()
+{
+	Glib::Threads::Mutex::Lock lock(m_mutex);
+
+	while(!m_quit)
+	{
+		Job* job = NULL;
+		for(int i = PRIORITY_HIGH; i >= 0 && job == NULL; --i)
+		{
+			if(!m_queue[i].empty())
+			{
+				job = m_queue[i].front();
+				m_queue[i].pop_front();
+			}
+		}
+
+		if(job == NULL)
+		{
+			++m_n_idle;
+			m_cond.wait(m_mutex);
+			--m_n_idle;
+			continue;
+		}
+
+		lock.release();
+		if(!job->token->is_cancelled())
+			job->work(*job->token);
+		lock.acquire();
+
+		// Hand the job back to the main thread, also if it was
+		// cancelled, so that its slots are destroyed there.
+		m_completed.push_back(job);
+		if(m_idle_id == 0)
+			m_idle_id = g_idle_add(on_idle_static, this);
+	}
+}
+
+void Gobby::WorkerPool::on_idle()
+{
+	std::deque<Job*> completed;
+
+	{
+		Glib::Threads::Mutex::Lock lock(m_mutex);
+		completed.swap(m_completed);
+		m_idle_id = 0;
+	}
+
+	for(std::deque<Job*>::iterator iter = completed.begin();
+	    iter != completed.end(); ++iter)
+	{
+		Job* job = *iter;
+
+		// A completion slot can cancel jobs that come later in the
+		// batch, so check the token only right before the call.
+		if(!job->token->is_cancelled())
+			job->done();
+
+		delete job;
+	}
+}
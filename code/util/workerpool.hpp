@@ -0,0 +1,119 @@
+/* Gobby - GTK-based collaborative text editor
+ * Copyright (C) 2008-2015 Armin Burgmeier <armin@arbur.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GOBBY_WORKERPOOL_HPP_
+#define _GOBBY_WORKERPOOL_HPP_
+
+#include <glibmm/threads.h>
+#include <sigc++/slot.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace Gobby
+{
+
+// A bounded set of worker threads which run jobs in the background. Jobs
+// are taken from the queue in order of priority, and FIFO within the same
+// priority. When a job has run, its completion slot is called in the main
+// thread. Completions are collected in a queue that is drained by a single
+// idle handler, so that many jobs finishing at once do not cause one main
+// loop iteration each.
+class WorkerPool
+{
+public:
+	enum Priority {
+		PRIORITY_LOW,
+		PRIORITY_DEFAULT,
+		PRIORITY_HIGH
+	};
+
+	// Allows to cancel a job. A job that is cancelled before it
+	// started does not run at all; one that is already running can
+	// poll is_cancelled() to stop early. The completion slot of a
+	// cancelled job is never called. Both slots of a job are always
+	// destroyed in the main thread.
+	class Token
+	{
+	public:
+		Token(): m_cancelled(0) {}
+
+		void cancel() { g_atomic_int_set(&m_cancelled, 1); }
+
+		bool is_cancelled() const
+			{ return g_atomic_int_get(&m_cancelled) != 0; }
+
+	private:
+		gint m_cancelled;
+	};
+
+	typedef std::shared_ptr<Token> TokenPtr;
+	typedef sigc::slot<void, const Token&> SlotWork;
+	typedef sigc::slot<void> SlotDone;
+
+	// Creates a pool with at most max_threads threads. Threads are
+	// started on demand.
+	WorkerPool(unsigned int max_threads);
+	// Waits for all running jobs to finish. Jobs that have not yet
+	// started are dropped.
+	~WorkerPool();
+
+	// The pool shared by the whole process. Its size depends on the
+	// number of processors. It is never destroyed, so that jobs which
+	// are still running when the program exits do not delay the exit.
+	static WorkerPool& get_default();
+
+	// Schedules work to be run on a worker thread, and done to be run
+	// in the main thread afterwards. Must be called from the main
+	// thread.
+	TokenPtr push(const SlotWork& work, const SlotDone& done,
+	              Priority priority = PRIORITY_DEFAULT);
+
+private:
+	struct Job
+	{
+		SlotWork work;
+		SlotDone done;
+		TokenPtr token;
+	};
+
+	static gboolean on_idle_static(gpointer user_data)
+	{
+		static_cast<WorkerPool*>(user_data)->on_idle();
+		return FALSE;
+	}
+
+	void thread_run();
+	void on_idle();
+
+	const unsigned int m_max_threads;
+
+	Glib::Threads::Mutex m_mutex;
+	Glib::Threads::Cond m_cond;
+
+	// Protected by m_mutex:
+	std::vector<Glib::Threads::Thread*> m_threads;
+	std::deque<Job*> m_queue[PRIORITY_HIGH + 1];
+	std::deque<Job*> m_completed;
+	unsigned int m_n_idle;
+	guint m_idle_id;
+	bool m_quit;
+};
+
+}
+
+#endif // _GOBBY_WORKERPOOL_HPP_
@@ -20,52 +20,58 @@
 #include "commands/file-tasks/task-open.hpp"
 #include "commands/file-tasks/task-open-multiple.hpp"
 
+#include "util/file.hpp"
 #include "util/i18n.hpp"
 
 #include <gtkmm/frame.h>
 
-Gobby::Window::Window(Config& config,
+Gobby::Window::Window(Config& config, StateStore& state_store,
                       GtkSourceLanguageManager* language_manager,
                       FileChooser& file_chooser,
                       Preferences& preferences,
-                      CertificateManager& cert_manager):
+                      CertificateManager& cert_manager,
+                      ConnectionManager& connection_manager,
+                      BrowserStore& browser_store,
+                      DocumentInfoStorage& info_storage,
+                      SessionUsers& session_users,
+                      SessionCache& session_cache,
+                      RecordWriter& record_writer,
+                      bool primary):
 	m_config(config),
+	m_state_store(state_store),
 	m_lang_manager(language_manager),
 	m_file_chooser(file_chooser),
 	m_preferences(preferences), m_cert_manager(cert_manager),
-	m_connection_manager(cert_manager, preferences),
+	m_connection_manager(connection_manager),
 	m_text_folder(false, m_preferences, m_lang_manager),
 	m_chat_folder(true, m_preferences, m_lang_manager),
 	m_statusbar(m_text_folder, m_preferences),
 	m_toolbar(m_preferences),
-	m_browser(*this, m_statusbar, m_connection_manager),
+	m_browser(*this, m_statusbar, browser_store, m_state_store),
 	m_chat_frame(_("Chat"), "chat", m_preferences.appearance.show_chat),
 	m_actions(*this, m_preferences),
-	m_info_storage(INF_GTK_BROWSER_MODEL(m_browser.get_store())),
-	m_host_storage(m_browser),
+	m_info_storage(info_storage),
 	m_folder_manager(m_browser, m_info_storage,
 	                 m_text_folder, m_chat_folder),
 	m_operations(m_info_storage, m_browser,
 	             m_folder_manager, m_statusbar),
-	m_auth_commands(*this, m_browser, m_statusbar,
-	                m_connection_manager, m_preferences),
-	m_self_hoster(m_connection_manager.get_io(),
-	              m_connection_manager.get_communication_manager(),
-	              m_connection_manager.get_publisher(),
-	              m_auth_commands.get_sasl_context(),
-	              m_statusbar, m_cert_manager, m_preferences),
 	m_browser_commands(m_browser, m_folder_manager, m_statusbar,
-	                   m_operations, m_preferences),
-	m_browser_context_commands(*this, m_connection_manager.get_io(),
+	                   m_operations, m_preferences, primary),
+	m_browser_context_commands(*this, m_connection_manager,
 	                           m_browser, m_file_chooser, m_operations,
 	                           m_cert_manager, m_preferences),
+	m_self_hoster_info_handle(m_statusbar.invalid_handle()),
+	m_cert_checker(NULL),
 	m_autosave_commands(m_text_folder, m_operations,
 	                    m_info_storage, m_preferences),
+	m_record_commands(m_actions, m_text_folder, record_writer,
+	                  m_preferences),
 	m_subscription_commands(m_text_folder, m_chat_folder),
 	m_synchronization_commands(m_text_folder, m_chat_folder),
-	m_user_join_commands(m_folder_manager, m_preferences),
-	m_text_folder_commands(m_text_folder),
-	m_chat_folder_commands(m_chat_folder),
+	m_user_join_commands(m_folder_manager, session_users,
+	                     session_cache, m_preferences),
+	m_text_folder_commands(m_text_folder, m_operations, m_preferences),
+	m_chat_folder_commands(m_chat_folder, m_operations, m_preferences),
 	m_file_commands(*this, m_actions, m_browser, m_folder_manager,
 	                m_statusbar, m_file_chooser, m_operations,
 	                m_info_storage, m_preferences),
@@ -79,8 +85,39 @@ Gobby::Window::Window(Config& config,
 	m_chat_frame.signal_hide().connect(
 		sigc::mem_fun(*this, &Window::on_chat_hide), false);
 
-	m_browser.add_browser(INF_BROWSER(m_self_hoster.get_directory()),
-	                      _("This Computer"));
+	if(primary)
+	{
+		m_auth_commands.reset(new AuthCommands(
+			*this, m_browser, m_statusbar,
+			m_connection_manager, m_preferences));
+		m_self_hoster.reset(new SelfHoster(
+			m_connection_manager.get_io(),
+			m_connection_manager.get_communication_manager(),
+			m_connection_manager.get_publisher(),
+			m_auth_commands->get_sasl_context(),
+			m_cert_manager, m_preferences));
+		m_self_hoster->signal_info_changed().connect(
+			sigc::mem_fun(
+				*this, &Window::on_self_hoster_info_changed));
+		m_self_hoster->signal_error().connect(sigc::bind(
+			sigc::mem_fun(
+				m_statusbar, &StatusBar::add_error_message),
+			0));
+
+		m_browser.add_browser(
+			INF_BROWSER(m_self_hoster->get_directory()),
+			_("This Computer"));
+
+		const std::string known_hosts_file =
+			config_filename("known_hosts");
+		m_cert_checker = inf_gtk_certificate_manager_new(
+			gobj(), m_connection_manager.get_xmpp_manager(),
+			known_hosts_file.c_str());
+
+		m_session_restore_commands.reset(new SessionRestoreCommands(
+			m_state_store, m_folder_manager, m_text_folder,
+			m_operations));
+	}
 
 	m_toolbar.show();
 	m_browser.show();
@@ -144,11 +181,23 @@ Gobby::Window::Window(Config& config,
 	set_role("Gobby");
 }
 
+Gobby::Window::~Window()
+{
+	if(m_cert_checker != NULL)
+		g_object_unref(m_cert_checker);
+}
+
 void Gobby::Window::subscribe(const Glib::ustring& uri)
 {
 	m_operations.subscribe_path(uri);
 }
 
+void Gobby::Window::restore_session()
+{
+	if(m_session_restore_commands.get() != NULL)
+		m_session_restore_commands->restore();
+}
+
 void Gobby::Window::open_files(const Operations::file_list& files)
 {
 	if(files.size() == 1)
@@ -195,6 +244,9 @@ void Gobby::Window::on_show()
 {
 	Gtk::Window::on_show();
 
+	// Only the primary window offers the initial setup
+	if(m_self_hoster.get() == NULL) return;
+
 	Glib::RefPtr<Gio::Settings> settings(
 		Gio::Settings::create("de.0x539.gobby.state.initial"));
 
@@ -224,6 +276,22 @@ void Gobby::Window::on_initial_dialog_hide()
 	settings->set_boolean("run", true);
 }
 
+void Gobby::Window::on_self_hoster_info_changed()
+{
+	if(m_self_hoster_info_handle != m_statusbar.invalid_handle())
+	{
+		m_statusbar.remove_message(m_self_hoster_info_handle);
+		m_self_hoster_info_handle = m_statusbar.invalid_handle();
+	}
+
+	const Glib::ustring& info = m_self_hoster->get_info();
+	if(!info.empty())
+	{
+		m_self_hoster_info_handle =
+			m_statusbar.add_info_message(info);
+	}
+}
+
 bool Gobby::Window::on_switch_to_chat()
 {
 	SessionView* view = m_chat_folder.get_current_document();
@@ -32,6 +32,8 @@
 #include "commands/file-commands.hpp"
 #include "commands/edit-commands.hpp"
 #include "commands/view-commands.hpp"
+#include "commands/record-commands.hpp"
+#include "commands/session-restore-commands.hpp"
 #include "operations/operations.hpp"
 
 #include "dialogs/initial-dialog.hpp"
@@ -40,15 +42,20 @@
 #include "core/toolbar.hpp"
 #include "core/folder.hpp"
 #include "core/browser.hpp"
+#include "core/browserstore.hpp"
+#include "core/sessioncache.hpp"
+#include "core/sessionusers.hpp"
 #include "core/statusbar.hpp"
 #include "core/preferences.hpp"
 #include "core/filechooser.hpp"
 #include "core/closableframe.hpp"
 #include "core/titlebar.hpp"
 #include "core/windowactions.hpp"
-#include "core/knownhoststorage.hpp"
 
 #include "util/config.hpp"
+#include "util/statestore.hpp"
+
+#include <libinfgtk/inf-gtk-certificate-manager.h>
 
 #include <gtkmm/applicationwindow.h>
 #include <gtkmm/paned.h>
@@ -62,11 +69,26 @@ namespace Gobby
 class Window : public Gtk::ApplicationWindow
 {
 public:
-	Window(Config& config, GtkSourceLanguageManager* language_manager,
+	// All windows share the connections, the document browser contents
+	// and the sessions. Only the primary window hosts the local
+	// documents, checks server certificates and asks for passwords.
+	Window(Config& config, StateStore& state_store,
+	       GtkSourceLanguageManager* language_manager,
 	       FileChooser& file_chooser, Preferences& preferences,
-	       CertificateManager& cert_manager);
+	       CertificateManager& cert_manager,
+	       ConnectionManager& connection_manager,
+	       BrowserStore& browser_store,
+	       DocumentInfoStorage& info_storage,
+	       SessionUsers& session_users,
+	       SessionCache& session_cache,
+	       RecordWriter& record_writer,
+	       bool primary);
+	~Window();
 
 	void subscribe(const Glib::ustring& uri);
+	// Opens the documents that were open when the primary window was
+	// closed the last time. Does nothing in secondary windows.
+	void restore_session();
 	void open_files(const Operations::file_list& files);
 
 protected:
@@ -77,6 +99,7 @@ protected:
 	virtual void on_show();
 
 	void on_initial_dialog_hide();
+	void on_self_hoster_info_changed();
 
 	static gboolean on_switch_to_chat_static(GtkAccelGroup* group,
 	                                         GObject* acceleratable,
@@ -104,11 +127,12 @@ protected:
 
 	// Config
 	Config& m_config;
+	StateStore& m_state_store;
 	GtkSourceLanguageManager* m_lang_manager;
 	FileChooser& m_file_chooser;
 	Preferences& m_preferences;
 	CertificateManager& m_cert_manager;
-	ConnectionManager m_connection_manager;
+	ConnectionManager& m_connection_manager;
 
 	// GUI
 	Gtk::Grid m_grid;
@@ -124,8 +148,7 @@ protected:
 
 	// Functionality
 	WindowActions m_actions;
-	DocumentInfoStorage m_info_storage;
-	KnownHostStorage m_host_storage;
+	DocumentInfoStorage& m_info_storage;
 	FolderManager m_folder_manager;
 	Operations m_operations;
 
@@ -142,10 +165,14 @@ protected:
 	// This would also get rid of the ugly
 	// connection_manager.set_sasl_context() call, since the connection
 	// manager would then set the SASL context by itself.
-	AuthCommands m_auth_commands;
-	SelfHoster m_self_hoster;
+	// These only exist in the primary window.
+	std::unique_ptr<AuthCommands> m_auth_commands;
+	std::unique_ptr<SelfHoster> m_self_hoster;
+	StatusBar::MessageHandle m_self_hoster_info_handle;
+	InfGtkCertificateManager* m_cert_checker;
 
 	AutosaveCommands m_autosave_commands;
+	RecordCommands m_record_commands;
 	SubscriptionCommands m_subscription_commands;
 	SynchronizationCommands m_synchronization_commands;
 	UserJoinCommands m_user_join_commands;
@@ -158,6 +185,10 @@ protected:
 
 	TitleBar m_title_bar;
 
+	// Only exists in the primary window. This needs to go after the
+	// folders so that it can record the open documents on destruction.
+	std::unique_ptr<SessionRestoreCommands> m_session_restore_commands;
+
 	// Dialogs
 	std::unique_ptr<InitialDialog> m_initial_dlg;
 };